@@ -6,14 +6,6 @@
 
 extern void millisecondTimer(void);
 
-#ifdef USE_DATALOGGING
-	// set up variables using the SD utility library functions:
-	Sd2Card card;
-	SdVolume volume;
-	SdFile root;
-	File testFile;
-#endif
-
 // change this to match your SD shield or module;
 // Arduino Ethernet shield: pin 4
 // Adafruit SD shields and modules: pin 10
@@ -38,11 +30,26 @@ IntervalTimer myTimer;
 // order data flows, inputs/sources -> processing -> outputs
 //
 #define FFT_LEVEL	1	// 1 is fastest
-#ifdef USE_FFT_1024
-	AudioAnalyzeFFT1024  myFFT(FFT_LEVEL);
-#else
-	AudioAnalyzeFFT256  myFFT(FFT_LEVEL);
-#endif
+
+//-------------------------------------------------------------------------------------------------
+// Each analyzer hands its FFTs to frameQueue from update(), which the audio library runs in its
+// interrupt, so a frame is queued even while loop() is busy printing.  loop() takes them from
+// frameQueue and never polls available() itself.
+//-------------------------------------------------------------------------------------------------
+template <class ANALYZER, int BINS>
+class queuedAnalyzeFFT : public ANALYZER {
+public:
+	queuedAnalyzeFFT(uint8_t level) : ANALYZER(level) {}
+	virtual void update(void) {
+		ANALYZER::update();
+		if (ANALYZER::available()) {
+			frameQueuePush(this->output, BINS);
+		}
+	}
+};
+
+queuedAnalyzeFFT<AudioAnalyzeFFT1024, FFT1024_OUTPUT_SIZE>	myFFT1024(FFT_LEVEL);
+queuedAnalyzeFFT<AudioAnalyzeFFT256, FFT256_OUTPUT_SIZE>	myFFT256(FFT_LEVEL);
 
 #ifdef USE_INTERNAL
 	AudioSynthWaveform sine0;
@@ -50,7 +57,10 @@ IntervalTimer myTimer;
 	AudioMixer4        mixer;
 	AudioConnection c1(sine0, 0, mixer, 0);
 	AudioConnection c2(sine1, 0, mixer, 1);
-	AudioConnection c3(mixer, 0, myFFT, 0);
+	AudioConnection c3(mixer, 0, myFFT1024, 0);
+	AudioConnection c4(mixer, 0, myFFT256, 0);
+	#define FFT1024_CONNECTION	c3
+	#define FFT256_CONNECTION	c4
 #else
 	//const int myInput = AUDIO_INPUT_LINEIN;
 	const int myInput = AUDIO_INPUT_MIC;
@@ -60,18 +70,79 @@ IntervalTimer myTimer;
 
 	AudioInputI2S       audioInput;         // audio shield: mic or line-in
 	AudioOutputI2S      audioOutput;        // audio shield: headphones & line-out
-	AudioConnection c1(audioInput, 0, myFFT, 0);
+	AudioConnection c1(audioInput, 0, myFFT1024, 0);
 	AudioConnection c2(audioInput, 0, audioOutput, 0);
 	AudioConnection c3(audioInput, 1, audioOutput, 1);
+	AudioConnection c4(audioInput, 0, myFFT256, 0);
+	#define FFT1024_CONNECTION	c1
+	#define FFT256_CONNECTION	c4
 #endif
 
+//-------------------------------------------------------------------------------------------------
+// FFT size selection - see fftAnalyzer.h
+//
+// The analyzer that isn't selected is unpatched so it takes no audio blocks or processor time.
+// AudioConnection::connect() and disconnect() need Teensyduino 1.57 or later.
+//-------------------------------------------------------------------------------------------------
+const fftAnalyzerType fftAnalyzers[NUMBER_OF_FFT_SIZES] = {
+	// name,	fftSize,	numberOfBins,			fftsPerSecond,	output
+	{"FFT1024",	1024,		FFT1024_OUTPUT_SIZE,	69,				myFFT1024.output},
+	{"FFT256",	256,		FFT256_OUTPUT_SIZE,		345,			myFFT256.output},
+};
+static AudioConnection *const fftConnection[NUMBER_OF_FFT_SIZES] = {
+	&FFT1024_CONNECTION,
+	&FFT256_CONNECTION,
+};
+
+#if (DEFAULT_FFT_SIZE == 256)
+	fftAnalyzerType fftAnalyzer = fftAnalyzers[FFT_SIZE_256];
+#else
+	fftAnalyzerType fftAnalyzer = fftAnalyzers[FFT_SIZE_1024];
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Patch in the analyzer for fftSize (1024 or 256) and start its first tracker configuration.
+//-------------------------------------------------------------------------------------------------
+boolean selectFFTSize(int fftSize) {
+	int size, i, configuration;
+
+	for (size=0; (size < NUMBER_OF_FFT_SIZES) && (fftAnalyzers[size].fftSize != fftSize); size++);
+	if (size >= NUMBER_OF_FFT_SIZES) {
+		return(FALSE);
+	}
+
+	for (i=0; i<NUMBER_OF_FFT_SIZES; i++) {
+		if (i == size) {
+			fftConnection[i]->connect();
+		} else {
+			fftConnection[i]->disconnect();
+		}
+	}
+	fftAnalyzer = fftAnalyzers[size];
+
+	// Frames already queued came from the other analyzer
+	frameQueueFlush();
+
+	for (configuration=0; configuration<numberOfTrackerConfigurations; configuration++) {
+		if (trackerConfiguration[configuration].fftSize == fftSize) {
+			return(selectTrackerConfiguration(configuration));
+		}
+	}
+	return(FALSE);
+}
+
 //#define SIMPLIFY_SETUP
 
 //-------------------------------------------------------------------------------------------------
 void setup() {
 	// Audio connections require memory to work.  For more
 	// detailed information, see the MemoryAndCpuUsage example
-	AudioMemory(12);
+	AudioMemory(AUDIO_MEMORY_BLOCKS);	// healthMonitor.h watches how close it comes to running out
+	frameQueueReset();
+	profileOpen();
+#ifdef USE_TRACING
+	traceOpen();
+#endif
 
 	Serial.begin(115200);
 
@@ -84,8 +155,9 @@ void setup() {
 #endif
 
 #ifndef SIMPLIFY_SETUP
-		targetTracking.open();
+		selectFFTSize(DEFAULT_FFT_SIZE);	// Opens the tracker
 		serialPort.open();
+		spectrumStreamOpen();
 		//  target.open();
 
 		memset(&displayData, 0, sizeof(displayData));
@@ -105,117 +177,34 @@ void setup() {
   		Serial.println("Board has been initialized");
 
 	#ifdef USE_DATALOGGING
-	#error Not Ready
-		delay(2000);
-
-		//--------------------------------------------------------------
-		SPI.setMOSI(7); // Audio shield has MOSI on pin 7
-		SPI.setSCK(14); // Audio shield has SCK on pin 14
-   
-		// Open serial communications and wait for port to open:
-		Serial.begin(9600);
-
-		Serial.print("\nInitializing SD card...");
-		// On the Ethernet Shield, CS is pin 4. It's set as an output by default.
-		// Note that even if it's not used as the CS pin, the hardware SS pin
-		// (10 on most Arduino boards, 53 on the Mega) must be left as an output
-		// or the SD library functions will not work.
-		pinMode(chipSelect, OUTPUT); // change this to 53 on a mega
-
-		// we'll use the initialization code from the utility libraries
-		// since we're just testing if the card is working!
-		if (!card.init(SPI_HALF_SPEED, chipSelect)) {
-			Serial.println("initialization failed. Things to check:");
-			Serial.println("* is a card is inserted?");
-			Serial.println("* Is your wiring correct?");
-			Serial.println("* did you change the chipSelect pin to match your shield or module?");
-			return;
-		} else {
-			Serial.println("Wiring is correct and a card is present.");
-		}
-
-		// print the type of card
-		Serial.print("\nCard type: ");
-		switch(card.type()) {
-		case SD_CARD_TYPE_SD1:
-			Serial.println("SD1");
-			break;
-		case SD_CARD_TYPE_SD2:
-			Serial.println("SD2");
-			break;
-		case SD_CARD_TYPE_SDHC:
-			Serial.println("SDHC");
-			break;
-		default:
-			Serial.println("Unknown");
-		}
-
-		// Now we will try to open the 'volume'/'partition' - it should be FAT16 or FAT32
-		if (!volume.init(card)) {
-			Serial.println("Could not find FAT16/FAT32 partition.\nMake sure you've formatted the card");
-			return;
-		}
-
-
-		// print the type and size of the first FAT-type volume
-		uint32_t volumesize;
-		Serial.print("\nVolume type is FAT");
-		Serial.println(volume.fatType(), DEC);
-		Serial.println();
-  
-		volumesize = volume.blocksPerCluster(); // clusters are collections of blocks
-		volumesize *= volume.clusterCount(); // we'll have a lot of clusters
-		volumesize *= 512; // SD card blocks are always 512 bytes
-		Serial.print("Volume size (bytes): ");
-		Serial.println(volumesize);
-		Serial.print("Volume size (Kbytes): ");
-		volumesize /= 1024;
-		Serial.println(volumesize);
-		Serial.print("Volume size (Mbytes): ");
-		volumesize /= 1024;
-		Serial.println(volumesize);
-
-  
-		Serial.println("\nFiles found on the card (name, date and size in bytes): ");
-		root.openRoot(volume);
-  
-		// list all files in the card with date and size
-		root.ls(LS_R | LS_DATE | LS_SIZE);
-
-		// open the file. note that only one file can be open at a time,
-		// so you have to close this one before opening another.
-		testFile = SD.open("test.txt", FILE_WRITE);
-
-		// if the file is available, write to it:
-		if (testFile) {
-			testFile.println("This is a test");
-			testFile.close();
+		SPI.setMOSI(7);		// Audio shield has MOSI on pin 7
+		SPI.setSCK(14);		// Audio shield has SCK on pin 14
+		if (!SD.begin(chipSelect)) {
+			Serial.println("No SD card, not logging");
+		} else if (!dataLogOpen(&dataLogFileSink, DATALOG_FILE_NAME, DATALOG_PREALLOCATE_BLOCKS)) {
+			Serial.println("Couldn't open " DATALOG_FILE_NAME ", not logging");
 		} else {
-			// if the file isn't open, pop up an error:
-			Serial.println("error opening \"test.txt\"");
+			Serial.println("Logging to " DATALOG_FILE_NAME);
 		}
-
-		delay(5000);
-	#else
-		delay(1000);
 	#endif
+		delay(1000);
 #endif	// SIMPLIFY_SETUP
+	healthReset();
 }
 
 //-------------------------------------------------------------------------------------------------
 volatile int fftCounter = 0;
 boolean readyToPrint = FALSE;
 void loop() {
+	const spectrumFrameType *pFrame;
 
 #ifdef SIMPLIFY_SETUP
 #error SIMPLIFY_SETUP
-	if (myFFT.available()) {
+	pFrame = frameQueuePop();
+	if (pFrame != NULL) {
 		Serial.print("FFT Is Available: ");
 		Serial.println(fftCounter);
-		targetTracking.findNewTracks();
-		targetTracking.processExistingTracks();
-		targetTracking.sort();
-		targetTracking.updateMinimumMagnitude();
+		targetTracking.processFrame(pFrame);
 		fftCounter++;
 	}
 #else
@@ -233,27 +222,51 @@ void loop() {
 		#endif
 	#endif
   
-		if (myFFT.available()) {
+		// Frames wait in frameQueue while the serial port is being serviced.  While a replay runs
+		// its frames take the analyzer's place, and the analyzer's are thrown away.
+		pFrame = frameQueuePop();
+		if (replay.active) {
+			if ((replayFrame() != TRUE) && !PROTOCOL_IS_BINARY(serialData.protocol)) {
+				Serial.print("Replay done");
+				replayReport();
+				Serial.println();
+			}
+			serialPort.monitor();
+		} else if (pFrame != NULL) {
 			readyToPrint = TRUE;
 			fftCounter++;
 
-			targetTracking.findNewTracks();
-			targetTracking.processExistingTracks();
-			targetTracking.sort();
-			targetTracking.updateMinimumMagnitude();
+			PROFILE_BEGIN(frameStart);
+			targetTracking.processFrame(pFrame);
+			PROFILE_END(PROFILE_FRAME, frameStart);
+			if (serialData.protocol == SP_SPECTRUM_STREAM) {
+				spectrumStreamFrame(pFrame);
+			}
+		#ifdef USE_DATALOGGING
+			dataLogFrame(pFrame);
+		#endif
 		} else {
 			if (readyToPrint) {
+				PROFILE_BEGIN(displayStart);
 				readyToPrint = FALSE;
 
 				serialPort.monitor();
 				serialPort.updateDisplay(DISPLAY_RATE_MS);
+				PROFILE_END(PROFILE_DISPLAY, displayStart);
 			}
+		#ifdef USE_DATALOGGING
+			dataLogService();
+		#endif
 		}
+		PROFILE_BEGIN(serialStart);
+		serialPort.drain();
+		PROFILE_END(PROFILE_SERIAL, serialStart);
 
 		if (timer.millisecond >= 1000) {
 			timer.millisecond = 0;
 			systemData.fftsPerSecond = fftCounter;
 			fftCounter = 0;
+			healthCheck();
 
 			// Send something to the screen at least once per second
 			readyToPrint = TRUE;
@@ -323,22 +336,29 @@ void updateSimulation(int updateRate_ms) {
 //------------------------
 void millisecondTimer(void) {
 	#ifndef SIMPLIFY_SETUP
+		PROFILE_BEGIN(start);
 		timer.millisecond++;
 		timer.displayCounter++;
 		timer.simulationCounter++;
 		targetTracking.simulate(1);
+		PROFILE_END(PROFILE_MILLISECOND_TIMER, start);
 	#endif
 }
 
+//-------------------------------------------------------------------------------------------------
+// The frame the tracker last took, not the analyzer's output[], which the next FFT writes over
+// while it's being printed.  replay and telemetryDecode read this back as a recording.
 //-------------------------------------------------------------------------------------------------
 void displayFFT(void) {
-#ifdef USE_FFT_1024
-    Serial.print("FFT1024, ");
-#else
-    Serial.print("FFT256, ");
-#endif
-    for (int i=0; i<FFT_OUTPUT_ARRAY_SIZE; i++) {
-      Serial.print(myFFT.output[i]);
+	const spectrumFrameType *pFrame = fftData.pFrame;
+
+	if (pFrame == NULL) {
+		return;
+	}
+    Serial.print(fftAnalyzer.name);
+    Serial.print(", ");
+    for (int i=0; i<pFrame->numberOfBins; i++) {
+      Serial.print(pFrame->output[i]);
       Serial.print(", ");
     }
     Serial.println();
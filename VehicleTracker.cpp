@@ -14,38 +14,149 @@
 #define START_FREQ			10.0
 #define STOP_FREQ			20000.0
 
+// Peak extraction in detect()
+#define PEAK_CANDIDATE_LIST_SIZE(targets)	(3*(targets))	// Each peak taken can cover two listed ones
+#define PEAK_EXPOSED_LIST_SIZE(targets)		(2*(targets))	// Each peak taken exposes at most two bins
+
 systemDataType systemData;
-extern AudioAnalyzeFFT256 myFFT;
 
 // Local Function Declarations
 static void _open(void);				// Initialize the structure
 static void _reset(void);
-static boolean _trackTowardsDirection(int);
-static boolean _trackAwayDirection(int);
+#if defined(SUPPORT_CONFIGURED_DIRECTIONS) && !defined(IGNORE_DIRECTION)
+	static boolean _trackTowardsDirection(int);
+	static boolean _trackAwayDirection(int);
+#endif
 static void _trackBothDirections(int);
 static void _incrementDirectionConfidence(int);
-static void _zeroVehicleTrack(targetTrackingStructureType *);
-static void _sort(void);
-static void _updateMinimumMagnitude(void);
 static void _simulate(int);
+static int _predictTrackIndex(int, int);
+static int _trackGate(int);
+static int16_t _existingTrackThreshold(void);
+static int16_t _newTrackThreshold(void);
+static void _updateTrackEstimate(int, int);
+static void _startTrack(int, int, int16_t);
+static void _countFoundTracks(const U8 *, int);
+static void _decayMissedTracks(const U8 *, int, int);
+static U16 _newTrackId(void);
+static boolean _isStrongerTrack(int, int);
+static boolean _isStrongEnoughForNewTrack(int16_t);
+
+//-------------------------------------------------------------------------------------------------
+// Tracker configurations
+//-------------------------------------------------------------------------------------------------
+// The tracker is compiled once per configuration with the analyzer's output size, the number of
+// bins it searches, the number of targets it tracks and the spectrum sample type as constants, so
+// every per-bin and per-target loop has a fixed bound.  trackerConfiguration[] holds one
+// targetTracking table per configuration.  Only configurations for the selected analyzer can run.
+//
+// The configurations share systemData.track, sfrData and fftData, which are sized for the
+// largest, so only the selected one runs.  A configuration with fewer bins than the analyzer
+// searches a max-hold decimation of the analyzer output, the bin spacing a smaller FFT would give.
+//-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+struct vehicleTracker {
+	static_assert((sizeof(SampleT) == sizeof(int16_t)) && ((SampleT)-1 < 0), "The spectrum kernels work on signed 16-bit samples");
+	static_assert(AnalyzerBins <= FFT_OUTPUT_ARRAY_SIZE, "fftData is sized for the largest analyzer");
+	static_assert((Bins <= AnalyzerBins) && ((AnalyzerBins % Bins) == 0), "Bins has to divide the analyzer's output");
+	static_assert((Bins % SPECTRUM_BLOCK_SIZE) == 0, "The block-max index works on whole blocks");
+	static_assert(MaxTargets <= MAX_NUMBER_OF_TARGETS_TRACKED, "systemData.track is sized for the largest configuration");
+
+	typedef struct {
+		int index;
+		SampleT magnitude;
+	} peakCandidateType;
+
+	typedef struct {
+		int numberOfCandidates;
+		peakCandidateType candidate[PEAK_CANDIDATE_LIST_SIZE(MaxTargets)];	// Strongest first
+	} peakListType;
+
+	static const int analyzerBins	= AnalyzerBins;
+	static const int numberOfBins	= Bins;
+	static const int maximumTargets	= MaxTargets;
+
+	static const spectrumFrameType *pFrame;
+	static const SampleT *pSpectrum;
+	static SampleT decimatedSpectrum[(Bins < AnalyzerBins) ? Bins : 1];
+	static associationGateType trackGate[MaxTargets];
+	static int assignedIndex[MaxTargets];
+	static const pipelineStageType pipeline[NUMBER_OF_PIPELINE_STAGES];
+
+	static void open(void);
+	static void processFrame(const spectrumFrameType *);
+
+	// Pipeline stages - see trackerPipeline.h
+	static U16 ingest(void);
+	static U16 detect(void);
+	static U16 associate(void);
+	static U16 update(void);
+	static U16 classify(void);
+	static U16 publish(void);
+
+	static void sort(void);
+	static void updateMinimumMagnitude(void);
+
+	static void _ingestSpectrum(const uint16_t *);
+	static boolean _isStrongerPeak(const peakCandidateType *, const peakCandidateType *);
+	static void _insertPeak(peakListType *, int);
+	static void _extractPeaks(peakListType *);
+	static void _exposePeak(peakCandidateType *, int *, int);
+	static void _findPeakExtent(int, int *, int *);
+};
 
-targetTrackingType		targetTracking = VEHICLE_TRACKING_STRUCT_DEFAULTS;
-targetTrackingStructureType	_targetTracker[MAX_NUMBER_OF_TARGETS_TRACKED];
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+const spectrumFrameType *vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::pFrame;
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+const SampleT *vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::pSpectrum;
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+SampleT vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::decimatedSpectrum[(Bins < AnalyzerBins) ? Bins : 1];
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+associationGateType vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::trackGate[MaxTargets];
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+int vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::assignedIndex[MaxTargets];
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+const pipelineStageType vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::pipeline[NUMBER_OF_PIPELINE_STAGES] = {
+	// id,					name,			inputs,										run
+	{PIPELINE_INGEST,		"ingest",		PIPELINE_FRAME,								ingest},
+	{PIPELINE_DETECT,		"detect",		PIPELINE_SPECTRUM,							detect},
+	{PIPELINE_ASSOCIATE,	"associate",	PIPELINE_SPECTRUM,							associate},
+	{PIPELINE_UPDATE,		"update",		PIPELINE_ASSIGNMENTS,						update},
+	{PIPELINE_CLASSIFY,		"classify",		PIPELINE_TRACKS,							classify},
+	{PIPELINE_PUBLISH,		"publish",		0,											publish},
+};
+
+// Full resolution with every target for each analyzer, and a quarter resolution fast path on FFT1024
+typedef vehicleTracker<FFT1024_OUTPUT_SIZE, FFT1024_OUTPUT_SIZE, MAX_NUMBER_OF_TARGETS_TRACKED, int16_t> fft1024TrackerType;
+typedef vehicleTracker<FFT1024_OUTPUT_SIZE, FAST_TRACKER_BINS, FAST_TRACKER_TARGETS, int16_t> fft1024FastTrackerType;
+typedef vehicleTracker<FFT256_OUTPUT_SIZE, FFT256_OUTPUT_SIZE, MAX_NUMBER_OF_TARGETS_TRACKED, int16_t> fft256TrackerType;
+
+// The first configuration for each FFT size is the one selectFFTSize() starts it with
+const targetTrackingType trackerConfiguration[] = {
+	VEHICLE_TRACKING_STRUCT_DEFAULTS(fft1024TrackerType),
+	VEHICLE_TRACKING_STRUCT_DEFAULTS(fft1024FastTrackerType),
+	VEHICLE_TRACKING_STRUCT_DEFAULTS(fft256TrackerType),
+};
+const int numberOfTrackerConfigurations = sizeof(trackerConfiguration)/sizeof(trackerConfiguration[0]);
+
+#ifdef USE_FFT_256
+	targetTrackingType		targetTracking = VEHICLE_TRACKING_STRUCT_DEFAULTS(fft256TrackerType);
+#else
+	targetTrackingType		targetTracking = VEHICLE_TRACKING_STRUCT_DEFAULTS(fft1024TrackerType);
+#endif
 
 #define NUMBER_OF_MAGNITUDE_LEVELS	5
-const float magnitudeConfidenceArray[NUMBER_OF_MAGNITUDE_LEVELS] = {
-	10.0,
-	50.0,
-	100.0,
-	200.0,
-	400.0
+const _iq magnitudeConfidenceArray[NUMBER_OF_MAGNITUDE_LEVELS] = {
+	_IQ(10.0),
+	_IQ(50.0),
+	_IQ(100.0),
+	_IQ(200.0),
+	_IQ(400.0)
 };
 
 //-------------------------------------------------------------------------------------------------
 //-------------------------------------------------------------------------------------------------
 static void _open(void) {
-	int i;
-
 	targetTracking.reset();
 	targetTracking.flags.intitialized = TRUE;
 
@@ -55,128 +166,291 @@ static void _open(void) {
 	fftData.frequency[1] = 0.0;  
 	fftData.amplitude[1] = 0.0;
 	fftData.type = TONE_TYPE_SINE;
-	fftData.minimumMagnitude = DEFAULT_MINIMUM_MAGNITUDE;
+	fftData.minimumMagnitude = _IQ(DEFAULT_MINIMUM_MAGNITUDE);
+}
+
+//-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+void vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::open(void) {
+	_open();
+	_ingestSpectrum(fftAnalyzer.output);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Called once for each frame taken from frameQueue.  A frame left over from the other analyzer
+// is skipped.
+//-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+void vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::processFrame(const spectrumFrameType *pNewFrame) {
+	if (pNewFrame->numberOfBins != AnalyzerBins) {
+		return;
+	}
+	pFrame			= pNewFrame;
+	fftData.pFrame	= pNewFrame;
+	trackerPipelineRun(pipeline);
+}
+
+//-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+U16 vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::ingest(void) {
+	_ingestSpectrum(pFrame->output);
+	spectrumIndexBuild(&fftData.blockIndex, (const int16_t *)pSpectrum, Bins);
+	return(PIPELINE_SPECTRUM);
+}
+
+//-------------------------------------------------------------------------------------------------
+// The tracker and the display code read the frame's copy of the analyzer output in place.  The
+// magnitudes are 16-bit and the tracker has always treated them as int16_t.
+//
+// The frame stays put until loop() takes the next one from frameQueue, so a long burst of serial
+// output only costs frames once FRAME_QUEUE_DEPTH of them are waiting.  Bins under investigation
+// are marked in fftData.binIsUnderInvestigation, never by writing to the spectrum.
+//
+// A configuration with fewer bins takes the largest of each group of analyzer bins instead.
+//-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+void vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::_ingestSpectrum(const uint16_t *pAnalyzerOutput) {
+	const SampleT *pOutput = (const SampleT *)pAnalyzerOutput;
+	int bin, i;
+	SampleT maximum;
+
+	if (Bins == AnalyzerBins) {
+		pSpectrum = pOutput;
+	} else {
+		for (bin=0; bin<Bins; bin++) {
+			maximum = pOutput[bin*(AnalyzerBins/Bins)];
+			for (i=1; i<(AnalyzerBins/Bins); i++) {
+				if (pOutput[(bin*(AnalyzerBins/Bins))+i] > maximum) {
+					maximum = pOutput[(bin*(AnalyzerBins/Bins))+i];
+				}
+			}
+			decimatedSpectrum[bin] = maximum;
+		}
+		pSpectrum = decimatedSpectrum;
+	}
+	fftData.fftOutputArray	= (const int16_t *)pSpectrum;
+	fftData.numberOfBins	= Bins;
 }
 
 //-------------------------------------------------------------------------------------------------
 //-------------------------------------------------------------------------------------------------
 static void _reset(void) {
+	int i;
+
 	// Clear out the vehicle tracking structure
-	memset(systemData.targetTracker, 0, sizeof(systemData.targetTracker));
+	memset(&systemData.track, 0, sizeof(systemData.track));
+	for (i=0; i<MAX_NUMBER_OF_TARGETS_TRACKED; i++) {
+		systemData.trackOrder[i] = i;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Switch to trackerConfiguration[configuration], which has to be built for the selected analyzer.
+// Tracks from the previous configuration are dropped because their bins don't mean the same thing.
+//-------------------------------------------------------------------------------------------------
+boolean selectTrackerConfiguration(int configuration) {
+	if ((configuration < 0) || (configuration >= numberOfTrackerConfigurations) ||
+		(trackerConfiguration[configuration].fftSize != fftAnalyzer.fftSize)) {
+		return(FALSE);
+	}
+
+	targetTracking = trackerConfiguration[configuration];
+	targetTracking.reset();
+	binMaskClear(&fftData.binIsUnderInvestigation);
+	targetTracking.open();
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Search gate
+//-------------------------------------------------------------------------------------------------
+// A vehicle's Doppler bin changes at a nearly constant rate from frame to frame, so each track
+// carries an alpha-beta estimate of its index and of that rate.  Only a gate around the predicted
+// index is searched.  The gate narrows from MAX_TRACK_GATE to MIN_TRACK_GATE bins either side as
+// the track's magnitude confidence builds.
+//-------------------------------------------------------------------------------------------------
+static int _predictTrackIndex(int slot, int numberOfBins) {
+	int predictedIndex;
+
+	predictedIndex = _IQint(systemData.track.indexEstimate[slot] + systemData.track.indexRate[slot] + _IQ(0.5));
+	if (predictedIndex < SAMPLE_START_LOCATION) {
+		predictedIndex = SAMPLE_START_LOCATION;
+	} else if (predictedIndex >= numberOfBins) {
+		predictedIndex = numberOfBins-1;
+	}
+	return(predictedIndex);
+}
+
+//-------------------------------------------------------------------------------------------------
+static int _trackGate(int slot) {
+	int confidence;
+
+	confidence = systemData.track.confidence.magnitude[slot];
+	if (confidence > MAX_CONFIDENCE_LEVEL) {
+		confidence = MAX_CONFIDENCE_LEVEL;
+	} else if (confidence < 0) {
+		confidence = 0;
+	}
+	return(MAX_TRACK_GATE - (((MAX_TRACK_GATE - MIN_TRACK_GATE) * confidence) / MAX_CONFIDENCE_LEVEL));
 }
 
 //-------------------------------------------------------------------------------------------------
+// An existing track is kept down to 1/4 the minimum as determined by the sensitivityArray.
 //-------------------------------------------------------------------------------------------------
-void _processExistingTracks(void) {
-#define THREE_MPH			4		// TBD - 3 mph/second max acceleration to be tracked
+static int16_t _existingTrackThreshold(void) {
+	_iq threshold;
+
+	threshold = fftData.minimumMagnitude;
+	if (threshold < _IQ(MINIMUM_MAGNITUDE_FROM_SENSITIVITY_ARRAY*0.5)) {
+		threshold = _IQ(MINIMUM_MAGNITUDE_FROM_SENSITIVITY_ARRAY*0.5);
+	}
+	if (threshold > _IQ(INT16_MAX)) {
+		threshold = _IQ(INT16_MAX);
+	}
+	return((int16_t)_IQceilInt(threshold));
+}
+
+//-------------------------------------------------------------------------------------------------
+// A new track needs a positive sample at or above both the minimum magnitude and the sensitivity
+// minimum.  As a whole sample that is the larger of the two, rounded up.
+//-------------------------------------------------------------------------------------------------
+static int16_t _newTrackThreshold(void) {
+	_iq threshold;
+
+	threshold = fftData.minimumMagnitude;
+	if (threshold < _IQ(MINIMUM_MAGNITUDE_FROM_SENSITIVITY_ARRAY)) {
+		threshold = _IQ(MINIMUM_MAGNITUDE_FROM_SENSITIVITY_ARRAY);
+	}
+	if (threshold < _IQ(1)) {
+		threshold = _IQ(1);
+	}
+	if (threshold > _IQ(INT16_MAX)) {
+		threshold = _IQ(INT16_MAX);
+	}
+	return((int16_t)_IQceilInt(threshold));
+}
+
+//-------------------------------------------------------------------------------------------------
+// Correct the prediction with the peak found this frame.  The rate is kept inside the widest gate.
+//-------------------------------------------------------------------------------------------------
+static void _updateTrackEstimate(int slot, int index) {
+	_iq predicted, residual;
+
+	predicted	= systemData.track.indexEstimate[slot] + systemData.track.indexRate[slot];
+	residual	= _IQfromInt(index) - predicted;
+	systemData.track.indexEstimate[slot]	= predicted + _IQmpyIQ31(residual, _IQ31(TRACK_ALPHA));
+	systemData.track.indexRate[slot]		+= _IQmpyIQ31(residual, _IQ31(TRACK_BETA));
+	if (systemData.track.indexRate[slot] > _IQ(MAX_TRACK_GATE)) {
+		systemData.track.indexRate[slot] = _IQ(MAX_TRACK_GATE);
+	} else if (systemData.track.indexRate[slot] < _IQ(-MAX_TRACK_GATE)) {
+		systemData.track.indexRate[slot] = _IQ(-MAX_TRACK_GATE);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Give every track the best peak in a gate around where it should be this frame.  All tracks are
+// associated together so that no track's slot decides who gets a contested peak.
+//-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+U16 vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::associate(void) {
+	int searchIndex;
+	U16 dirty = 0;
+
+	for (searchIndex=0; searchIndex < MaxTargets; searchIndex++) {
+		if (systemData.track.index[searchIndex] != INVALID_VEHICLE_ENTRY) {
+			trackGate[searchIndex].predictedIndex	= _predictTrackIndex(searchIndex, Bins);
+			trackGate[searchIndex].gate				= _trackGate(searchIndex);
+			dirty = PIPELINE_ASSIGNMENTS;
+		} else {
+			trackGate[searchIndex].predictedIndex	= ASSOCIATION_NO_TRACK;
+		}
+	}
+	if (dirty) {
+		trackAssociationSolve((const int16_t *)pSpectrum, Bins, trackGate, MaxTargets, _existingTrackThreshold(), assignedIndex);
+	}
+
+	return(dirty);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Move each track to the peak it was given, or coast it.  The gates of the tracks that were found
+// are marked in binIsUnderInvestigation for the next frame's detect().
+//-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+U16 vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::update(void) {
 	boolean matchFound = FALSE;
 	int
-		i,
 		startIndex,
 		endIndex,
-		deltaIndex,
 		searchIndex,
-		sampleIndex,
 		maximumIndex;
+#ifndef IGNORE_DIRECTION
 	int16_t	temp1,
 		temp2,
-		result,
-		maximum,
-		value;
+		result;
+#endif
+	SampleT	maximum;
+	U8	found[MaxTargets],				// 1 for each track given a peak, otherwise 0
+		missed[MaxTargets];				// 1 for each track to coast, otherwise 0
 
-	// Clear out investigation list
-	memset(fftData.binIsUnderInvestigation,	0,	sizeof(fftData.binIsUnderInvestigation));
+	memset(found, 0, sizeof(found));
+	memset(missed, 0, sizeof(missed));
 
 	//---------------------------------------------------------------------------------------------
 	// Loop through list of vehicle objects that are presently being tracked
 	//---------------------------------------------------------------------------------------------
 	systemData.numberOfOldTargetsFound = 0;
-	for (searchIndex=0; searchIndex < MAX_NUMBER_OF_TARGETS_TRACKED; searchIndex++) {
+	for (searchIndex=0; searchIndex < MaxTargets; searchIndex++) {
 
-//		// Don't check if this entry is invalid.  An index of zero is invalid.
-//		if (systemData.targetTracker[searchIndex].index != INVALID_VEHICLE_ENTRY) {
-		// Don't check if this entry is invalid or is already under investigation.  An index of zero is invalid.
-		if ((systemData.targetTracker[searchIndex].index != INVALID_VEHICLE_ENTRY) &&
-			!fftData.binIsUnderInvestigation[systemData.targetTracker[searchIndex].index])  {
+		// Don't check if this entry is invalid.  An index of zero is invalid.
+		if (systemData.track.index[searchIndex] != INVALID_VEHICLE_ENTRY) {
 			matchFound = FALSE;
 
-			// Point to array position where previous vehicle was found
-			sampleIndex = systemData.targetTracker[searchIndex].index;
-			value		= fftData.fftOutputArray[sampleIndex];
-
-			// Loop around sampleIndex to find if the peak is still in the same place or within a reasonable delta
-			startIndex	= sampleIndex - MAX_DELTA_SEARCH;
+			startIndex	= trackGate[searchIndex].predictedIndex - trackGate[searchIndex].gate;
 			if (startIndex < SAMPLE_START_LOCATION) {
 				startIndex = SAMPLE_START_LOCATION;
 			}
 
-			endIndex	= sampleIndex + MAX_DELTA_SEARCH;
-			if (endIndex < FFT_OUTPUT_ARRAY_SIZE) {
-				endIndex = FFT_OUTPUT_ARRAY_SIZE;
-			}
-
-			maximum					= 0;
-			maximumIndex			= 0;
-			for (i=startIndex;i<endIndex;i++) {
-				value		= fftData.fftOutputArray[i];
-				if (value > maximum) {
-					maximum			= value;
-					maximumIndex	= i;
-				}
+			endIndex	= trackGate[searchIndex].predictedIndex + trackGate[searchIndex].gate + 1;
+			if (endIndex > Bins) {
+				endIndex = Bins;
 			}
 
-			// Assign how much the peak moved
-			deltaIndex = abs(systemData.targetTracker[searchIndex].index - maximumIndex);
-			if ((maximum >= fftData.minimumMagnitude) && 
-
-				// Drops off at 1/4 the minimum as determined by the sensitivityArray
-				(maximum >= (MINIMUM_MAGNITUDE_FROM_SENSITIVITY_ARRAY*0.5)) &&
+			maximumIndex	= assignedIndex[searchIndex];
+			maximum			= (maximumIndex != ASSOCIATION_NOT_ASSIGNED) ? pSpectrum[maximumIndex] : 0;
 
-				(deltaIndex < (THREE_MPH+systemData.targetTracker[searchIndex].deltaIndex))) {
+			// Only peaks above the threshold are associated
+			if (maximumIndex != ASSOCIATION_NOT_ASSIGNED) {
 				matchFound = TRUE;
-
-				if (systemData.targetTracker[searchIndex].trackCounter < 1000) {
-					systemData.targetTracker[searchIndex].trackCounter++;
-				}
+				found[searchIndex] = 1;
 
 				// Mark these bins so that other tracks don't find them.  Reuse startIndex and endIndex.
-				for (i=startIndex;i<endIndex;i++) {
-					fftData.binIsUnderInvestigation[i] = TRUE;
-				}
+				binMaskMarkRange(&fftData.binIsUnderInvestigation, startIndex, endIndex);
 
 				// Track how far this index was from the previous track index
-				systemData.targetTracker[searchIndex].deltaIndex = maximumIndex - systemData.targetTracker[searchIndex].index;
+				systemData.track.cold[searchIndex].deltaIndex = maximumIndex - systemData.track.index[searchIndex];
+				_updateTrackEstimate(searchIndex, maximumIndex);
 
 				//-----------------------------------------------------------
 				// Set new index
 				//-----------------------------------------------------------
-				systemData.targetTracker[searchIndex].index = maximumIndex;
-				systemData.targetTracker[searchIndex].magnitude = maximum;
+				systemData.track.index[searchIndex] = maximumIndex;
+				systemData.track.magnitude[searchIndex] = _IQfromInt(maximum);
 	
 				//-----------------------------------------------------------
 				// Set confidence counters
 				//-----------------------------------------------------------
 
-				//+++++++++++
-				// Magnitude
-				//+++++++++++
-//				deltaValue	= abs(systemData.targetTracker[searchIndex].magnitude - maximum);
-
-				// 25 percent of previous magnitude - magnitude is always a positive number
-				value = systemData.targetTracker[searchIndex].magnitude * 0.25;
-
-				if (systemData.targetTracker[searchIndex].confidence.magnitude < MAX_CONFIDENCE_LEVEL) {
-					systemData.targetTracker[searchIndex].confidence.magnitude++;
-				}
-
 				//+++++++++++
 				// Direction
 				//+++++++++++
 				#ifdef IGNORE_DIRECTION
 					#undef SUPPORT_CONFIGURED_DIRECTIONS
 				#else
-					temp1	= systemData.targetTracker[searchIndex].theta[RIGHT_CHANNEL];
-					temp2	= systemData.targetTracker[searchIndex].theta[LEFT_CHANNEL];
+					temp1	= systemData.track.cold[searchIndex].theta[RIGHT_CHANNEL];
+					temp2	= systemData.track.cold[searchIndex].theta[LEFT_CHANNEL];
 					if (temp2 > temp1) {
 						result		= (temp1 + 1.0) - temp2;
 					} else {
@@ -186,16 +460,16 @@ void _processExistingTracks(void) {
 					// Add calibrated phase offset then filter into deltaTheta
 				#ifdef FILTER_DELTA_THETA
 					temp1	= result + configuration.flash.phaseOffset;
-					temp2	= ((temp1 - systemData.targetTracker[searchIndex].deltaTheta) * 0.25) + systemData.targetTracker[searchIndex].deltaTheta;
-					systemData.targetTracker[searchIndex].deltaTheta = temp2;
+					temp2	= ((temp1 - systemData.track.cold[searchIndex].deltaTheta) * 0.25) + systemData.track.cold[searchIndex].deltaTheta;
+					systemData.track.cold[searchIndex].deltaTheta = temp2;
 				#else
-					systemData.targetTracker[searchIndex].deltaTheta = result + PHASE_OFFSET;
+					systemData.track.cold[searchIndex].deltaTheta = result + PHASE_OFFSET;
 				#endif
 
 					// deltaDeltaTheta is filtered
-					temp1	= systemData.targetTracker[searchIndex].deltaTheta - systemData.targetTracker[searchIndex].deltaTheta_z;
-					temp2	= ((temp1 - systemData.targetTracker[searchIndex].deltaDeltaTheta) * 0.25) + systemData.targetTracker[searchIndex].deltaDeltaTheta;
-					systemData.targetTracker[searchIndex].deltaDeltaTheta	= temp2;
+					temp1	= systemData.track.cold[searchIndex].deltaTheta - systemData.track.cold[searchIndex].deltaTheta_z;
+					temp2	= ((temp1 - systemData.track.cold[searchIndex].deltaDeltaTheta) * 0.25) + systemData.track.cold[searchIndex].deltaDeltaTheta;
+					systemData.track.cold[searchIndex].deltaDeltaTheta	= temp2;
 				#endif
 
 
@@ -221,184 +495,368 @@ void _processExistingTracks(void) {
 				// Lock or unlock the direction status
 				//---------------------------------------------------------------------------------
 // DWH TBD - integrate the following code where it makes more sense to have it
-				if (!systemData.targetTracker[searchIndex].directionIsLocked) {
-					if (systemData.targetTracker[searchIndex].confidence.direction >= (MAXIMUM_DIRECTION_COUNTER/4)) {
-						if (systemData.targetTracker[searchIndex].directionCounter > 0) {
-							systemData.targetTracker[searchIndex].direction = AWAY;
-						} else if (systemData.targetTracker[searchIndex].directionCounter < 0) {
-							systemData.targetTracker[searchIndex].direction = TOWARDS;
+				if (!systemData.track.cold[searchIndex].directionIsLocked) {
+					if (systemData.track.confidence.direction[searchIndex] >= (MAXIMUM_DIRECTION_COUNTER/4)) {
+						if (systemData.track.directionCounter[searchIndex] > 0) {
+							systemData.track.cold[searchIndex].direction = AWAY;
+						} else if (systemData.track.directionCounter[searchIndex] < 0) {
+							systemData.track.cold[searchIndex].direction = TOWARDS;
 						} else {
-							systemData.targetTracker[searchIndex].direction = UNKNOWN_DIRECTION;
+							systemData.track.cold[searchIndex].direction = UNKNOWN_DIRECTION;
 						}
 					} else {
-						systemData.targetTracker[searchIndex].direction = UNKNOWN_DIRECTION;
+						systemData.track.cold[searchIndex].direction = UNKNOWN_DIRECTION;
 					}
 				} else {
 					// Unlock direction if needed
-					switch (systemData.targetTracker[searchIndex].direction) {
+					switch (systemData.track.cold[searchIndex].direction) {
 					case TOWARDS:
-						if (systemData.targetTracker[searchIndex].directionCounter > (-MAXIMUM_DIRECTION_COUNTER/4)) {
-							systemData.targetTracker[searchIndex].directionIsLocked = FALSE;
+						if (systemData.track.directionCounter[searchIndex] > (-MAXIMUM_DIRECTION_COUNTER/4)) {
+							systemData.track.cold[searchIndex].directionIsLocked = FALSE;
 						}
 						break;
 					case AWAY:
-						if (systemData.targetTracker[searchIndex].directionCounter < (MAXIMUM_DIRECTION_COUNTER/4)) {
-							systemData.targetTracker[searchIndex].directionIsLocked = FALSE;
+						if (systemData.track.directionCounter[searchIndex] < (MAXIMUM_DIRECTION_COUNTER/4)) {
+							systemData.track.cold[searchIndex].directionIsLocked = FALSE;
 						}
 						break;
 					default:
-						systemData.targetTracker[searchIndex].directionIsLocked = FALSE;
+						systemData.track.cold[searchIndex].directionIsLocked = FALSE;
 						break;
 					}
 				}
 
-				systemData.targetTracker[searchIndex].deltaTheta_z	= systemData.targetTracker[searchIndex].deltaTheta;
+				systemData.track.cold[searchIndex].deltaTheta_z	= systemData.track.cold[searchIndex].deltaTheta;
 				systemData.numberOfOldTargetsFound++;
 			}
 
 			//-------------------------------------------------------------------------------------
-			if ((maximum < fftData.minimumMagnitude) || !matchFound) {
-				// Vehicle not found.  Bring confidence counters to zero.
-				_slowlyZeroVehicleTrack(searchIndex);
+			if ((_IQfromInt(maximum) < fftData.minimumMagnitude) || !matchFound) {
+				// Vehicle not found.  Coast the estimate and bring confidence counters to zero.
+				missed[searchIndex] = 1;
 			}
 		}
 	}
 
-	// Sort the tracking array
-	targetTracking.sort();
+	// The counters for every track are updated together
+	_countFoundTracks(found, MaxTargets);
+	_decayMissedTracks(missed, MaxTargets, Bins);
+
+	// Every track was either moved or coasted
+	return(PIPELINE_TRACKS);
+}
+
+//-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+U16 vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::classify(void) {
+	PROFILE_SAMPLE_BEGIN(sortStart);
+	sort();
+	PROFILE_SAMPLE_END(PROFILE_SORT, sortStart);
 
-	// 
+	PROFILE_SAMPLE_BEGIN(sideFiringStart);
 	targetTracking.sideFiringAlgorithm();
+	PROFILE_SAMPLE_END(PROFILE_SIDE_FIRING, sideFiringStart);
+	return(0);
 }
 
 //-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+U16 vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::publish(void) {
+	updateMinimumMagnitude();
+	return(0);
+}
+
+
 //-------------------------------------------------------------------------------------------------
-// The last step of this function zero's out fftOutputArray so that a peak is only found once.
-// This routine needs to be the last function called in the fft.process() function.
+// Peak extraction
 //-------------------------------------------------------------------------------------------------
+// Rescanning the spectrum for the strongest free bin once per target costs K full passes.  Instead
+// one pass lists every flat-top-aware local maximum that is strong enough to start a track, keeping
+// the strongest.  Taking them strongest first, and skipping any that an earlier peak's extent has
+// covered, gives the same tracks the rescan did:
+//  - An extent covers at most two other listed peaks (its two end bins), so the strongest
+//    3*MaxTargets candidates are always enough.
+//  - Covering an extent can leave the bin just outside it as the strongest in what remains of its
+//    stretch of spectrum.  Those bins are "exposed" and compete with the list.
 //-------------------------------------------------------------------------------------------------
-void _findNewTracks(void) {
-	boolean
-		matchFound;
-	int
-		i,
-		newVehicleIndex,
-		oldVehicleIndex,
-		startIndex,
-		endIndex,
-		deltaIndex,
-		sampleIndex,
-		maximumIndex;
-	float
-		maximum,
-		value,
+//-------------------------------------------------------------------------------------------------
+static boolean _isStrongEnoughForNewTrack(int16_t value) {
+	return(value >= fftData.newTrackThreshold);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Higher magnitude wins.  On a tie the lower bin wins, the same as a left to right search would.
+//-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+boolean vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::_isStrongerPeak(const peakCandidateType *pA, const peakCandidateType *pB) {
+	return((pA->magnitude > pB->magnitude) ||
+		((pA->magnitude == pB->magnitude) && (pA->index < pB->index)));
+}
+
+//-------------------------------------------------------------------------------------------------
+// Insert into the list, strongest first.  When the list is full the weakest entry falls off.
+//-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+void vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::_insertPeak(peakListType *pList, int index) {
+	peakCandidateType peak;
+	int position;
+
+	peak.index		= index;
+	peak.magnitude	= pSpectrum[index];
+	if (!_isStrongEnoughForNewTrack(peak.magnitude)) {
+		return;
+	}
+
+	position = pList->numberOfCandidates;
+	if (position >= PEAK_CANDIDATE_LIST_SIZE(MaxTargets)) {
+		if (!_isStrongerPeak(&peak, &pList->candidate[PEAK_CANDIDATE_LIST_SIZE(MaxTargets)-1])) {
+			return;
+		}
+		position = PEAK_CANDIDATE_LIST_SIZE(MaxTargets)-1;
+	} else {
+		pList->numberOfCandidates++;
+	}
+
+	while ((position > 0) && _isStrongerPeak(&peak, &pList->candidate[position-1])) {
+		pList->candidate[position] = pList->candidate[position-1];
+		position--;
+	}
+	pList->candidate[position] = peak;
+}
+
+//-------------------------------------------------------------------------------------------------
+// One pass over the bins that are not under investigation, taken a free stretch at a time.  A run
+// of equal bins is a peak when the bins either side of it are lower; a bin under investigation or
+// the end of the spectrum counts as lower.  A peak is listed at the first bin of its run.
+//
+// Most of the spectrum is too weak to start a track.  Each stretch is checked a block at a time
+// against the block-max index and blocks with nothing strong enough are stepped over: the
+// spectrum has to be falling into such a block, so any run in progress ends there.
+//-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+void vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::_extractPeaks(peakListType *pList) {
+	int i,
+		chunkEnd,
+		maximumIndex,
+		segmentStart,
+		segmentEnd,
+		runStart;		// First bin of the present run if it was entered going uphill, otherwise -1
+	SampleT value,
 		previousValue;
 
-	// Clear out the present vehicle tracker structure
-	memset(_targetTracker,	0, sizeof(_targetTracker));
-	for (i=0; i<FFT_OUTPUT_ARRAY_SIZE; i++) {
-		fftData.fftOutputArray[i] = myFFT.output[i];
-	}
-
-	// Outer loop goes once for each peak found, looking for progressively smaller peaks
-	for (newVehicleIndex=0; newVehicleIndex < MAX_NUMBER_OF_TARGETS_TRACKED; newVehicleIndex++) {
-		maximum						= 0;
-		maximumIndex				= 0;
-		for (sampleIndex = SAMPLE_START_LOCATION; sampleIndex < FFT_OUTPUT_ARRAY_SIZE; sampleIndex++) {
-			if (!fftData.binIsUnderInvestigation[sampleIndex]) {
-				value = fftData.fftOutputArray[sampleIndex];
-				if (value > maximum) {
-					maximum			= value;
-					maximumIndex	= sampleIndex;
-				}
+	pList->numberOfCandidates = 0;
+	for (segmentStart = binMaskNextFree(&fftData.binIsUnderInvestigation, SAMPLE_START_LOCATION);
+		segmentStart < Bins;
+		segmentStart = binMaskNextFree(&fftData.binIsUnderInvestigation, segmentEnd)) {
+		segmentEnd		= binMaskNextMarked(&fftData.binIsUnderInvestigation, segmentStart);
+
+		runStart		= -1;
+		previousValue	= 0;
+		for (i=segmentStart; i<segmentEnd; i=chunkEnd) {
+			chunkEnd = ((i >> SPECTRUM_BLOCK_SHIFT) + 1) << SPECTRUM_BLOCK_SHIFT;
+			if (chunkEnd > segmentEnd) {
+				chunkEnd = segmentEnd;
 			}
-		}
 
-		// Only find new peaks that are above our minimum noise level and the sensitivity setting
-		if ((maximum >= fftData.minimumMagnitude) &&
-			(maximum >= MINIMUM_MAGNITUDE_FROM_SENSITIVITY_ARRAY)) {
-			//-----------------------------------------------------------------------------------------
-			// Peak found, now store it away
-			//-----------------------------------------------------------------------------------------
-			// Mark this area as being under investigation by first finding the whole peak - start to finish
-			//-----------------------------------------------------------------------------------------
-			_zeroVehicleTrack(&_targetTracker[newVehicleIndex]);				// Clear it out to start from scratch
-			_targetTracker[newVehicleIndex].index						= maximumIndex;
-			_targetTracker[newVehicleIndex].magnitude					= maximum;
-			_targetTracker[newVehicleIndex].confidence.direction		= 0;
-			_targetTracker[newVehicleIndex].confidence.acceleration	= 0;
-			_targetTracker[newVehicleIndex].confidence.magnitude		= 2;	// Needs to be 2 to avoid immediate dropout
-			_targetTracker[newVehicleIndex].confidence.magnitudeTrack	= 2;
-			_targetTracker[newVehicleIndex].trackCounter				= 1;
-
-			// Search from peak backwards
-			previousValue	= maximum;
-			matchFound		= FALSE;
-			startIndex		= maximumIndex;
-			for (i=maximumIndex-1; (i>=SAMPLE_START_LOCATION) && !matchFound; i--) {
-				value = fftData.fftOutputArray[i];
-				if (value > previousValue) {
-					matchFound	= TRUE;
-					startIndex	= i;
+			if (!_isStrongEnoughForNewTrack(spectrumIndexWindowMax(&fftData.blockIndex, (const int16_t *)pSpectrum, i, chunkEnd, &maximumIndex))) {
+				if (runStart >= 0) {
+					_insertPeak(pList, runStart);
 				}
-				previousValue = value;
+				runStart		= -1;
+				previousValue	= pSpectrum[chunkEnd-1];
+				continue;
 			}
 
-			// Search from peak forwards
-			previousValue	= maximum;
-			matchFound		= FALSE;
-			endIndex		= maximumIndex;
-			for (i=maximumIndex+1; (i<FFT_OUTPUT_ARRAY_SIZE) && !matchFound; i++) {
-				value = fftData.fftOutputArray[i];
-				if (value > previousValue) {
-					matchFound	= TRUE;
-					endIndex	= i;
+			for (; i<chunkEnd; i++) {
+				value = pSpectrum[i];
+				if ((i == segmentStart) || (value > previousValue)) {
+					runStart = i;
+				} else if (value < previousValue) {
+					if (runStart >= 0) {
+						_insertPeak(pList, runStart);
+					}
+					runStart = -1;
 				}
 				previousValue = value;
 			}
+		}
 
-			// Start and End index of present peak has been found.  Now mark it so we don't look at it the next time through.
-			for (i=startIndex;i<=endIndex;i++) {
-				// Mark these bins so that other tracks don't find them.  Reuse startIndex and endIndex.
-				fftData.binIsUnderInvestigation[i] = TRUE;
+		if (runStart >= 0) {
+			_insertPeak(pList, runStart);
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Offer a bin next to a newly covered extent as a peak
+//-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+void vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::_exposePeak(peakCandidateType *pExposed, int *pNumberOfExposed, int index) {
+	if ((index >= SAMPLE_START_LOCATION) && (index < Bins) &&
+		!binMaskIsMarked(&fftData.binIsUnderInvestigation, index) &&
+		_isStrongEnoughForNewTrack(pSpectrum[index]) &&
+		(*pNumberOfExposed < PEAK_EXPOSED_LIST_SIZE(MaxTargets))) {
+		pExposed[*pNumberOfExposed].index		= index;
+		pExposed[*pNumberOfExposed].magnitude	= pSpectrum[index];
+		(*pNumberOfExposed)++;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Walk down both shoulders of a peak until the spectrum turns upwards again.  The extent includes
+// the first bin of the next rise on each side.
+//-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+void vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::_findPeakExtent(int peakIndex, int *pStartIndex, int *pEndIndex) {
+	int i;
+
+	// Search from peak backwards
+	*pStartIndex = peakIndex;
+	for (i=peakIndex-1; i>=SAMPLE_START_LOCATION; i--) {
+		if (pSpectrum[i] > pSpectrum[i+1]) {
+			*pStartIndex = i;
+			break;
+		}
+	}
+
+	// Search from peak forwards
+	*pEndIndex = peakIndex;
+	for (i=peakIndex+1; i<Bins; i++) {
+		if (pSpectrum[i] > pSpectrum[i-1]) {
+			*pEndIndex = i;
+			break;
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Bins marked by the last frame's update() are skipped.  Peaks taken here are marked in
+// binIsUnderInvestigation so that a peak is only found once, and the mask is cleared when done.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+U16 vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::detect(void) {
+	int
+		i,
+		newVehicleIndex,
+		oldVehicleIndex,
+		startIndex,
+		endIndex,
+		maximumIndex,
+		nextCandidate,
+		numberOfExposed,
+		exposedIndex;
+	SampleT
+		maximum;
+	peakListType
+		peakList;
+	peakCandidateType
+		exposedPeak[PEAK_EXPOSED_LIST_SIZE(MaxTargets)],
+		newTrack[MaxTargets];			// An index of zero is unused
+	binMaskType
+		nearOldTrack;
+	U16
+		dirty = 0;
+
+	// Clear out the new vehicle list
+	memset(newTrack, 0, sizeof(newTrack));
+	fftData.newTrackThreshold = _newTrackThreshold();
+
+	// Pick peaks strongest first.  Each one taken covers its whole extent so it is only found once.
+	// Nothing to list when even the strongest free bin is too weak, which is most frames.
+	maximum = spectrumIndexMaskedArgmax(&fftData.blockIndex, (const int16_t *)pSpectrum, &fftData.binIsUnderInvestigation,
+		SAMPLE_START_LOCATION, Bins, &maximumIndex);
+	if (_isStrongEnoughForNewTrack(maximum)) {
+		_extractPeaks(&peakList);
+	} else {
+		peakList.numberOfCandidates = 0;
+	}
+	nextCandidate		= 0;
+	numberOfExposed		= 0;
+	for (newVehicleIndex=0; newVehicleIndex < MaxTargets; newVehicleIndex++) {
+		// Skip candidates that an earlier peak's extent has covered
+		while ((nextCandidate < peakList.numberOfCandidates) &&
+			binMaskIsMarked(&fftData.binIsUnderInvestigation, peakList.candidate[nextCandidate].index)) {
+			nextCandidate++;
+		}
+
+		exposedIndex = -1;
+		for (i=0; i<numberOfExposed; i++) {
+			if (!binMaskIsMarked(&fftData.binIsUnderInvestigation, exposedPeak[i].index) &&
+				((exposedIndex < 0) || _isStrongerPeak(&exposedPeak[i], &exposedPeak[exposedIndex]))) {
+				exposedIndex = i;
 			}
+		}
+
+		if ((exposedIndex >= 0) &&
+			((nextCandidate >= peakList.numberOfCandidates) ||
+			 _isStrongerPeak(&exposedPeak[exposedIndex], &peakList.candidate[nextCandidate]))) {
+			maximumIndex	= exposedPeak[exposedIndex].index;
+			maximum			= exposedPeak[exposedIndex].magnitude;
+			exposedPeak[exposedIndex] = exposedPeak[--numberOfExposed];
+		} else if (nextCandidate < peakList.numberOfCandidates) {
+			maximumIndex	= peakList.candidate[nextCandidate].index;
+			maximum			= peakList.candidate[nextCandidate].magnitude;
+			nextCandidate++;
 		} else {
 			// No valid signal level is present
 			break;
 		}
+
+		//-----------------------------------------------------------------------------------------
+		// Peak found, now store it away
+		//-----------------------------------------------------------------------------------------
+		// Mark this area as being under investigation by first finding the whole peak - start to finish
+		//-----------------------------------------------------------------------------------------
+		newTrack[newVehicleIndex].index		= maximumIndex;
+		newTrack[newVehicleIndex].magnitude	= maximum;
+
+		_findPeakExtent(maximumIndex, &startIndex, &endIndex);
+
+		// Start and End index of present peak has been found.  Now mark it so we don't look at it the next time through.
+		binMaskMarkRange(&fftData.binIsUnderInvestigation, startIndex, endIndex+1);
+
+		// The bins either side of the extent may now be the strongest left in their stretch of spectrum.
+		// Step left over a flat top so that ties still go to the lowest bin.
+		for (i=startIndex-1; (i > SAMPLE_START_LOCATION) && !binMaskIsMarked(&fftData.binIsUnderInvestigation, i) &&
+			!binMaskIsMarked(&fftData.binIsUnderInvestigation, i-1) &&
+			(pSpectrum[i-1] == pSpectrum[i]); i--) {
+		}
+		_exposePeak(exposedPeak, &numberOfExposed, i);
+		_exposePeak(exposedPeak, &numberOfExposed, endIndex+1);
 	}
 
 	//=============================================================================================
 	//=============================================================================================
 	// Done finding vehicles - now go through previous list to see if we've already seen these
-	// vehicles.  If we've seen them before, then we've processed them already in the 
-	// processExistingTracks() function.
+	// vehicles.  If we've seen them before, then the associate() and update() stages look after
+	// them.
 	//=============================================================================================
 	//=============================================================================================
+	binMaskClear(&nearOldTrack);
+	for (oldVehicleIndex=0; oldVehicleIndex < MaxTargets; oldVehicleIndex++) {
+		if (systemData.track.index[oldVehicleIndex] != INVALID_VEHICLE_ENTRY) {
+			binMaskMarkRange(&nearOldTrack, systemData.track.index[oldVehicleIndex] - MAX_DELTA_SEARCH + 1,
+				systemData.track.index[oldVehicleIndex] + MAX_DELTA_SEARCH);
+		}
+	}
+
 	systemData.numberOfOldTargetsFound = 0;
-	for (newVehicleIndex=0; newVehicleIndex < MAX_NUMBER_OF_TARGETS_TRACKED; newVehicleIndex++) {
-		matchFound = FALSE;
-		
+	for (newVehicleIndex=0; newVehicleIndex < MaxTargets; newVehicleIndex++) {
 		// Don't check old entry if the new entry is invalid.  An index of zero is invalid.
-		if (_targetTracker[newVehicleIndex].index != INVALID_VEHICLE_ENTRY) {
-			for (oldVehicleIndex=0; (oldVehicleIndex < MAX_NUMBER_OF_TARGETS_TRACKED) && (matchFound == FALSE); oldVehicleIndex++) {
-				if (systemData.targetTracker[oldVehicleIndex].index != INVALID_VEHICLE_ENTRY) {
-					deltaIndex = abs(systemData.targetTracker[oldVehicleIndex].index - _targetTracker[newVehicleIndex].index);
-					if (deltaIndex < MAX_DELTA_SEARCH) {
-						matchFound = TRUE;
-						// Compare to 0, not fftData.minimumMagnitude, because we want everything at 
-						// this stage of the search
-						if (_targetTracker[newVehicleIndex].magnitude > 0) {
-							systemData.numberOfOldTargetsFound++;
-						}
-						// Zero the new vehicle track so we don't use it when we save it.
-						_zeroVehicleTrack(&_targetTracker[newVehicleIndex]);
-					}
+		if (newTrack[newVehicleIndex].index != INVALID_VEHICLE_ENTRY) {
+			// Within MAX_DELTA_SEARCH of an old track
+			if (binMaskIsMarked(&nearOldTrack, newTrack[newVehicleIndex].index)) {
+				// Compare to 0, not fftData.minimumMagnitude, because we want everything at 
+				// this stage of the search
+				if (newTrack[newVehicleIndex].magnitude > 0) {
+					systemData.numberOfOldTargetsFound++;
 				}
-			}
-
-			// If we went all the way through the above list and didn't find a match, then we found a new vehicle.
-			if (oldVehicleIndex >= MAX_NUMBER_OF_TARGETS_TRACKED) {
+				// Zero the new vehicle track so we don't use it when we save it.
+				newTrack[newVehicleIndex].index = INVALID_VEHICLE_ENTRY;
+			} else {
+				// No old track near this one, so we found a new vehicle.
 				systemData.numberOfNewTargetsFound++;
 			}
 		}
@@ -409,26 +867,29 @@ void _findNewTracks(void) {
 	// We're done.  Save new vehicle tracks.
 	//=============================================================================================
 	//=============================================================================================
-	for (newVehicleIndex=0; newVehicleIndex < MAX_NUMBER_OF_TARGETS_TRACKED; newVehicleIndex++) {
-		if (_targetTracker[newVehicleIndex].index != INVALID_VEHICLE_ENTRY) {
-			// Find an unused spot in the system vehicle tracking structure
-			matchFound = FALSE;
-			for (oldVehicleIndex=0; (oldVehicleIndex<MAX_NUMBER_OF_TARGETS_TRACKED) && (matchFound == FALSE); oldVehicleIndex++) {
-				if (systemData.targetTracker[oldVehicleIndex].index == INVALID_VEHICLE_ENTRY) {
-					matchFound = TRUE;
-					memcpy(&systemData.targetTracker[oldVehicleIndex], &_targetTracker[newVehicleIndex], sizeof(targetTrackingStructureType));
-				}
+	oldVehicleIndex = 0;
+	for (newVehicleIndex=0; newVehicleIndex < MaxTargets; newVehicleIndex++) {
+		if (newTrack[newVehicleIndex].index != INVALID_VEHICLE_ENTRY) {
+			// Find an unused spot in the system vehicle tracking structure.  Spots before this one are in use.
+			while ((oldVehicleIndex < MaxTargets) && (systemData.track.index[oldVehicleIndex] != INVALID_VEHICLE_ENTRY)) {
+				oldVehicleIndex++;
 			}
-			// No more room for new vehicles in the systemData.targetTracker structure
-			if (matchFound == FALSE) {
+			// No more room for new vehicles in the systemData.track structure
+			if (oldVehicleIndex >= MaxTargets) {
 				break;
 			}
+			_startTrack(oldVehicleIndex, newTrack[newVehicleIndex].index, newTrack[newVehicleIndex].magnitude);
+			dirty = PIPELINE_TRACKS;
 		}
 	}
 
-	targetTracking.sort();
+	// The investigation list has been used.  update() marks it again for the next frame.
+	binMaskClear(&fftData.binIsUnderInvestigation);
+
+	return(dirty);
 }
 
+#if defined(SUPPORT_CONFIGURED_DIRECTIONS) && !defined(IGNORE_DIRECTION)
 //-------------------------------------------------------------------------------------------------
 // Returns TRUE if we found a vehicle going the correct direction
 //-------------------------------------------------------------------------------------------------
@@ -436,22 +897,22 @@ static boolean _trackTowardsDirection(int vehicleIndex) {
 	boolean returnValue	= FALSE;
 
 	// If Towards
-	if ((systemData.targetTracker[vehicleIndex].deltaTheta <= MAX_TOWARDS_PHASE_DELTA) && 
-		(systemData.targetTracker[vehicleIndex].deltaTheta >= MIN_TOWARDS_PHASE_DELTA)) {
+	if ((systemData.track.cold[vehicleIndex].deltaTheta <= MAX_TOWARDS_PHASE_DELTA) && 
+		(systemData.track.cold[vehicleIndex].deltaTheta >= MIN_TOWARDS_PHASE_DELTA)) {
 		// We found the correct direction
 		returnValue	= TRUE;
-		if (systemData.targetTracker[vehicleIndex].directionCounter > -MAXIMUM_DIRECTION_COUNTER) {
-			systemData.targetTracker[vehicleIndex].directionCounter--;
+		if (systemData.track.directionCounter[vehicleIndex] > -MAXIMUM_DIRECTION_COUNTER) {
+			systemData.track.directionCounter[vehicleIndex]--;
 		} else {
-			systemData.targetTracker[vehicleIndex].directionIsLocked = TRUE;
+			systemData.track.cold[vehicleIndex].directionIsLocked = TRUE;
 		}
 
 		_incrementDirectionConfidence(vehicleIndex);
 	} else {
-		bringToZero(&systemData.targetTracker[vehicleIndex].directionCounter);
-		bringToZero(&systemData.targetTracker[vehicleIndex].confidence.direction);
-		bringToZero(&systemData.targetTracker[vehicleIndex].directionCounter);
-		bringToZero(&systemData.targetTracker[vehicleIndex].confidence.direction);
+		bringToZero(&systemData.track.directionCounter[vehicleIndex]);
+		bringToZero(&systemData.track.confidence.direction[vehicleIndex]);
+		bringToZero(&systemData.track.directionCounter[vehicleIndex]);
+		bringToZero(&systemData.track.confidence.direction[vehicleIndex]);
 	}
 	return(returnValue);
 }
@@ -464,25 +925,26 @@ static boolean _trackAwayDirection(int vehicleIndex) {
 	boolean returnValue	= FALSE;
 
 	// If Away
-	if ((systemData.targetTracker[vehicleIndex].deltaTheta <= MAX_AWAY_PHASE_DELTA) && 
-		(systemData.targetTracker[vehicleIndex].deltaTheta >= MIN_AWAY_PHASE_DELTA)) {
+	if ((systemData.track.cold[vehicleIndex].deltaTheta <= MAX_AWAY_PHASE_DELTA) && 
+		(systemData.track.cold[vehicleIndex].deltaTheta >= MIN_AWAY_PHASE_DELTA)) {
 		// We found the correct direction
 		returnValue	= TRUE;
-		if (systemData.targetTracker[vehicleIndex].directionCounter < MAXIMUM_DIRECTION_COUNTER) {
-			systemData.targetTracker[vehicleIndex].directionCounter++;
+		if (systemData.track.directionCounter[vehicleIndex] < MAXIMUM_DIRECTION_COUNTER) {
+			systemData.track.directionCounter[vehicleIndex]++;
 		} else {
-			systemData.targetTracker[vehicleIndex].directionIsLocked = TRUE;
+			systemData.track.cold[vehicleIndex].directionIsLocked = TRUE;
 		}
 
 		_incrementDirectionConfidence(vehicleIndex);
 	} else {
-		bringToZero(&systemData.targetTracker[vehicleIndex].directionCounter);
-		bringToZero(&systemData.targetTracker[vehicleIndex].confidence.direction);
-		bringToZero(&systemData.targetTracker[vehicleIndex].directionCounter);
-		bringToZero(&systemData.targetTracker[vehicleIndex].confidence.direction);
+		bringToZero(&systemData.track.directionCounter[vehicleIndex]);
+		bringToZero(&systemData.track.confidence.direction[vehicleIndex]);
+		bringToZero(&systemData.track.directionCounter[vehicleIndex]);
+		bringToZero(&systemData.track.confidence.direction[vehicleIndex]);
 	}
 	return(returnValue);
 }
+#endif
 
 
 //-------------------------------------------------------------------------------------------------
@@ -490,36 +952,36 @@ static boolean _trackAwayDirection(int vehicleIndex) {
 //-------------------------------------------------------------------------------------------------
 static void _trackBothDirections(int vehicleIndex) {
 #ifdef IGNORE_DIRECTION
-	if (systemData.targetTracker[vehicleIndex].directionCounter < MAXIMUM_DIRECTION_COUNTER) {
-		systemData.targetTracker[vehicleIndex].directionCounter++;
+	if (systemData.track.directionCounter[vehicleIndex] < MAXIMUM_DIRECTION_COUNTER) {
+		systemData.track.directionCounter[vehicleIndex]++;
 	} else {
-		systemData.targetTracker[vehicleIndex].directionIsLocked = TRUE;
+		systemData.track.cold[vehicleIndex].directionIsLocked = TRUE;
 	}
 	_incrementDirectionConfidence(vehicleIndex);
 #else
-	if ((systemData.targetTracker[vehicleIndex].deltaTheta <= MAX_TOWARDS_PHASE_DELTA) && 
-		(systemData.targetTracker[vehicleIndex].deltaTheta >= MIN_TOWARDS_PHASE_DELTA)) {
-		if (systemData.targetTracker[vehicleIndex].directionCounter > -MAXIMUM_DIRECTION_COUNTER) {
-			systemData.targetTracker[vehicleIndex].directionCounter--;
+	if ((systemData.track.cold[vehicleIndex].deltaTheta <= MAX_TOWARDS_PHASE_DELTA) && 
+		(systemData.track.cold[vehicleIndex].deltaTheta >= MIN_TOWARDS_PHASE_DELTA)) {
+		if (systemData.track.directionCounter[vehicleIndex] > -MAXIMUM_DIRECTION_COUNTER) {
+			systemData.track.directionCounter[vehicleIndex]--;
 		} else {
-			systemData.targetTracker[vehicleIndex].directionIsLocked = TRUE;
+			systemData.track.cold[vehicleIndex].directionIsLocked = TRUE;
 		}
 
 		_incrementDirectionConfidence(vehicleIndex);
-	} else if ((systemData.targetTracker[vehicleIndex].deltaTheta <= MAX_AWAY_PHASE_DELTA) && 
-			(systemData.targetTracker[vehicleIndex].deltaTheta >= MIN_AWAY_PHASE_DELTA)) {
-		if (systemData.targetTracker[vehicleIndex].directionCounter < MAXIMUM_DIRECTION_COUNTER) {
-			systemData.targetTracker[vehicleIndex].directionCounter++;
+	} else if ((systemData.track.cold[vehicleIndex].deltaTheta <= MAX_AWAY_PHASE_DELTA) && 
+			(systemData.track.cold[vehicleIndex].deltaTheta >= MIN_AWAY_PHASE_DELTA)) {
+		if (systemData.track.directionCounter[vehicleIndex] < MAXIMUM_DIRECTION_COUNTER) {
+			systemData.track.directionCounter[vehicleIndex]++;
 		} else {
-			systemData.targetTracker[vehicleIndex].directionIsLocked = TRUE;
+			systemData.track.cold[vehicleIndex].directionIsLocked = TRUE;
 		}
 
 		_incrementDirectionConfidence(vehicleIndex);
 	} else {
-		bringToZero(&systemData.targetTracker[vehicleIndex].directionCounter);
-		bringToZero(&systemData.targetTracker[vehicleIndex].confidence.direction);
-		bringToZero(&systemData.targetTracker[vehicleIndex].directionCounter);
-		bringToZero(&systemData.targetTracker[vehicleIndex].confidence.direction);
+		bringToZero(&systemData.track.directionCounter[vehicleIndex]);
+		bringToZero(&systemData.track.confidence.direction[vehicleIndex]);
+		bringToZero(&systemData.track.directionCounter[vehicleIndex]);
+		bringToZero(&systemData.track.confidence.direction[vehicleIndex]);
 	}
 #endif
 }
@@ -533,123 +995,161 @@ static void _incrementDirectionConfidence(int vehicleIndex) {
 
 	count	= 2;	// Minimum count set here
 	for (i=0; i<NUMBER_OF_MAGNITUDE_LEVELS; i++) {
-		if (systemData.targetTracker[vehicleIndex].magnitude < magnitudeConfidenceArray[i]) {
+		if (systemData.track.magnitude[vehicleIndex] < magnitudeConfidenceArray[i]) {
 			count = i+1;
 			break;
 		}
 	}
-	systemData.targetTracker[vehicleIndex].confidence.direction += count;
+	systemData.track.confidence.direction[vehicleIndex] += count;
 
-	if (systemData.targetTracker[vehicleIndex].confidence.direction > (MAXIMUM_DIRECTION_COUNTER)) {
-		systemData.targetTracker[vehicleIndex].confidence.direction = (MAXIMUM_DIRECTION_COUNTER);
+	if (systemData.track.confidence.direction[vehicleIndex] > (MAXIMUM_DIRECTION_COUNTER)) {
+		systemData.track.confidence.direction[vehicleIndex] = (MAXIMUM_DIRECTION_COUNTER);
 	}
 }
 
 //-------------------------------------------------------------------------------------------------
-// No return value
+// A new track in a free slot
 //-------------------------------------------------------------------------------------------------
-void _slowlyZeroVehicleTrack(int vehicleIndex) {
-	float tempMagnitude;
-
-	// Reduce magnitude by 1/8
-	tempMagnitude = systemData.targetTracker[vehicleIndex].magnitude*0.125;
-	systemData.targetTracker[vehicleIndex].magnitude -= tempMagnitude;
-
-	// Twice for direction!
-	bringToZero(&systemData.targetTracker[vehicleIndex].confidence.direction);
-	bringToZero(&systemData.targetTracker[vehicleIndex].confidence.direction);
-	bringToZero(&systemData.targetTracker[vehicleIndex].directionCounter);
-	bringToZero(&systemData.targetTracker[vehicleIndex].directionCounter);
-
-	bringToZero(&systemData.targetTracker[vehicleIndex].confidence.acceleration);
-	bringToZero(&systemData.targetTracker[vehicleIndex].confidence.magnitude);
-	bringToZero(&systemData.targetTracker[vehicleIndex].confidence.magnitudeTrack);
+static void _startTrack(int slot, int index, int16_t magnitude) {
+	systemData.track.index[slot]						= index;
+	systemData.track.id[slot]							= _newTrackId();
+	systemData.track.magnitude[slot]					= _IQfromInt(magnitude);
+	systemData.track.indexEstimate[slot]				= _IQfromInt(index);
+	systemData.track.indexRate[slot]					= 0;
+	systemData.track.trackCounter[slot]					= 1;
+	systemData.track.directionCounter[slot]				= 0;
+	systemData.track.confidence.direction[slot]			= 0;
+	systemData.track.confidence.acceleration[slot]		= 0;
+	systemData.track.confidence.magnitude[slot]			= 2;	// Needs to be 2 to avoid immediate dropout
+	systemData.track.confidence.magnitudeTrack[slot]	= 2;
+	memset(&systemData.track.cold[slot], 0, sizeof(trackColdType));
+}
 
-	if ((systemData.targetTracker[vehicleIndex].confidence.direction == 0) &&
-		(systemData.targetTracker[vehicleIndex].confidence.acceleration == 0) &&
-		(systemData.targetTracker[vehicleIndex].confidence.magnitude == 0) &&
-		(systemData.targetTracker[vehicleIndex].confidence.magnitudeTrack == 0)) {
+//-------------------------------------------------------------------------------------------------
+// Batch track updates
+//-------------------------------------------------------------------------------------------------
+// These run down each column for every slot at once, with the 0/1 flags from update() in place of
+// branches.  A comparison in C is already 0 or 1, so "x -= (x > 0)" is bringToZero() and
+// "x += found & (x < limit)" is a saturating increment.  Free slots are never flagged.
+//-------------------------------------------------------------------------------------------------
+static void _countFoundTracks(const U8 *pFound, int numberOfTracks) {
+	int i;
 
-		// If we have no confidence, this is an invalid vehicle
-		_zeroVehicleTrack(&systemData.targetTracker[vehicleIndex]);
+	for (i=0; i<numberOfTracks; i++) {
+		systemData.track.trackCounter[i]			+= pFound[i] & (systemData.track.trackCounter[i] < 1000);
+		systemData.track.confidence.magnitude[i]	+= pFound[i] & (systemData.track.confidence.magnitude[i] < MAX_CONFIDENCE_LEVEL);
 	}
 }
 
+//-------------------------------------------------------------------------------------------------
+// A missed track coasts its index estimate, loses 1/8 of its magnitude and has its confidence
+// counters brought towards zero - direction twice.  Once all four confidences are zero the track
+// is dropped and its slot freed.
+//-------------------------------------------------------------------------------------------------
+static void _decayMissedTracks(const U8 *pMissed, int numberOfTracks, int numberOfBins) {
+	int i, missed, drop;
+	_iq estimate;
+
+	for (i=0; i<numberOfTracks; i++) {
+		missed = pMissed[i];
+
+		estimate = systemData.track.indexEstimate[i] + _IQmpyI32(systemData.track.indexRate[i], missed);
+		systemData.track.indexEstimate[i] = _IQsat(estimate, _IQfromInt(numberOfBins-1), _IQ(SAMPLE_START_LOCATION));
+
+		systemData.track.magnitude[i] -= _IQmpyI32(_IQmpyIQ31(systemData.track.magnitude[i], _IQ31(0.125)), missed);
+
+		systemData.track.confidence.direction[i]	-= missed & (systemData.track.confidence.direction[i] > 0);
+		systemData.track.confidence.direction[i]	-= missed & (systemData.track.confidence.direction[i] > 0);
+		systemData.track.directionCounter[i]		-= missed & (systemData.track.directionCounter[i] > 0);
+		systemData.track.directionCounter[i]		-= missed & (systemData.track.directionCounter[i] > 0);
+		systemData.track.confidence.acceleration[i]	-= missed & (systemData.track.confidence.acceleration[i] > 0);
+		systemData.track.confidence.magnitude[i]	-= missed & (systemData.track.confidence.magnitude[i] > 0);
+		systemData.track.confidence.magnitudeTrack[i]	-= missed & (systemData.track.confidence.magnitudeTrack[i] > 0);
+
+		// If we have no confidence, this is an invalid vehicle.  The counters are never negative.
+		drop = missed & ((systemData.track.confidence.direction[i] | systemData.track.confidence.acceleration[i] |
+			systemData.track.confidence.magnitude[i] | systemData.track.confidence.magnitudeTrack[i]) == 0);
+		systemData.track.index[i]		&= drop - 1;
+		systemData.track.id[i]			&= drop - 1;
+		systemData.track.magnitude[i]	= _IQmpyI32(systemData.track.magnitude[i], 1 - drop);
+	}
+}
 
 //-------------------------------------------------------------------------------------------------
-static void _zeroVehicleTrack(targetTrackingStructureType *p) {
-	memset(p, 0, sizeof(targetTrackingStructureType));
+// Track IDs count up from 1 and skip 0, which marks a free slot.  A track that lives through
+// 65535 newer ones could share an ID, which only matters for the side-firing state.
+//-------------------------------------------------------------------------------------------------
+static U16 _newTrackId(void) {
+	if (++systemData.nextTrackId == 0) {
+		systemData.nextTrackId = 1;
+	}
+	return(systemData.nextTrackId);
 }
 
+//-------------------------------------------------------------------------------------------------
+// Any track is stronger than a free slot
+//-------------------------------------------------------------------------------------------------
+static boolean _isStrongerTrack(int slotA, int slotB) {
+	if (systemData.track.index[slotB] == INVALID_VEHICLE_ENTRY) {
+		return(systemData.track.index[slotA] != INVALID_VEHICLE_ENTRY);
+	}
+	return((systemData.track.index[slotA] != INVALID_VEHICLE_ENTRY) &&
+		(systemData.track.magnitude[slotA] > systemData.track.magnitude[slotB]));
+}
 
 //-------------------------------------------------------------------------------------------------
 // Sort by magnitude
 //-------------------------------------------------------------------------------------------------
-// WARNING!  This function uses the _targetTracker structure as a temporary storage location!
+// Tracks stay in their slots.  Only systemData.trackOrder is sorted, strongest first with the free
+// slots last.  Last frame's order is nearly right, so an insertion sort does little work, and
+// tracks of equal magnitude keep their places.
 //-------------------------------------------------------------------------------------------------
-static void _sort(void) {
-	int destinationIndex,
-		maximumIndex,
-		vehicleIndex;
-	float maximum;
-
-	for (destinationIndex=0; destinationIndex<MAX_NUMBER_OF_TARGETS_TRACKED; destinationIndex++) {
-		// Find maximum
-		maximum				= 0;
-		maximumIndex		= 0;
-		for (vehicleIndex=0; vehicleIndex<MAX_NUMBER_OF_TARGETS_TRACKED; vehicleIndex++) {
-			if (systemData.targetTracker[vehicleIndex].index != INVALID_VEHICLE_ENTRY) {
-				if (systemData.targetTracker[vehicleIndex].magnitude > maximum) {
-					maximum			= systemData.targetTracker[vehicleIndex].magnitude;
-					maximumIndex	= vehicleIndex;
-				}
-			}
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+void vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::sort(void) {
+	int i, j, slot;
+
+	for (i=1; i<MaxTargets; i++) {
+		slot = systemData.trackOrder[i];
+		for (j=i; (j > 0) &&
+			_isStrongerTrack(slot, systemData.trackOrder[j-1]); j--) {
+			systemData.trackOrder[j] = systemData.trackOrder[j-1];
 		}
-
-		// Store it away
-		memcpy(&_targetTracker[destinationIndex], &systemData.targetTracker[maximumIndex], sizeof(targetTrackingStructureType));
-
-		// Zero it so we won't find it again
-		_zeroVehicleTrack(&systemData.targetTracker[maximumIndex]);
-	}
-
-	// targetTracker is sorted, now write it back
-	for (vehicleIndex=0; vehicleIndex<MAX_NUMBER_OF_TARGETS_TRACKED; vehicleIndex++) {
-		memcpy(&systemData.targetTracker[vehicleIndex], &_targetTracker[vehicleIndex], sizeof(targetTrackingStructureType));
+		systemData.trackOrder[j] = slot;
 	}
 }
 
 //-------------------------------------------------------------------------------------------------
 // Adjust minimum noise level based on the number of vehicle tracks.
 //-------------------------------------------------------------------------------------------------
-static void _updateMinimumMagnitude(void) {
+template <int AnalyzerBins, int Bins, int MaxTargets, typename SampleT>
+void vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT>::updateMinimumMagnitude(void) {
 #ifndef SVR_COMPILE	// Skip for SVR
 	int i, counter;
-	float decrement;
+	_iq decrement;
 
 	counter = 0;
-	for (i=0; i<MAX_NUMBER_OF_TARGETS_TRACKED; i++) {
-		if (systemData.targetTracker[i].index != INVALID_VEHICLE_ENTRY) {
+	for (i=0; i<MaxTargets; i++) {
+		if (systemData.track.index[i] != INVALID_VEHICLE_ENTRY) {
 			counter++;
 		}
 	}
 
 	// Increase the minimum magnitude if our vehicle tracks are maxed out
-	if (counter>=(MAX_NUMBER_OF_TARGETS_TRACKED-2)) {
+	if (counter>=(MaxTargets-2)) {
 		// 50.0 represents the noisiest "good" antenna that we ever expect to have to work with
-		if (fftData.minimumMagnitude < 50.0) {
-			fftData.minimumMagnitude += 0.1;
+		if (fftData.minimumMagnitude < _IQ(50.0)) {
+			fftData.minimumMagnitude += _IQ(0.1);
 		}
 	}
 
 	// Reduce minimum magnitude if less than half the max vehicle tracks
 	if (counter == 0) {
 		// Faster recovery than the other way.  Subtracts 1/8 of present minimum.
-		decrement = fftData.minimumMagnitude*0.125;
+		decrement = _IQmpyIQ31(fftData.minimumMagnitude, _IQ31(0.125));
 		fftData.minimumMagnitude -= decrement;
-	} else if (counter<(MAX_NUMBER_OF_TARGETS_TRACKED/2)) {
-		if (fftData.minimumMagnitude > 0.0) {
-			fftData.minimumMagnitude -= 0.1;
+	} else if (counter<(MaxTargets/2)) {
+		if (fftData.minimumMagnitude > _IQ(0.0)) {
+			fftData.minimumMagnitude -= _IQ(0.1);
 		}
 	}
 #endif
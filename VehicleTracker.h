@@ -7,11 +7,19 @@
 #ifndef SLOPE_H
 #define SLOPE_H
 
-#ifdef USE_FFT_1024
-	#define FFT_OUTPUT_ARRAY_SIZE		512
-#else
-	#define FFT_OUTPUT_ARRAY_SIZE		128
-#endif
+// The largest analyzer output.  The FFT size is selected at runtime - see fftAnalyzer.h
+#define FFT_OUTPUT_ARRAY_SIZE		FFT1024_OUTPUT_SIZE
+
+// The quarter resolution tracker configuration for FFT1024 - see trackerConfiguration[]
+#define FAST_TRACKER_BINS			128
+#define FAST_TRACKER_TARGETS		((MAX_NUMBER_OF_TARGETS_TRACKED < 4) ? MAX_NUMBER_OF_TARGETS_TRACKED : 4)
+
+#include "binMask.h"
+#include "spectrumKernels.h"
+#include "spectrumIndex.h"
+#include "trackAssociation.h"
+#include "trackerPipeline.h"
+#include "frameQueue.h"
 
 #define DEFAULT_MINIMUM_MAGNITUDE	50.0
 #define MAX_TOWARDS_PHASE_DELTA		15.0
@@ -47,6 +55,10 @@
 #define MINIMUM_PEAK_DELTA			_IQ(FLOAT_MINIMUM_PEAK_DELTA)	// The shallowest slope on the FFT data that we'll recognize
 #define	MAXIMUM_PEAK_DELTA			_IQ(FLOAT_MAXIMUM_PEAK_DELTA)	// The upper end of the above
 #define MAX_DELTA_SEARCH			5
+#define MIN_TRACK_GATE				2		// Half width of the search gate at MAX_CONFIDENCE_LEVEL
+#define MAX_TRACK_GATE				MAX_DELTA_SEARCH	// Half width of the search gate with no confidence
+#define TRACK_ALPHA					0.5		// Alpha-beta index filter gains.  Beta = alpha^2/(2-alpha)
+#define TRACK_BETA					0.167	// for a critically damped response.
 #define MAX_SLOPE_COUNTER			2
 #define MAGNITUDE_DIVIDER_FOR_WIDTH	200000
 #define SAMPLE_START_LOCATION		1	//Start bin. Adjust for very low frequency built-in noise
@@ -59,22 +71,23 @@
 //-------------------------------------------------------------------------------------------------
 // Function Prototypes
 //-------------------------------------------------------------------------------------------------
-// Used in FFTProcessing only for filtering theta
-extern targetTrackingStructureType targetTracker[MAX_NUMBER_OF_TARGETS_TRACKED];
-
 typedef struct {
 	boolean initialized;
 	boolean busy;					// TRUE when the FFT process is in the middle of processing data
 	boolean runProcess;				// Set True to signal FFT to run.  Set FALSE by calling function.
-	int16_t fftOutputArray[FFT_OUTPUT_ARRAY_SIZE];
+	const int16_t *fftOutputArray;	// The spectrum the tracker searches - see _ingestSpectrum()
+	int numberOfBins;				// Bins in fftOutputArray for the selected tracker configuration
+	const spectrumFrameType *pFrame;	// The frame tracked last, all the analyzer's bins, or NULL
 	int16_t fftOutputArray_z[FFT_OUTPUT_ARRAY_SIZE];
 	int16_t fftOutputArrayNoise[FFT_OUTPUT_ARRAY_SIZE];
-	boolean binIsUnderInvestigation[FFT_OUTPUT_ARRAY_SIZE];
+	binMaskType binIsUnderInvestigation;
+	spectrumIndexType blockIndex;	// Block maxima of fftOutputArray, rebuilt with each frame
 	int	adcGainShift;
 	float frequency[MAX_NUMBER_OF_TARGETS_TRACKED];
 	int type;
 	float amplitude[MAX_NUMBER_OF_TARGETS_TRACKED];
-	float minimumMagnitude;
+	_iq minimumMagnitude;
+	int16_t newTrackThreshold;		// The smallest sample that can start a track - set by detect()
 } fftStructType;
 
 #ifdef GLOBAL
@@ -91,31 +104,38 @@ typedef struct {
 	struct {
 		int intitialized:1;
 	} flags;
+	const char *name;
+	int fftSize;					// The analyzer this configuration reads - see fftAnalyzer.h
+	int numberOfBins;				// Bins searched, at most the analyzer's output size
+	int maximumTargets;				// Targets tracked, at most MAX_NUMBER_OF_TARGETS_TRACKED
 	void (*open)(void);				// Initialize the structure
 	void (*reset)(void);
-	void (*findNewTracks)(void);
-	void (*processExistingTracks)(void);
-	void (*sort)(void);
-	void (*updateMinimumMagnitude)(void);
+	void (*processFrame)(const spectrumFrameType *);	// Runs the pipeline once per FFT - see trackerPipeline.h
+	const pipelineStageType *pipeline;
 	void (*simulate)(int);
 	void (*sideFiringAlgorithm)(void);
 	void (*findFrequency)(int);
 } targetTrackingType;
 
 extern targetTrackingType targetTracking;
-
-#define VEHICLE_TRACKING_STRUCT_DEFAULTS	\
-{								\
-	0,		/* flags */			\
-	_open,						\
-	_reset,						\
-	_findNewTracks,				\
-	_processExistingTracks,		\
-	_sort,						\
-	_updateMinimumMagnitude,	\
-	_simulate,					\
-	_sideFiringAlgorithm,		\
-	_findFrequency,				\
+extern const targetTrackingType trackerConfiguration[];
+extern const int numberOfTrackerConfigurations;
+
+// ENGINE is a vehicleTracker<AnalyzerBins, Bins, MaxTargets, SampleT> typedef
+#define VEHICLE_TRACKING_STRUCT_DEFAULTS(ENGINE)	\
+{										\
+	0,		/* flags */					\
+	#ENGINE,							\
+	ENGINE::analyzerBins*2,				\
+	ENGINE::numberOfBins,				\
+	ENGINE::maximumTargets,				\
+	ENGINE::open,						\
+	_reset,								\
+	ENGINE::processFrame,				\
+	ENGINE::pipeline,					\
+	_simulate,							\
+	_sideFiringAlgorithm,				\
+	_findFrequency,						\
 }
 
 // Tracking states
@@ -131,6 +151,7 @@ typedef enum {
 } sfrTrackingStateType;
 
 typedef struct {
+	U16 trackId;					// The track this state belongs to - see _sideFiringAlgorithm()
 	int index;
 	int index_z;
 	int magnitude;
@@ -142,12 +163,10 @@ typedef struct {
 	} confidence;
 } sfrDataType;
 
-extern sfrDataType sfrData[MAX_NUMBER_OF_TARGETS_TRACKED];
+extern sfrDataType sfrData[MAX_NUMBER_OF_TARGETS_TRACKED];	// Same slot as the track
 
-extern void _slowlyZeroVehicleTrack(int);
 extern void bringToZero(int *);
-extern void _findNewTracks(void);
-extern void _processExistingTracks(void);
+extern boolean selectTrackerConfiguration(int);
 extern void _sideFiringAlgorithm(void);
 extern void _findFrequency(int);
 
@@ -13,12 +13,15 @@
 #include <SD.h>
 #include "environ.h"
 
-#define N	FFT_OUTPUT_ARRAY_SIZE
+#define N	fftData.numberOfBins	// Bins searched by the selected tracker configuration
 
 sfrDataType sfrData[MAX_NUMBER_OF_TARGETS_TRACKED];
 
 //=================================================================================================
 // This function could be rewritten using the standard fftOutputArray.
+//
+// sfrData[i] follows the track in slot i of systemData.track, which keeps its slot while it
+// lives.  When a slot's track ID changes the slot holds a different vehicle and starts over.
 //=================================================================================================
 static boolean hasBeenInitialized = FALSE;
 void _sideFiringAlgorithm(void) {
@@ -31,25 +34,30 @@ void _sideFiringAlgorithm(void) {
 		hasBeenInitialized = TRUE;
 	}
 
-	for (i=0; i < MAX_NUMBER_OF_TARGETS_TRACKED; i++) {
-		if ((systemData.targetTracker[i].index != INVALID_VEHICLE_ENTRY) &&
-			(systemData.targetTracker[i].index > MIN_INDEX) &&
-			(systemData.targetTracker[i].magnitude > MIN_MAGNITUDE) &&
-			(systemData.targetTracker[i].trackCounter > MIN_TRACK)) {
+	for (i=0; i < targetTracking.maximumTargets; i++) {
+		if (sfrData[i].trackId != systemData.track.id[i]) {
+			memset(&sfrData[i], 0, sizeof(sfrDataType));
+			sfrData[i].trackId = systemData.track.id[i];
+		}
+
+		if ((systemData.track.index[i] != INVALID_VEHICLE_ENTRY) &&
+			(systemData.track.index[i] > MIN_INDEX) &&
+			(systemData.track.magnitude[i] > _IQ(MIN_MAGNITUDE)) &&
+			(systemData.track.trackCounter[i] > MIN_TRACK)) {
 			switch (sfrData[i].state) {
 			case SFR_INITIAL_STATE:
 				sfrData[i].state = SFR_WAITING_FOR_VEHICLE;
 			case SFR_WAITING_FOR_VEHICLE:
-				if (systemData.targetTracker[i].trackCounter > 2) {
-					sfrData[i].index = systemData.targetTracker[i].index; 
-					sfrData[i].magnitude = systemData.targetTracker[i].magnitude; 
+				if (systemData.track.trackCounter[i] > 2) {
+					sfrData[i].index = systemData.track.index[i]; 
+					sfrData[i].magnitude = _IQint(systemData.track.magnitude[i]); 
 
 					sfrData[i].state = SFR_FOUND_VEHICLE;
 				}
 				break;
 			case SFR_FOUND_VEHICLE:
 				// Looking for an increase in magnitude and a decrease in searchIndex
-				sfrData[i].index = systemData.targetTracker[i].index; 
+				sfrData[i].index = systemData.track.index[i]; 
 				if (sfrData[i].index <= sfrData[i].index_z) {
 					if (sfrData[i].confidence.index < MAX_CONFIDENCE) {
 						sfrData[i].confidence.index++;
@@ -60,7 +68,7 @@ void _sideFiringAlgorithm(void) {
 					}
 				}
 
-				sfrData[i].magnitude = systemData.targetTracker[i].magnitude; 
+				sfrData[i].magnitude = _IQint(systemData.track.magnitude[i]); 
 				if (sfrData[i].magnitude >= sfrData[i].magnitude_z) {
 					if (sfrData[i].confidence.magnitude < MAX_CONFIDENCE) {
 						sfrData[i].confidence.magnitude++;
@@ -94,7 +102,7 @@ void _sideFiringAlgorithm(void) {
 				break;
 			case SFR_TRACKING_AWAY:
 				// Looking for an decrease in magnitude and an increase in searchIndex
-				sfrData[i].index = systemData.targetTracker[i].index; 
+				sfrData[i].index = systemData.track.index[i]; 
 				if (sfrData[i].index >= sfrData[i].index_z) {
 					if (sfrData[i].confidence.index < MAX_CONFIDENCE) {
 						sfrData[i].confidence.index++;
@@ -105,7 +113,7 @@ void _sideFiringAlgorithm(void) {
 					}
 				}
 
-				sfrData[i].magnitude = systemData.targetTracker[i].magnitude; 
+				sfrData[i].magnitude = _IQint(systemData.track.magnitude[i]); 
 				if (sfrData[i].magnitude <= sfrData[i].magnitude_z) {
 					if (sfrData[i].confidence.magnitude < MAX_CONFIDENCE) {
 						sfrData[i].confidence.magnitude++;
@@ -149,74 +157,50 @@ void _sideFiringAlgorithm(void) {
 
 #define	SAMPLE_RATE_KHZ			44100
 #define SAMPLE_RATE_KHZ_LONG	44100l
-#define GAIN_ADJUSTMENT			1.0
-#define INDEX_PER_HZ			GAIN_ADJUSTMENT*(SAMPLE_RATE_KHZ/(FFT_OUTPUT_ARRAY_SIZE*2))
+#define GAIN_ADJUSTMENT			1
+#define INDEX_PER_HZ			GAIN_ADJUSTMENT*(SAMPLE_RATE_KHZ/(fftData.numberOfBins*2))
 #define FREQUENCY_GAIN			INDEX_PER_HZ
 #define	FREQUENCY_OFFSET		40.0
 #define	SPEED_OFFSET			0.0
+#define MAX_INTERPOLATION		3		// Bins either side of the index the filter below can reach
 
+//-------------------------------------------------------------------------------------------------
+// The peak's position is moved off the bin centre by the weighted slopes either side of it.  The
+// weights are 1/16, 1/8 and 1/4 and sum in 16ths as integers, so only the final ratio and the
+// gains are _iq.
+//-------------------------------------------------------------------------------------------------
 void _findFrequency(int index) {
-	float	result,
-			signalLevel,
-			temporary,
-			presentValue,
-			previousValue1,
-			previousValue2,
-			previousValue3,
-			nextValue1,
-			nextValue2,
-			nextValue3;
-	float	differenceArray[6];
-	float	ACsignalLevel,
-			ACsignalLevel_z;
-
-	if ((index > 0) && (index < (N - 3))) {
-		presentValue	= fftData.fftOutputArray[index];
+	int		presentValue,
+			weightedSum;
+	_iq		result,
+			temporary;
 
-		previousValue1	= fftData.fftOutputArray[index - 1];
-		previousValue2	= fftData.fftOutputArray[index - 2];
-		previousValue3	= fftData.fftOutputArray[index - 3];
-		nextValue1		= fftData.fftOutputArray[index + 1];
-		nextValue2		= fftData.fftOutputArray[index + 2];
-		nextValue3		= fftData.fftOutputArray[index + 3];
+	if ((index > 0) && (index < (N - 3)) && (fftData.fftOutputArray[index] > 0)) {
+		presentValue	= fftData.fftOutputArray[index];
 
 		// Sum differences * filter constant. K values must add to 1.0
-#ifdef OLD_VERSION
-		differenceArray[0] = -(presentValue - previousValue3) * 0.125;	// 1/8
-		differenceArray[1] = -(presentValue - previousValue2) * 0.25;	// 1/4
-		differenceArray[2] = -(presentValue - previousValue1) * 0.5;	// 1/2
-		differenceArray[3] = (presentValue - nextValue1) * 0.5;			// 1/2
-		differenceArray[4] = (presentValue - nextValue2) * 0.25;		// 1/4
-		differenceArray[5] = (presentValue - nextValue3) * 0.125;		// 1/8
-#else
-		differenceArray[0] = -(presentValue - previousValue3) * 1.0/16;
-		differenceArray[1] = -(presentValue - previousValue2) * 1.0/8;
-		differenceArray[2] = -(presentValue - previousValue1) * 1.0/4;
-		differenceArray[3] = (presentValue - nextValue1) * 1.0/4;
-		differenceArray[4] = (presentValue - nextValue2) * 1.0/8;
-		differenceArray[5] = (presentValue - nextValue3) * 1.0/16;
-#endif
+		weightedSum	=	-(presentValue - fftData.fftOutputArray[index - 3]) * 1 +
+						-(presentValue - fftData.fftOutputArray[index - 2]) * 2 +
+						-(presentValue - fftData.fftOutputArray[index - 1]) * 4 +
+						(presentValue - fftData.fftOutputArray[index + 1]) * 4 +
+						(presentValue - fftData.fftOutputArray[index + 2]) * 2 +
+						(presentValue - fftData.fftOutputArray[index + 3]) * 1;
 
 		// Find index
-		result		=	differenceArray[0] +
-						differenceArray[1] +
-						differenceArray[2] +
-						differenceArray[3] +
-						differenceArray[4] +
-						differenceArray[5];
-		temporary	= result/presentValue;
-		result		= index - temporary;
+		temporary	= _IQratio(weightedSum, presentValue * 16);
+		temporary	= _IQsat(temporary, _IQ(MAX_INTERPOLATION), _IQ(-MAX_INTERPOLATION));
+		result		= _IQfromInt(index) - temporary;
 
 		// Calculate frequency
-		systemData.frequency.value = (FREQUENCY_GAIN * result) + FREQUENCY_OFFSET;
+		systemData.frequency.value = _IQmpyI32(result, FREQUENCY_GAIN) + _IQ(FREQUENCY_OFFSET);
 
 		// Calculate speed
-		systemData.speed.value = SPEED_GAIN * systemData.frequency.value;
+		systemData.speed.value = _IQmpyIQ31(systemData.frequency.value, _IQ31(SPEED_GAIN));
 
 	} else {
-		systemData.frequency.value				= 0.0;
-		systemData.speed.value					= 0.0;
-		systemData.frequency.FFTsignalLevel		= 0.0;
+		systemData.frequency.value				= _IQ(0.0);
+		systemData.speed.value					= _IQ(0.0);
+		systemData.frequency.FFTsignalLevel		= _IQ(0.0);
 	}
 }
 
@@ -0,0 +1,122 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Bin Mask
+//
+// One bit per FFT output bin, packed 32 bins to a word.  Used to mark bins that are already
+// under investigation so that a peak is only claimed once per frame.  Range operations and the
+// free/marked searches work a word at a time.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef BIN_MASK_H
+#define BIN_MASK_H
+
+#define BIN_MASK_SIZE		FFT_OUTPUT_ARRAY_SIZE
+#define BIN_MASK_BITS		32
+#define BIN_MASK_SHIFT		5
+#define BIN_MASK_WORDS		((BIN_MASK_SIZE+BIN_MASK_BITS-1)/BIN_MASK_BITS)
+#define BIN_MASK_ALL		0xFFFFFFFF
+
+typedef struct {
+	U32 word[BIN_MASK_WORDS];
+} binMaskType;
+
+//-------------------------------------------------------------------------------------------------
+static inline void binMaskClear(binMaskType *pMask) {
+	memset(pMask, 0, sizeof(binMaskType));
+}
+
+//-------------------------------------------------------------------------------------------------
+static inline boolean binMaskIsMarked(const binMaskType *pMask, int bin) {
+	return((pMask->word[bin >> BIN_MASK_SHIFT] >> (bin & (BIN_MASK_BITS-1))) & 1);
+}
+
+//-------------------------------------------------------------------------------------------------
+static inline void binMaskMark(binMaskType *pMask, int bin) {
+	pMask->word[bin >> BIN_MASK_SHIFT] |= (U32)1 << (bin & (BIN_MASK_BITS-1));
+}
+
+//-------------------------------------------------------------------------------------------------
+// The 32 mask bits starting at bin, with bin in the lowest bit.  Bins past the end read as free.
+//-------------------------------------------------------------------------------------------------
+static inline U32 binMaskGetBits(const binMaskType *pMask, int bin) {
+	int word	= bin >> BIN_MASK_SHIFT;
+	int shift	= bin & (BIN_MASK_BITS-1);
+	U32 bits;
+
+	bits = pMask->word[word] >> shift;
+	if ((shift != 0) && ((word+1) < BIN_MASK_WORDS)) {
+		bits |= pMask->word[word+1] << (BIN_MASK_BITS - shift);
+	}
+	return(bits);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Marks startBin up to but not including endBin
+//-------------------------------------------------------------------------------------------------
+static inline void binMaskMarkRange(binMaskType *pMask, int startBin, int endBin) {
+	int firstWord, lastWord, word;
+	U32 firstBits, lastBits;
+
+	if (startBin < 0) {
+		startBin = 0;
+	}
+	if (endBin > BIN_MASK_SIZE) {
+		endBin = BIN_MASK_SIZE;
+	}
+	if (startBin >= endBin) {
+		return;
+	}
+
+	firstWord	= startBin >> BIN_MASK_SHIFT;
+	lastWord	= (endBin-1) >> BIN_MASK_SHIFT;
+	firstBits	= BIN_MASK_ALL << (startBin & (BIN_MASK_BITS-1));
+	lastBits	= BIN_MASK_ALL >> ((BIN_MASK_BITS-1) - ((endBin-1) & (BIN_MASK_BITS-1)));
+
+	if (firstWord == lastWord) {
+		pMask->word[firstWord] |= firstBits & lastBits;
+	} else {
+		pMask->word[firstWord] |= firstBits;
+		for (word=firstWord+1; word<lastWord; word++) {
+			pMask->word[word] = BIN_MASK_ALL;
+		}
+		pMask->word[lastWord] |= lastBits;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// First bin at or after bin whose bit equals the requested state.  invert is 0 to find a marked
+// bin and BIN_MASK_ALL to find a free one.  Returns BIN_MASK_SIZE when there is none.
+//-------------------------------------------------------------------------------------------------
+static inline int _binMaskFind(const binMaskType *pMask, int bin, U32 invert) {
+	int word;
+	U32 bits;
+
+	if (bin >= BIN_MASK_SIZE) {
+		return(BIN_MASK_SIZE);
+	}
+
+	word	= bin >> BIN_MASK_SHIFT;
+	bits	= (pMask->word[word] ^ invert) & (BIN_MASK_ALL << (bin & (BIN_MASK_BITS-1)));
+	while (bits == 0) {
+		if (++word >= BIN_MASK_WORDS) {
+			return(BIN_MASK_SIZE);
+		}
+		bits = pMask->word[word] ^ invert;
+	}
+
+	bin = (word << BIN_MASK_SHIFT) + __builtin_ctz(bits);
+	return((bin < BIN_MASK_SIZE) ? bin : BIN_MASK_SIZE);
+}
+
+static inline int binMaskNextFree(const binMaskType *pMask, int bin) {
+	return(_binMaskFind(pMask, bin, BIN_MASK_ALL));
+}
+
+static inline int binMaskNextMarked(const binMaskType *pMask, int bin) {
+	return(_binMaskFind(pMask, bin, 0));
+}
+
+#endif   /* #ifndef BIN_MASK_H */
+
+/*********************************** End of File ******************************************************/
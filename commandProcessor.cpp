@@ -10,6 +10,14 @@
 
 // Local processing functions
 void processSP(void);
+void processFFT(void);
+void processStream(void);
+void processReplay(void);
+void processProfile(void);
+void processHealth(void);
+void processTrace(void);
+void processUnit(void);
+void processLog(void);
 
 
 #define TOKENS			" ,:"
@@ -20,6 +28,14 @@ void processSP(void);
 typedef enum {
 	CMD_OK,					// Does nothing, must be the first in the list.
 	CMD_SP,					// Serial Protocol
+	CMD_FFT,				// FFT size
+	CMD_STREAM,				// Spectrum stream settings
+	CMD_REPLAY,				// Replay a recording from the SD card
+	CMD_PROFILE,			// Cycle counts of each stage
+	CMD_HEALTH,				// Lost frames and audio headroom
+	CMD_TRACE,				// Dumps the event trace
+	CMD_UNIT,				// Address for poll queries
+	CMD_LOG,				// Data log status, or stop it
 	CMD_HELP				// Lists all commands.  Must be the last in this list.
 } commandEnumType;
 #define NUMBER_OF_COMMANDS	(CMD_HELP+1)
@@ -36,6 +52,14 @@ const commandType commands[NUMBER_OF_COMMANDS] = {
 	// index,					command
 	{CMD_OK,					"ok"},
 	{CMD_SP,					"s"},
+	{CMD_FFT,					"fft"},
+	{CMD_STREAM,				"stream"},
+	{CMD_REPLAY,				"replay"},
+	{CMD_PROFILE,				"profile"},
+	{CMD_HEALTH,				"health"},
+	{CMD_TRACE,					"trace"},
+	{CMD_UNIT,					"unit"},
+	{CMD_LOG,					"log"},
 
 	// Status or Help Only
 	{CMD_HELP,					"help"},
@@ -54,17 +78,13 @@ ErrorCodeIntType processCommands(void) {
 	int i, j;
 	boolean matchWasFound = FALSE;
 	ErrorCodeIntType returnCode = EMPTY_BUFFER;
-	char *pLocal;
-	char ch;
-	U32 temp32;
-	U8 *p8;
 	char *pCommand;
 	int value;
 
 	memset(returnDataBuffer, 0, sizeof(returnDataBuffer));
 	for (i=0; i<RS232_BUFFER_SIZE; i++) {
 		value = serialPort.read();
-		if (value != NULL) {
+		if (value != 0) {
 			returnDataBuffer[i] = value;
 		} else {
 			break;
@@ -77,7 +97,7 @@ ErrorCodeIntType processCommands(void) {
 	// Initialize local variables, then find the command
 	//-----------------------------------------------------------------------------------------
 	matchWasFound = FALSE;
-	pLocal = strtok(pCommand, TOKENS_ALLOW_SPACES);
+	strtok(pCommand, TOKENS_ALLOW_SPACES);		// The handlers take the rest with strtok(NULL, ...)
 
 	for (i=0; (i<NUMBER_OF_COMMANDS) && (matchWasFound == FALSE); i++) {
 		if ((strlen(commands[i].idString) == strlen(pCommand)) && 
@@ -99,6 +119,38 @@ ErrorCodeIntType processCommands(void) {
 				Serial.print("Serial Protocol");
 				processSP();
 				break;
+			case CMD_FFT:
+				Serial.print("FFT Size");
+				processFFT();
+				break;
+			case CMD_STREAM:
+				Serial.print("Spectrum Stream");
+				processStream();
+				break;
+			case CMD_REPLAY:
+				Serial.print("Replay");
+				processReplay();
+				break;
+			case CMD_PROFILE:
+				Serial.println("Profile");
+				processProfile();
+				break;
+			case CMD_HEALTH:
+				Serial.println("Health");
+				processHealth();
+				break;
+			case CMD_TRACE:
+				Serial.println("Trace");
+				processTrace();
+				break;
+			case CMD_UNIT:
+				Serial.print("Unit");
+				processUnit();
+				break;
+			case CMD_LOG:
+				Serial.println("Log");
+				processLog();
+				break;
 			default:
 				returnCode = FAIL;
 				break;
@@ -129,6 +181,164 @@ void processSP(void) {
 	};
 }
 
+//===========================================================================
+// "fft,256" or "fft,1024" selects the analyzer.  "fft" alone reports the present one.
+//===========================================================================
+void processFFT(void) {
+	char *pLocal;
+
+	pLocal = strtok(NULL, TOKENS_ALLOW_SPACES);
+	if (pLocal != NULL) {
+		Serial.print(":");
+		Serial.print(pLocal);
+		if (selectFFTSize(atoi(pLocal)) != TRUE) {
+			Serial.print(" not available");
+		}
+	}
+	Serial.print(", ");
+	Serial.print(fftAnalyzer.name);
+	Serial.print(", ");
+	Serial.print(targetTracking.name);
+}
+
+//===========================================================================
+// "stream,first,bins,decimation,floor" sets the SP_SPECTRUM_STREAM bin range, max-hold frames and
+// noise floor.  Fields left off keep their values.  "stream" alone reports them.
+//===========================================================================
+void processStream(void) {
+	char *pLocal;
+
+	if ((pLocal = strtok(NULL, TOKENS_ALLOW_SPACES)) != NULL) {
+		spectrumStream.firstBin = atoi(pLocal);
+	}
+	if ((pLocal = strtok(NULL, TOKENS_ALLOW_SPACES)) != NULL) {
+		spectrumStream.numberOfBins = atoi(pLocal);
+	}
+	if ((pLocal = strtok(NULL, TOKENS_ALLOW_SPACES)) != NULL) {
+		spectrumStream.decimation = atoi(pLocal);
+	}
+	if ((pLocal = strtok(NULL, TOKENS_ALLOW_SPACES)) != NULL) {
+		spectrumStream.noiseFloor = atoi(pLocal);
+	}
+	if (spectrumStream.firstBin < 0) {
+		spectrumStream.firstBin = 0;
+	}
+	if (spectrumStream.numberOfBins < 0) {
+		spectrumStream.numberOfBins = 0;
+	}
+	if ((spectrumStream.decimation < 1) || (spectrumStream.decimation > 255)) {
+		spectrumStream.decimation = 1;
+	}
+	spectrumStreamRestart();
+
+	Serial.print(": first ");
+	Serial.print(spectrumStream.firstBin);
+	Serial.print(", bins ");
+	Serial.print(spectrumStream.numberOfBins);
+	Serial.print(", decimation ");
+	Serial.print(spectrumStream.decimation);
+	Serial.print(", floor ");
+	Serial.print(spectrumStream.noiseFloor);
+}
+
+//===========================================================================
+// "replay,file" runs the recording through the tracker in place of the analyzer (see replay.h).
+// "replay" alone stops one that is running, and reports how it went.
+//===========================================================================
+void processReplay(void) {
+	char *pLocal;
+
+	pLocal = strtok(NULL, TOKENS_ALLOW_SPACES);
+	if (pLocal != NULL) {
+		Serial.print(":");
+		Serial.print(pLocal);
+		if (replayOpen(pLocal) != TRUE) {
+			Serial.print(" not found");
+		}
+		return;
+	}
+	if (replay.active) {
+		replayClose();
+		Serial.print(" stopped");
+	}
+	replayReport();
+}
+
+//===========================================================================
+// "profile" reports the cycle counts with their histograms, "profile,reset" starts them again.
+//===========================================================================
+void processProfile(void) {
+	char *pLocal;
+
+	pLocal = strtok(NULL, TOKENS_ALLOW_SPACES);
+	if ((pLocal != NULL) && (strcmp(pLocal, "reset") == 0)) {
+		profileReset();
+		Serial.print("reset");
+		return;
+	}
+#ifdef USE_PROFILING
+	profileReport(TRUE);
+#else
+	Serial.print("not built in");
+#endif
+}
+
+//===========================================================================
+void processHealth(void) {
+	char *pLocal;
+
+	pLocal = strtok(NULL, TOKENS_ALLOW_SPACES);
+	if ((pLocal != NULL) && (strcmp(pLocal, "reset") == 0)) {
+		healthReset();
+		Serial.print("reset");
+		return;
+	}
+	healthReport();
+}
+
+//===========================================================================
+void processTrace(void) {
+#ifdef USE_TRACING
+	char *pLocal;
+
+	pLocal = strtok(NULL, TOKENS_ALLOW_SPACES);
+	if ((pLocal != NULL) && (strcmp(pLocal, "stop") == 0)) {
+		trace.stopped = TRUE;
+		Serial.print("stopped");
+	} else if ((pLocal != NULL) && (strcmp(pLocal, "start") == 0)) {
+		traceReset();
+		Serial.print("started");
+	} else {
+		traceDump();
+	}
+#else
+	Serial.print("not built in");
+#endif
+}
+
+//===========================================================================
+void processUnit(void) {
+	char *pLocal;
+
+	pLocal = strtok(NULL, TOKENS_ALLOW_SPACES);
+	if (pLocal != NULL) {
+		pollState.unitAddress = (U16)atoi(pLocal);
+	}
+	Serial.print(":");
+	Serial.print(pollState.unitAddress);
+}
+
+//===========================================================================
+void processLog(void) {
+	char *pLocal;
+
+	pLocal = strtok(NULL, TOKENS_ALLOW_SPACES);
+	if ((pLocal != NULL) && (strcmp(pLocal, "stop") == 0)) {
+		dataLogClose();
+	}
+	dataLogReport();
+}
+
 //===========================================================================
 // No more.
 //===========================================================================
@@ -0,0 +1,334 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Data Logger
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+#include <SD.h>
+
+#if ((DATALOG_BUFFER_BLOCKS & (DATALOG_BUFFER_BLOCKS - 1)) != 0)
+	#error DATALOG_BUFFER_BLOCKS has to be a power of two
+#endif
+
+#define BLOCK_SLOT(count)		dataLog.block[(count) & (DATALOG_BUFFER_BLOCKS - 1)]
+#define BLOCK_PAYLOAD			(DATALOG_BLOCK_SIZE - DATALOG_BLOCK_HEADER_SIZE)
+
+dataLogType dataLog;
+
+static void _startBlock(void);
+static void _putU8(U8);
+static void _putU16(U16);
+static void _putU32(U32);
+static boolean _beginRecord(dataLogRecordType, int);
+
+//-------------------------------------------------------------------------------------------------
+// Blocks
+//-------------------------------------------------------------------------------------------------
+static void _startBlock(void) {
+	U8 *pBlock = BLOCK_SLOT(dataLog.head);
+
+	pBlock[0]	= DATALOG_BLOCK_MAGIC & 0xFF;
+	pBlock[1]	= DATALOG_BLOCK_MAGIC >> 8;
+	pBlock[2]	= DATALOG_NO_RECORD & 0xFF;
+	pBlock[3]	= DATALOG_NO_RECORD >> 8;
+	pBlock[4]	= dataLog.head & 0xFF;
+	pBlock[5]	= (dataLog.head >> 8) & 0xFF;
+	pBlock[6]	= (dataLog.head >> 16) & 0xFF;
+	pBlock[7]	= dataLog.head >> 24;
+	dataLog.fill = DATALOG_BLOCK_HEADER_SIZE;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Only after _beginRecord() found room, so a full block always has a free one after it
+//-------------------------------------------------------------------------------------------------
+static void _putU8(U8 value) {
+	BLOCK_SLOT(dataLog.head)[dataLog.fill++] = value;
+	if (dataLog.fill == DATALOG_BLOCK_SIZE) {
+		dataLog.head++;
+		_startBlock();
+	}
+}
+
+static void _putU16(U16 value) {
+	_putU8(value & 0xFF);
+	_putU8(value >> 8);
+}
+
+static void _putU32(U32 value) {
+	_putU16(value & 0xFFFF);
+	_putU16(value >> 16);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Returns FALSE, and counts the record as dropped, if the blocks waiting, or what is left of the
+// preallocation, leave no room for it.  The room has to be more than the record, or a record
+// ending a block could start a block on top of the oldest one waiting, or past the end.
+//-------------------------------------------------------------------------------------------------
+static boolean _beginRecord(dataLogRecordType type, int payloadLength) {
+	U8 *pBlock;
+	U32 spare;
+	int room;
+
+	dataLog.recordSequence++;
+	if (dataLog.pSink == NULL) {
+		dataLog.recordsDropped++;
+		return(FALSE);
+	}
+	spare = DATALOG_BUFFER_BLOCKS - 1 - (dataLog.head - dataLog.tail);
+	if ((dataLog.capacity - 1 - dataLog.head) < spare) {
+		spare = dataLog.capacity - 1 - dataLog.head;
+	}
+	room = (DATALOG_BLOCK_SIZE - dataLog.fill) + (spare * BLOCK_PAYLOAD);
+	if ((DATALOG_RECORD_HEADER_SIZE + payloadLength) >= room) {
+		if (spare == (dataLog.capacity - 1 - dataLog.head)) {
+			dataLog.full = TRUE;
+		}
+		dataLog.recordsDropped++;
+		return(FALSE);
+	}
+
+	pBlock = BLOCK_SLOT(dataLog.head);
+	if ((pBlock[2] == (DATALOG_NO_RECORD & 0xFF)) && (pBlock[3] == (DATALOG_NO_RECORD >> 8))) {
+		pBlock[2] = dataLog.fill & 0xFF;
+		pBlock[3] = dataLog.fill >> 8;
+	}
+	_putU8(type);
+	_putU8(0);
+	_putU16(payloadLength);
+	_putU32(dataLog.recordSequence - 1);
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Opens the sink and starts the log with a DATALOG_HEADER.  The log holds preallocateBlocks at
+// most.  Returns FALSE if the sink couldn't be opened; records are then only counted.
+//-------------------------------------------------------------------------------------------------
+boolean dataLogOpen(const dataLogSinkType *pSink, const char *pName, U32 preallocateBlocks) {
+	memset(&dataLog, 0, sizeof(dataLog));
+	dataLog.records		= DATALOG_LOG_SPECTRA | DATALOG_LOG_TRACKS | DATALOG_LOG_COUNTS;
+	dataLog.lastCounter	= systemData.statistics.counter;
+	dataLog.capacity	= preallocateBlocks;
+	_startBlock();
+	if ((preallocateBlocks < 2) || !pSink->open(pName, preallocateBlocks)) {
+		return(FALSE);
+	}
+	dataLog.pSink		= pSink;
+	dataLog.lastFlush	= millis();
+
+	_beginRecord(DATALOG_HEADER, 8);
+	_putU8('V');
+	_putU8('T');
+	_putU8('L');
+	_putU8('G');
+	_putU16(DATALOG_VERSION);
+	_putU16(DATALOG_BLOCK_SIZE);
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Pads out the block being filled and writes everything waiting.  This one does wait on the sink.
+// The last block is always inside the preallocation - see _beginRecord().
+//-------------------------------------------------------------------------------------------------
+void dataLogClose(void) {
+	if (dataLog.pSink == NULL) {
+		return;
+	}
+	if (dataLog.fill > DATALOG_BLOCK_HEADER_SIZE) {
+		memset(&BLOCK_SLOT(dataLog.head)[dataLog.fill], DATALOG_PADDING, DATALOG_BLOCK_SIZE - dataLog.fill);
+		dataLog.head++;
+		_startBlock();
+	}
+	while ((dataLog.pSink != NULL) && (dataLog.tail != dataLog.head)) {
+		dataLogService();
+	}
+	if (dataLog.pSink != NULL) {
+		dataLog.pSink->close();
+		dataLog.pSink = NULL;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Called from loop() with each frame, after the tracker has run on it
+//-------------------------------------------------------------------------------------------------
+void dataLogFrame(const spectrumFrameType *pFrame) {
+	int i, order, slot, count;
+
+	if ((dataLog.records & DATALOG_LOG_SPECTRA) &&
+		_beginRecord(DATALOG_SPECTRUM, 10 + (2 * pFrame->numberOfBins))) {
+		_putU32(pFrame->sequence);
+		_putU32(millis());
+		_putU16(pFrame->numberOfBins);
+		for (i=0; i<pFrame->numberOfBins; i++) {
+			_putU16(pFrame->output[i]);
+		}
+	}
+
+	if (dataLog.records & DATALOG_LOG_TRACKS) {
+		count = 0;
+		for (slot=0; slot<targetTracking.maximumTargets; slot++) {
+			if (systemData.track.index[slot] != INVALID_VEHICLE_ENTRY) {
+				count++;
+			}
+		}
+		if (_beginRecord(DATALOG_TRACKS, 5 + (9 * count))) {
+			_putU32(pFrame->sequence);
+			_putU8(count);
+			for (order=0; order<targetTracking.maximumTargets; order++) {
+				slot = systemData.trackOrder[order];
+				if (systemData.track.index[slot] == INVALID_VEHICLE_ENTRY) {
+					continue;
+				}
+				_putU16(systemData.track.id[slot]);
+				_putU16(systemData.track.index[slot]);
+				_putU16(_IQint(systemData.track.magnitude[slot]));
+				_putU8(systemData.track.confidence.magnitude[slot]);
+				_putU16(systemData.track.trackCounter[slot]);
+			}
+		}
+	}
+
+	if ((dataLog.records & DATALOG_LOG_COUNTS) && (dataLog.lastCounter != systemData.statistics.counter)) {
+		dataLog.lastCounter = systemData.statistics.counter;
+		if (_beginRecord(DATALOG_COUNTS, 20)) {
+			_putU32(millis());
+			_putU32(systemData.statistics.counter);
+			_putU32(frameQueue.sequence);
+			_putU32(frameQueue.overruns);
+			_putU32(dataLog.recordsDropped);
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Writes the oldest full block, if there is one, or flushes the sink when it is due.  Called from
+// the idle branch of loop(), so a slow card delays the next pass and never a frame.
+//-------------------------------------------------------------------------------------------------
+void dataLogService(void) {
+	if (dataLog.pSink == NULL) {
+		return;
+	}
+	if (dataLog.tail == dataLog.head) {
+		if ((dataLog.blocksSinceFlush != 0) && ((millis() - dataLog.lastFlush) >= DATALOG_FLUSH_MS)) {
+			dataLog.pSink->flush();
+			dataLog.flushes++;
+			dataLog.blocksSinceFlush	= 0;
+			dataLog.lastFlush			= millis();
+		}
+		return;
+	}
+
+	if (dataLog.pSink->write(BLOCK_SLOT(dataLog.tail), dataLog.tail)) {
+		dataLog.blocksWritten++;
+		dataLog.consecutiveFailures = 0;
+		if (++dataLog.blocksSinceFlush >= DATALOG_FLUSH_BLOCKS) {
+			dataLog.pSink->flush();
+			dataLog.flushes++;
+			dataLog.blocksSinceFlush	= 0;
+			dataLog.lastFlush			= millis();
+		}
+	} else {
+		dataLog.blocksFailed++;
+		if (++dataLog.consecutiveFailures >= DATALOG_MAXIMUM_FAILURES) {
+			dataLog.pSink->close();
+			dataLog.pSink = NULL;			// Only counting from now on
+		}
+	}
+	dataLog.tail++;
+}
+
+//-------------------------------------------------------------------------------------------------
+// One line for the "log" command
+//-------------------------------------------------------------------------------------------------
+void dataLogReport(void) {
+	static lineBufferType line;
+
+	lineBegin(&line);
+	linePutString(&line, (dataLog.pSink != NULL) ? "Logging, " : "Not logging, ");
+	linePutUnsigned(&line, dataLog.blocksWritten);
+	linePutChar(&line, '/');
+	linePutUnsigned(&line, dataLog.capacity);
+	linePutString(&line, " blocks, ");
+	linePutUnsigned(&line, dataLog.blocksFailed);
+	linePutString(&line, " failed, ");
+	linePutUnsigned(&line, dataLog.recordsDropped);
+	linePutString(&line, " records dropped");
+	if (dataLog.full) {
+		linePutString(&line, ", full");
+	}
+	lineEnd(&line);
+}
+
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// File sink, through the SD library (on the host, a file in the working directory)
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+static File logFile;
+static U32 logFileBlock;				// Where the file is positioned, in blocks
+
+//-------------------------------------------------------------------------------------------------
+// Any old log is removed, and the new one written full of zeros up front so the card has the
+// clusters, and the directory entry its size, before tracking starts.  The log never outgrows
+// them.  A card too small for all of them fails the open.
+//-------------------------------------------------------------------------------------------------
+static boolean _fileOpen(const char *pName, U32 preallocateBlocks) {
+	static const U8 zeros[DATALOG_BLOCK_SIZE] = {0};
+	U32 block;
+
+	if (SD.exists(pName)) {
+		SD.remove(pName);
+	}
+	logFile = SD.open(pName, FILE_WRITE);
+	if (!logFile) {
+		return(FALSE);
+	}
+	for (block=0; block<preallocateBlocks; block++) {
+		if (logFile.write(zeros, DATALOG_BLOCK_SIZE) != DATALOG_BLOCK_SIZE) {
+			break;
+		}
+	}
+	logFile.flush();
+	logFileBlock = 0;
+	if ((block != preallocateBlocks) || !logFile.seek(0)) {
+		logFile.close();
+		return(FALSE);
+	}
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+static boolean _fileWrite(const U8 *pBlock, U32 number) {
+	if (number != logFileBlock) {
+		if (!logFile.seek(number * DATALOG_BLOCK_SIZE)) {
+			return(FALSE);
+		}
+		logFileBlock = number;
+	}
+	if (logFile.write(pBlock, DATALOG_BLOCK_SIZE) != DATALOG_BLOCK_SIZE) {
+		logFileBlock = 0xFFFFFFFF;				// Unknown, so seek before the next one
+		return(FALSE);
+	}
+	logFileBlock++;
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+static void _fileFlush(void) {
+	logFile.flush();
+}
+
+//-------------------------------------------------------------------------------------------------
+static void _fileClose(void) {
+	logFile.close();
+}
+
+const dataLogSinkType dataLogFileSink = {
+	"file",
+	_fileOpen,
+	_fileWrite,
+	_fileFlush,
+	_fileClose,
+};
+
+/*---- End Of File ----*/
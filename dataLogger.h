@@ -0,0 +1,121 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Data Logger
+//
+// An append-only binary log of what the tracker saw, for USE_DATALOGGING.  loop() adds records
+// with dataLogFrame(); they are packed into 512-byte blocks in RAM, and dataLogService() hands at
+// most one full block to the sink per call, from the idle branch of loop().  Nothing waits on the
+// card: a record that doesn't fit in the blocks waiting is dropped and counted, a block the sink
+// fails to write is counted and skipped, and after DATALOG_MAXIMUM_FAILURES failures in a row the
+// log stops and only counts.
+//
+// The file is preallocated when it is opened, DATALOG_PREALLOCATE_MB of it, and every write is one
+// whole block at a multiple of 512 bytes, so the card never has to read-modify-write or extend the
+// file while tracking.  The log never goes past the preallocation: once it is full, full is set
+// and every record after is dropped and counted.  The sink is flushed every DATALOG_FLUSH_BLOCKS
+// blocks or DATALOG_FLUSH_MS, whichever comes first, so a power cut loses at most that much.  The
+// file's size was set by the preallocation, so the directory entry never needs updating.
+//
+// "log" reports on the serial port and "log,stop" closes the log.
+//
+// Block, DATALOG_BLOCK_SIZE bytes:
+//	U16 magic			DATALOG_BLOCK_MAGIC.  Anything else is preallocated space, or a block
+//						the sink failed to write, and is skipped.
+//	U16 first record	Offset in the block of the first record that starts in it, or
+//						DATALOG_NO_RECORD.  After a lost block a reader starts again here.
+//	U32 block sequence	0 for the first block.  A gap is a block the sink failed to write.
+//	records				A record can carry on into the next block.  Type 0 pads to the end.
+//
+// Record, little-endian:
+//	U8 type, U8 0, U16 payload length, U32 record sequence, then the payload.  The record sequence
+//	goes up by one for each record, dropped ones too.
+//
+//	DATALOG_HEADER		U8[4] "VTLG", U16 version, U16 block size.  The first record.
+//	DATALOG_SPECTRUM	U32 frame sequence, U32 millis, U16 numberOfBins, numberOfBins of U16.
+//						The analyzer output the tracker was given.
+//	DATALOG_TRACKS		U32 frame sequence, then the TELEMETRY_TRACKS payload
+//	DATALOG_COUNTS		U32 millis, U32 vehicles counted, U32 FFTs, U32 frame queue overruns,
+//						U32 log records dropped.  When a vehicle is counted.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef DATA_LOGGER_H
+#define DATA_LOGGER_H
+
+#define DATALOG_FILE_NAME				"datalog.bin"
+#define DATALOG_BLOCK_SIZE				512
+#define DATALOG_BLOCK_HEADER_SIZE		8
+#define DATALOG_RECORD_HEADER_SIZE		8
+#define DATALOG_BLOCK_MAGIC				0x4C56		// "VL"
+#define DATALOG_NO_RECORD				0xFFFF
+#define DATALOG_VERSION					1
+#ifndef DATALOG_BUFFER_BLOCKS
+	#define DATALOG_BUFFER_BLOCKS		8			// Has to be a power of two
+#endif
+#ifndef DATALOG_PREALLOCATE_MB
+	#define DATALOG_PREALLOCATE_MB		4			// About a minute of FFT1024 spectra.  Written at startup.
+#endif
+#define DATALOG_PREALLOCATE_BLOCKS		(DATALOG_PREALLOCATE_MB * 1024L * 1024 / DATALOG_BLOCK_SIZE)
+#define DATALOG_MAXIMUM_FAILURES		8
+#define DATALOG_FLUSH_BLOCKS			128
+#define DATALOG_FLUSH_MS				1000
+
+typedef enum {
+	DATALOG_PADDING,
+	DATALOG_HEADER,
+	DATALOG_SPECTRUM,
+	DATALOG_TRACKS,
+	DATALOG_COUNTS,
+} dataLogRecordType;
+
+// What dataLogFrame() logs
+#define DATALOG_LOG_SPECTRA				0x01
+#define DATALOG_LOG_TRACKS				0x02
+#define DATALOG_LOG_COUNTS				0x04
+
+// Where the blocks go.  Each call gets the block's number, so after a failure the sink can seek
+// back to where the next one belongs.
+typedef struct {
+	const char *name;
+	boolean (*open)(const char *, U32);		// Name, blocks to preallocate
+	boolean (*write)(const U8 *, U32);		// One DATALOG_BLOCK_SIZE block, and its number
+	void (*flush)(void);					// Everything written so far onto the card
+	void (*close)(void);
+} dataLogSinkType;
+
+typedef struct {
+	const dataLogSinkType *pSink;			// NULL while the log is closed
+	U8 records;								// DATALOG_LOG_...
+	U32 recordSequence;
+	int lastCounter;						// systemData.statistics.counter at the last DATALOG_COUNTS
+
+	// Blocks.  head is being filled, head - tail are full and waiting for the sink.
+	U32 head;
+	U32 tail;
+	int fill;								// Bytes used in block[head]
+	int consecutiveFailures;
+	U32 capacity;							// Blocks preallocated.  head never gets to it.
+	boolean full;
+	U32 blocksSinceFlush;
+	U32 lastFlush;							// millis()
+
+	U32 blocksWritten;
+	U32 flushes;
+	U32 blocksFailed;
+	U32 recordsDropped;
+
+	U8 block[DATALOG_BUFFER_BLOCKS][DATALOG_BLOCK_SIZE];
+} dataLogType;
+
+extern dataLogType dataLog;
+extern const dataLogSinkType dataLogFileSink;
+
+extern boolean dataLogOpen(const dataLogSinkType *, const char *, U32);
+extern void dataLogClose(void);
+extern void dataLogFrame(const spectrumFrameType *);
+extern void dataLogService(void);
+extern void dataLogReport(void);
+
+#endif   /* #ifndef DATA_LOGGER_H */
+
+/*********************************** End of File ******************************************************/
@@ -10,10 +10,13 @@
 
 //#define USE_DATALOGGING
 
-//#define USE_FFT_256	// 345 FFT's/second
-#ifndef USE_FFT_256
-	#define USE_FFT_1024	// 69 FFT's/second
-#endif
+//#define USE_FFT_256	// Start up on FFT256 (345 FFT's/second) rather than FFT1024 (69 FFT's/second)
+
+//#define USE_FIXED_POINT	// Integer only tracker for parts without an FPU - see fixedPoint.h
+
+//#define USE_TRACING	// Ring of timed events, for a Chrome trace - see eventTrace.h
+
+//#define USE_PROFILING	// Cycle counts of each stage - see profiler.h
 
 typedef struct {
 	int millisecond;
@@ -98,6 +101,8 @@ enum {
 #include <time.h>
 #include <math.h>
 
+#include "fixedPoint.h"
+
 #ifndef FALSE
 	#define FALSE				0
 	#define TRUE				1
@@ -128,31 +133,48 @@ typedef struct {
 	int counter;
 } statisticsType;
 
+//-------------------------------------------------------------------------------------------------
+// Track store
+//
+// One array per field, indexed by slot, so the per-frame updates run down whole columns.  The
+// fields every frame touches for every track are kept apart from the direction fields, which are
+// only touched for a track that was found.  A slot is free while its index is INVALID_VEHICLE_ENTRY.
+//-------------------------------------------------------------------------------------------------
+#ifndef MAX_NUMBER_OF_TARGETS_TRACKED
+	#define MAX_NUMBER_OF_TARGETS_TRACKED	4	// Was 10 before 2007-03-13
+#endif
+
 typedef struct {
-	int index;								// fftOutputArray index
-	float magnitude;
 	float magnitude_z;
 	int	direction;
-	int	directionCounter;
 	float	theta[NUMBER_OF_CHANNELS];
 	float	theta_z[NUMBER_OF_CHANNELS];
 	float	deltaTheta;						// The difference between the left and right theta's
 	float	deltaTheta_z;
 	float	deltaDeltaTheta;				// The change in the delta theta
 	boolean directionIsLocked;
-	int trackCounter;						// Increments when a vehicle is found again.
 	int deltaIndex;							// The difference between the present and previous track indexes
+} trackColdType;
+
+typedef struct {
+	int index[MAX_NUMBER_OF_TARGETS_TRACKED];				// fftOutputArray index
+	U16 id[MAX_NUMBER_OF_TARGETS_TRACKED];					// Stable for the life of the track.  0 while the slot is free.
+	_iq magnitude[MAX_NUMBER_OF_TARGETS_TRACKED];
+	_iq indexEstimate[MAX_NUMBER_OF_TARGETS_TRACKED];		// Alpha-beta filtered index - see _predictTrackIndex()
+	_iq indexRate[MAX_NUMBER_OF_TARGETS_TRACKED];			// Alpha-beta filtered change in index per frame
+	int trackCounter[MAX_NUMBER_OF_TARGETS_TRACKED];		// Increments when a vehicle is found again.
+	int	directionCounter[MAX_NUMBER_OF_TARGETS_TRACKED];
 	struct {
-		int direction;						// Increments when direction is good, decrements when bad
-		int acceleration;					// Increments when the present speed is tracking well with the previous speed
-		int magnitude;						// Increments when the magnitude is high enough to use
-		int magnitudeTrack;					// Increments when the present magnitude is tracking well with the previous magnitude
+		int direction[MAX_NUMBER_OF_TARGETS_TRACKED];		// Increments when direction is good, decrements when bad
+		int acceleration[MAX_NUMBER_OF_TARGETS_TRACKED];	// Increments when the present speed is tracking well with the previous speed
+		int magnitude[MAX_NUMBER_OF_TARGETS_TRACKED];		// Increments when the magnitude is high enough to use
+		int magnitudeTrack[MAX_NUMBER_OF_TARGETS_TRACKED];	// Increments when the present magnitude is tracking well with the previous magnitude
 	} confidence;
-} targetTrackingStructureType;
+	trackColdType cold[MAX_NUMBER_OF_TARGETS_TRACKED];
+} trackStoreType;
 
 //-------------------------------------------------------------------------------------------------
 //-------------------------------------------------------------------------------------------------
-#define MAX_NUMBER_OF_TARGETS_TRACKED	4	// Was 10 before 2007-03-13
 typedef struct {
 	struct {
 		int serialPortCommandReceived : 1;
@@ -170,19 +192,21 @@ typedef struct {
 	int minimumIndex;
 	int maximumIndex;
 
-	targetTrackingStructureType targetTracker[MAX_NUMBER_OF_TARGETS_TRACKED];
+	trackStoreType track;			// A track keeps its slot while it lives
+	int trackOrder[MAX_NUMBER_OF_TARGETS_TRACKED];	// track slots, strongest first - see sort()
+	U16 nextTrackId;
 	int numberOfOldTargetsFound;
 	int numberOfNewTargetsFound;
-	long targetFFTIndex;			// The position in the vehicle tracker array of the speed we are displaying
+	long targetFFTIndex;			// The position in trackOrder of the speed we are displaying
 
 	statisticsType statistics;
 
 	struct {
-		float value;
+		_iq value;
 	} speed;
 	struct {
-		float FFTsignalLevel;
-		float value;
+		_iq FFTsignalLevel;
+		_iq value;
 	} frequency;
 
 
@@ -237,8 +261,18 @@ extern ErrorCodeIntType processCommands(void);
 extern systemDataType systemData;
 
 // Includes at the end to support arduino
+#include "profiler.h"
+#include "fftAnalyzer.h"
 #include "VehicleTracker.h"
 #include "serialPort.h"
+#include "telemetry.h"
+#include "spectrumStream.h"
+#include "lineBuffer.h"
+#include "dataLogger.h"
+#include "replay.h"
+#include "trafficScenario.h"
+#include "healthMonitor.h"
+#include "eventTrace.h"
 //#include "ansicode.h"
 
 /*********************************** End of File ******************************************************/
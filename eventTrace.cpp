@@ -0,0 +1,81 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Event Trace
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+#ifdef USE_TRACING
+
+#if ((TRACE_EVENTS & (TRACE_EVENTS - 1)) != 0)
+	#error TRACE_EVENTS has to be a power of two
+#endif
+
+traceType trace;
+
+//-------------------------------------------------------------------------------------------------
+// After profileOpen(), which starts the clock
+//-------------------------------------------------------------------------------------------------
+void traceOpen(void) {
+	traceReset();
+}
+
+//-------------------------------------------------------------------------------------------------
+void traceReset(void) {
+	trace.stopped	= TRUE;
+	trace.head		= 0;
+	trace.stopped	= FALSE;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Oldest first.  A running trace is held while it is sent, then started again empty; a stopped
+// one is left as it was, so it can be sent again.
+//-------------------------------------------------------------------------------------------------
+void traceDump(void) {
+	static lineBufferType line;
+	const traceEventType *pEvent;
+	boolean wasStopped;
+	U32 head, count, i;
+
+	wasStopped		= trace.stopped;
+	trace.stopped	= TRUE;
+	head			= __atomic_load_n(&trace.head, __ATOMIC_ACQUIRE);
+	count			= (head < TRACE_EVENTS) ? head : TRACE_EVENTS;
+
+	lineBegin(&line);
+	linePutString(&line, "Trace, " PROFILE_CLOCK_NAME ", ");
+	linePutUnsigned(&line, profileTicksPerMillisecond);
+	linePutString(&line, ", ");
+	linePutUnsigned(&line, count);
+	linePutString(&line, ", ");
+	linePutUnsigned(&line, head - count);
+	lineEnd(&line);
+
+	for (i=head-count; i!=head; i++) {
+		pEvent = &trace.event[i & (TRACE_EVENTS - 1)];
+		lineBegin(&line);
+		linePutString(&line, (pEvent->point < NUMBER_OF_PROFILE_POINTS) ? profilePointNames[pEvent->point] : "?");
+		linePutString(&line, ", ");
+		linePutUnsigned(&line, pEvent->frame);
+		linePutString(&line, ", ");
+		linePutUnsigned(&line, pEvent->start);
+		linePutString(&line, ", ");
+		linePutUnsigned(&line, pEvent->length);
+		lineEnd(&line);
+	}
+
+	lineBegin(&line);
+	linePutString(&line, "Trace end");
+	lineEnd(&line);
+
+	if (wasStopped) {
+		trace.stopped = TRUE;
+	} else {
+		traceReset();
+	}
+}
+
+#endif	// USE_TRACING
+
+/*---- End Of File ----*/
@@ -0,0 +1,71 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Event Trace
+//
+// The last TRACE_EVENTS probe runs, one at a time, for USE_TRACING.  The profiler gives the
+// totals; the trace shows the one frame that a display burst held up, or the millisecond timer
+// interrupt landing in the middle of a stage.  Every PROFILE_BEGIN()/PROFILE_END() pair puts one
+// event in the ring when it ends: the profile point, its start and length on the profiler's clock,
+// and the tracker frame it ran in.  A begin and its end are one event, so the ring never holds an
+// end whose begin has been written over.
+//
+// Recording is an atomic add for the slot and four stores, in loop() or an interrupt, with
+// nothing allocated.  Events go in in the order they end, which lets a reader unwrap the 32 bit
+// clock.
+//
+// The "trace" command stops recording and dumps the ring as text, oldest first, then starts again
+// with it empty; "trace,stop" and "trace,start" hold and restart it.  The dump is
+//
+//	Trace, <clock name>, <ticks a millisecond>, <events>, <events written over>
+//	<profile point name>, <frame>, <start>, <length>
+//	...
+//	Trace end
+//
+// On the host, Serial is a file.  host/traceToChrome turns a dump, anywhere in a capture of the
+// port, into Chrome trace JSON for chrome://tracing or Perfetto.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#ifndef TRACE_EVENTS
+	#define TRACE_EVENTS		1024	// 12 bytes each.  Has to be a power of two.
+#endif
+
+typedef struct {
+	U32 start;						// profileCycles()
+	U32 length;
+	U16 point;						// profilePointType
+	U16 frame;						// trackerPipeline.frames, the low 16 bits
+} traceEventType;
+
+typedef struct {
+	U32 head;						// Events recorded since traceReset()
+	volatile boolean stopped;
+	traceEventType event[TRACE_EVENTS];
+} traceType;
+
+extern traceType trace;
+
+extern void traceOpen(void);
+extern void traceReset(void);
+extern void traceDump(void);
+
+//-------------------------------------------------------------------------------------------------
+static inline void traceRecord(profilePointType point, U32 start, U32 length) {
+	traceEventType *pEvent;
+
+	if (trace.stopped) {
+		return;
+	}
+	pEvent			= &trace.event[__atomic_fetch_add(&trace.head, 1, __ATOMIC_RELAXED) & (TRACE_EVENTS - 1)];
+	pEvent->start	= start;
+	pEvent->length	= length;
+	pEvent->point	= point;
+	pEvent->frame	= (U16)trackerPipeline.frames;
+}
+
+#endif   /* #ifndef EVENT_TRACE_H */
+
+/*********************************** End of File ******************************************************/
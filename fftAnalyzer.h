@@ -0,0 +1,48 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// FFT Analyzer Selection
+//
+// Both AudioAnalyzeFFT1024 and AudioAnalyzeFFT256 are built in.  Only the selected one is patched
+// to the audio input, and fftAnalyzer is a copy of its entry in fftAnalyzers[].  FFT1024 gives
+// finer bins at 69 frames/s, FFT256 coarser bins at 345 frames/s.  Each analyzer queues its own
+// frames - see frameQueue.h.
+//
+// The size is chosen at startup (DEFAULT_FFT_SIZE) or with the "fft" serial command.  Selecting
+// a size also selects the first tracker configuration built for it - see trackerConfiguration[].
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef FFT_ANALYZER_H
+#define FFT_ANALYZER_H
+
+#define FFT1024_OUTPUT_SIZE		512
+#define FFT256_OUTPUT_SIZE		128
+
+#ifdef USE_FFT_256
+	#define DEFAULT_FFT_SIZE	256
+#else
+	#define DEFAULT_FFT_SIZE	1024
+#endif
+
+typedef enum {
+	FFT_SIZE_1024,
+	FFT_SIZE_256,
+	NUMBER_OF_FFT_SIZES
+} fftSizeType;
+
+typedef struct {
+	const char *name;
+	int fftSize;					// Points in the transform
+	int numberOfBins;				// Length of output[], half of fftSize
+	int fftsPerSecond;				// Nominal frame rate at 44.1 kHz
+	const uint16_t *output;			// The analyzer's output[], rewritten by the audio interrupt
+} fftAnalyzerType;
+
+extern fftAnalyzerType fftAnalyzer;
+extern const fftAnalyzerType fftAnalyzers[NUMBER_OF_FFT_SIZES];
+
+extern boolean selectFFTSize(int);
+
+#endif   /* #ifndef FFT_ANALYZER_H */
+
+/*********************************** End of File ******************************************************/
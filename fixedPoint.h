@@ -0,0 +1,84 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Fixed Point
+//
+// The tracker's fractional values - track magnitudes, the alpha-beta index estimates, the minimum
+// magnitude, the interpolated frequency and the speed - are _iq, in the style of TI's IQmath.
+// By default _iq is float and the macros below are plain arithmetic.  With USE_FIXED_POINT
+// defined _iq is a 32-bit integer with GLOBAL_Q fraction bits and the tracker uses no floating
+// point at all, for parts without an FPU (Cortex-M0+/M3).
+//
+//	_iq			Q16.15 by default.  Magnitudes go up to INT16_MAX and frequencies to 22050 Hz,
+//				so there are 16 integer bits and 15 fraction bits.
+//	_iq31		Q31 for coefficients between -1 and 1 (filter gains, the speed gain), so a
+//				value times a coefficient keeps 31 bits of the coefficient.
+//
+// The spectrum is already integer, so a sample is converted with _IQfromInt(), a shift, and
+// thresholds are taken as whole samples with _IQint()/_IQceilInt() once per frame.
+//
+// Tolerance against the float build:
+//	- Each step of the index estimate, magnitude and minimum magnitude is within 2^-15 of the
+//	  float result.  Indexes, gates and thresholds are whole bins and samples, so the builds
+//	  only part when a value lands within that of a boundary.  The minimum magnitude steps by
+//	  0.1, which neither build holds exactly, and where it settles on a whole sample the two
+//	  can round the new track threshold differently.  Host benchmark vehicle counts agree for
+//	  2 to 8 vehicles; with 1 vehicle the 128 bin configurations differ this way.
+//	- The interpolated frequency is within 0.01 Hz and the speed within 0.001 mph of the float
+//	  build.
+// Converting back with _IQtoF() is only for display.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <stdint.h>
+
+#ifdef USE_FIXED_POINT
+
+	#ifndef GLOBAL_Q
+		#define GLOBAL_Q	15
+	#endif
+
+	typedef int32_t _iq;
+	typedef int32_t _iq31;
+
+	// Constants only - these are folded at compile time
+	#define _IQ(A)				((_iq)((A) * (double)(1L << GLOBAL_Q) + (((A) >= 0) ? 0.5 : -0.5)))
+	#define _IQ31(A)			((_iq31)((A) * 2147483648.0 + (((A) >= 0) ? 0.5 : -0.5)))
+
+	#define _IQfromInt(A)		((_iq)(A) * (1L << GLOBAL_Q))
+	#define _IQint(A)			((int)((A) >> GLOBAL_Q))						// Rounds down
+	#define _IQceilInt(A)		((int)(((A) + ((1L << GLOBAL_Q) - 1)) >> GLOBAL_Q))
+	#define _IQmpy(A,B)			((_iq)(((int64_t)(A) * (B)) >> GLOBAL_Q))
+	#define _IQmpyIQ31(A,B)		((_iq)((((int64_t)(A) * (B)) + (1L << 30)) >> 31))		// Rounds to nearest
+	#define _IQmpyI32(A,B)		((_iq)((A) * (B)))
+	#define _IQmpyI32int(A,B)	((int32_t)(((int64_t)(A) * (B)) >> GLOBAL_Q))	// Integer part, rounded down
+	#define _IQratio(N,D)		((_iq)(((int64_t)(N) << GLOBAL_Q) / (D)))		// Integer N/D as an _iq
+	#define _IQsat(A,Pos,Neg)	(((A) > (Pos)) ? (Pos) : (((A) < (Neg)) ? (Neg) : (A)))
+	#define _IQtoF(A)			((float)(A) * (1.0f / (1L << GLOBAL_Q)))
+
+#else
+
+	typedef float _iq;
+	typedef float _iq31;
+
+	#define _IQ(A)				(A)
+	#define _IQ31(A)			(A)
+
+	#define _IQfromInt(A)		((_iq)(A))
+	#define _IQint(A)			((int)floorf(A))
+	#define _IQceilInt(A)		((int)ceilf(A))
+	#define _IQmpy(A,B)			((A) * (B))
+	#define _IQmpyIQ31(A,B)		((A) * (B))
+	#define _IQmpyI32(A,B)		((A) * (B))
+	#define _IQmpyI32int(A,B)	((int32_t)floorf((A) * (B)))
+	#define _IQratio(N,D)		((_iq)(N) / (_iq)(D))
+	#define _IQsat(A,Pos,Neg)	fmaxf(fminf((A), (Pos)), (Neg))
+	#define _IQtoF(A)			(A)
+
+#endif
+
+#endif   /* #ifndef FIXED_POINT_H */
+
+/*********************************** End of File ******************************************************/
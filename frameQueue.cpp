@@ -0,0 +1,102 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Frame Queue
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+#if ((FRAME_QUEUE_DEPTH & (FRAME_QUEUE_DEPTH - 1)) != 0)
+	#error FRAME_QUEUE_DEPTH has to be a power of two
+#endif
+
+// The index the other side writes is read with acquire, and our own is published with release,
+// so the frame contents are seen before the index that hands them over.
+#define LOAD_ACQUIRE(p)			__atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, value)	__atomic_store_n((p), (value), __ATOMIC_RELEASE)
+
+#define FRAME_SLOT(count)		((count) & (FRAME_QUEUE_DEPTH - 1))
+
+frameQueueType frameQueue;
+
+//-------------------------------------------------------------------------------------------------
+// Only while the producer is stopped - at startup, or on the host between runs
+//-------------------------------------------------------------------------------------------------
+void frameQueueReset(void) {
+	memset(&frameQueue, 0, sizeof(frameQueue));
+	frameQueue.expectedSequence = 1;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Producer.  Returns FALSE if the frame was dropped.
+//-------------------------------------------------------------------------------------------------
+boolean frameQueuePush(const uint16_t *pOutput, int numberOfBins) {
+	spectrumFrameType *pFrame;
+	U32 head;
+
+	frameQueue.sequence++;
+
+	head = frameQueue.head;
+	if ((head - LOAD_ACQUIRE(&frameQueue.tail)) >= FRAME_QUEUE_DEPTH) {
+		frameQueue.overruns++;
+		return(FALSE);
+	}
+
+	PROFILE_BEGIN(start);
+	pFrame					= &frameQueue.frame[FRAME_SLOT(head)];
+	pFrame->sequence		= frameQueue.sequence;
+	pFrame->numberOfBins	= numberOfBins;
+	memcpy(pFrame->output, pOutput, numberOfBins * sizeof(uint16_t));
+	PROFILE_END(PROFILE_FRAME_COPY, start);
+
+	STORE_RELEASE(&frameQueue.head, head + 1);
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Consumer.  Returns the next frame and releases the one from the last call, or returns NULL and
+// keeps holding it if there isn't a new one yet.
+//-------------------------------------------------------------------------------------------------
+const spectrumFrameType *frameQueuePop(void) {
+	const spectrumFrameType *pFrame;
+	U32 tail, depth;
+
+	tail	= frameQueue.tail;
+	depth	= LOAD_ACQUIRE(&frameQueue.head) - tail;
+	if (frameQueue.holding) {
+		depth--;
+	}
+	if (depth == 0) {
+		return(NULL);
+	}
+	if (depth > frameQueue.maximumDepth) {
+		frameQueue.maximumDepth = depth;
+	}
+
+	// Only now that there's a newer frame to hand out
+	if (frameQueue.holding) {
+		tail++;
+		STORE_RELEASE(&frameQueue.tail, tail);
+	}
+
+	pFrame = &frameQueue.frame[FRAME_SLOT(tail)];
+	if (frameQueue.expectedSequence != 0) {
+		frameQueue.lost += pFrame->sequence - frameQueue.expectedSequence;
+	}
+	frameQueue.expectedSequence	= pFrame->sequence + 1;
+	frameQueue.popped++;
+	frameQueue.holding			= TRUE;
+	return(pFrame);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Consumer.  Drops everything waiting, including a frame still being held.  Used when the FFT size
+// changes and the frames already queued came from the other analyzer.  They aren't counted as lost.
+//-------------------------------------------------------------------------------------------------
+void frameQueueFlush(void) {
+	frameQueue.holding			= FALSE;
+	frameQueue.expectedSequence	= 0;	// Take the next sequence as it comes
+	STORE_RELEASE(&frameQueue.tail, LOAD_ACQUIRE(&frameQueue.head));
+}
+
+/*---- End Of File ----*/
@@ -0,0 +1,72 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Frame Queue
+//
+// A single-producer/single-consumer ring of spectrum frames between the analyzer and the tracker.
+// The producer is the selected analyzer's update() in the audio interrupt (on the host, whatever
+// calls hostPublish()) and the consumer is loop().  Neither side ever waits for the other:
+//
+//	- frameQueuePush() copies the analyzer output into the next free slot.  When every slot is
+//	  full the new frame is dropped and counted in overruns, so a frame the tracker is reading is
+//	  never overwritten.
+//	- frameQueuePop() hands back the oldest frame, in order.  The consumer holds it until a pop
+//	  hands out a newer one: a pop that returns NULL keeps holding it.  So the frame loop() last
+//	  tracked stays put however long the displays take over fftData.fftOutputArray, and the held
+//	  slot is never one the producer can fill.  The producer has FRAME_QUEUE_DEPTH - 1 slots
+//	  meanwhile.
+//
+// The copy is a frame's worth of output[], 1 KB at FFT1024, made in the audio interrupt.  The
+// tracker used to read output[] in place with no copy at all, but the analyzer owns a single
+// output[] and its next update() writes over it, so a frame can't outlive the next FFT unless it
+// is copied out.  A ring of pointers would need the analyzer to write each FFT into a slot of
+// ours, which the Audio library's analyzers don't do.  The copy is timed as "frame copy" by the
+// profiler.
+//
+// Every completed FFT gets the next sequence number whether or not it was queued, so a gap seen by
+// the consumer is the number of frames it lost.  head is only written by the producer and tail
+// only by the consumer, each published with release ordering, so no lock is needed between the
+// audio interrupt and loop() or between host threads.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#ifndef FRAME_QUEUE_DEPTH
+	#define FRAME_QUEUE_DEPTH	4		// Frames.  Has to be a power of two.
+#endif
+
+typedef struct {
+	U32 sequence;					// 1 for the first FFT after frameQueueReset()
+	int numberOfBins;				// The analyzer's output size
+	uint16_t output[FFT_OUTPUT_ARRAY_SIZE];
+} spectrumFrameType;
+
+typedef struct {
+	U32 head;						// Frames pushed.  Written by the producer only.
+	U32 tail;						// Frames released.  Written by the consumer only.
+	boolean holding;				// frame[tail] is held until a newer frame is popped
+
+	// Producer
+	U32 sequence;					// FFTs completed
+	U32 overruns;					// FFTs dropped because the queue was full
+
+	// Consumer
+	U32 expectedSequence;			// 0 after a flush
+	U32 popped;
+	U32 lost;						// Sum of the sequence gaps seen
+	U32 maximumDepth;				// Most frames waiting at a pop
+
+	spectrumFrameType frame[FRAME_QUEUE_DEPTH];
+} frameQueueType;
+
+extern frameQueueType frameQueue;
+
+extern void frameQueueReset(void);
+extern boolean frameQueuePush(const uint16_t *, int);
+extern const spectrumFrameType *frameQueuePop(void);
+extern void frameQueueFlush(void);
+
+#endif   /* #ifndef FRAME_QUEUE_H */
+
+/*********************************** End of File ******************************************************/
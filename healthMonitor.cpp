@@ -0,0 +1,151 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Health Monitor
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include <Audio.h>
+#include "environ.h"
+
+healthType health;
+
+static const char *const _flagNames[] = {
+	"frames lost",
+	"audio memory",
+	"audio CPU",
+	"FFT rate",
+};
+
+static void _putFlags(lineBufferType *, U8);
+
+//-------------------------------------------------------------------------------------------------
+static void _putFlags(lineBufferType *pLine, U8 flags) {
+	int bit;
+	boolean first = TRUE;
+
+	if (flags == 0) {
+		linePutString(pLine, "ok");
+		return;
+	}
+	for (bit=0; bit<(int)(sizeof(_flagNames) / sizeof(_flagNames[0])); bit++) {
+		if (flags & (1 << bit)) {
+			if (!first) {
+				linePutString(pLine, ", ");
+			}
+			linePutString(pLine, _flagNames[bit]);
+			first = FALSE;
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Starts the counts and the audio library's maxima from here.  The frames dropped while setup()
+// was busy are left out.
+//-------------------------------------------------------------------------------------------------
+void healthReset(void) {
+	memset(&health, 0, sizeof(health));
+	health.overruns = frameQueue.overruns;
+	AudioMemoryUsageMaxReset();
+	AudioProcessorUsageMaxReset();
+}
+
+//-------------------------------------------------------------------------------------------------
+// Once a second, after systemData.fftsPerSecond is updated.  The first check after a reset, a
+// change of analyzer or a replay only starts the rate window.  Returns the flags.
+//-------------------------------------------------------------------------------------------------
+U8 healthCheck(void) {
+	U32 overruns;
+	U16 blocks, processor;
+	U8 flags = 0;
+
+	overruns = frameQueue.overruns;
+	if (overruns != health.overruns) {
+		health.framesLost	+= overruns - health.overruns;
+		health.overruns		= overruns;
+		flags |= HEALTH_FRAMES_LOST;
+	}
+
+	blocks = AudioMemoryUsageMax();
+	AudioMemoryUsageMaxReset();
+	if (blocks > health.audioBlocksMaximum) {
+		health.audioBlocksMaximum = blocks;
+	}
+	if ((blocks + HEALTH_AUDIO_BLOCK_HEADROOM) > AUDIO_MEMORY_BLOCKS) {
+		flags |= HEALTH_AUDIO_MEMORY;
+	}
+
+	processor = (U16)(AudioProcessorUsageMax() * 10);
+	AudioProcessorUsageMaxReset();
+	if (processor > health.processorMaximum) {
+		health.processorMaximum = processor;
+	}
+	if (processor > HEALTH_PROCESSOR_LIMIT) {
+		flags |= HEALTH_PROCESSOR;
+	}
+
+	if (replay.active) {
+		health.fftSize = 0;
+	} else {
+		if (health.fftSize == fftAnalyzer.fftSize) {
+			if ((health.fftsPerSecondMinimum == 0) || (systemData.fftsPerSecond < health.fftsPerSecondMinimum)) {
+				health.fftsPerSecondMinimum = systemData.fftsPerSecond;
+			}
+			if ((systemData.fftsPerSecond * 100) < (fftAnalyzer.fftsPerSecond * HEALTH_FFT_RATE_LIMIT)) {
+				flags |= HEALTH_FFT_RATE;
+			}
+		}
+		health.fftSize = fftAnalyzer.fftSize;
+	}
+
+	health.checks++;
+	if (flags) {
+		if (health.latched == 0) {
+			health.firstProblem = millis();
+		}
+		health.latched |= flags;
+		health.unhealthyChecks++;
+	}
+	health.flags = flags;
+	return(flags);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Two lines: the flags, then the worst cases since the last reset
+//-------------------------------------------------------------------------------------------------
+void healthReport(void) {
+	static lineBufferType line;
+
+	lineBegin(&line);
+	linePutString(&line, "Health: ");
+	_putFlags(&line, health.flags);
+	linePutString(&line, "; since reset: ");
+	_putFlags(&line, health.latched);
+	if (health.latched) {
+		linePutString(&line, ", first at ");
+		linePutUnsigned(&line, health.firstProblem);
+		linePutString(&line, "ms");
+	}
+	linePutString(&line, "; ");
+	linePutUnsigned(&line, health.unhealthyChecks);
+	linePutChar(&line, '/');
+	linePutUnsigned(&line, health.checks);
+	linePutString(&line, " seconds unhealthy");
+	lineEnd(&line);
+
+	lineBegin(&line);
+	linePutString(&line, "Frames lost ");
+	linePutUnsigned(&line, health.framesLost);
+	linePutString(&line, ", audio blocks ");
+	linePutUnsigned(&line, health.audioBlocksMaximum);
+	linePutChar(&line, '/');
+	linePutInt(&line, AUDIO_MEMORY_BLOCKS);
+	linePutString(&line, ", audio CPU ");
+	linePutFixed(&line, health.processorMaximum, 1);
+	linePutString(&line, "%, FFTs/s ");
+	linePutUnsigned(&line, health.fftsPerSecondMinimum);
+	linePutChar(&line, '/');
+	linePutInt(&line, fftAnalyzer.fftsPerSecond);
+	lineEnd(&line);
+}
+
+/*---- End Of File ----*/
@@ -0,0 +1,64 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Health Monitor
+//
+// Whether the counts can be trusted.  healthCheck() runs once a second from loop() and looks at
+// what happened in that second:
+//
+//	HEALTH_FRAMES_LOST		frameQueue dropped a frame (an overrun, seen later as a sequence gap)
+//	HEALTH_AUDIO_MEMORY		the audio library's block pool got within HEALTH_AUDIO_BLOCK_HEADROOM
+//							blocks of AUDIO_MEMORY_BLOCKS.  When it runs out, update() goes without
+//							a block and the FFT never completes, so it never gets a sequence number.
+//	HEALTH_PROCESSOR		the audio interrupt took more than HEALTH_PROCESSOR_LIMIT of the CPU
+//	HEALTH_FFT_RATE			fewer than HEALTH_FFT_RATE_LIMIT of the analyzer's nominal frames
+//							reached the tracker.  This catches the FFTs that were never numbered.
+//
+// flags are the last second's, and latched keeps every flag raised since healthReset(), with the
+// time of the first.  The worst cases are kept since healthReset() too.  A day with latched == 0
+// had every frame tracked, so a low vehicle count was the traffic.
+//
+// The report goes out on the "health" command and with SP_FFT_TIMING, and as POLL_HEALTH in a
+// poll reply.  "health,reset" starts again.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef HEALTH_MONITOR_H
+#define HEALTH_MONITOR_H
+
+#define AUDIO_MEMORY_BLOCKS			12		// Given to AudioMemory() in setup()
+#define HEALTH_AUDIO_BLOCK_HEADROOM	2		// Blocks that have to stay free at the worst
+#define HEALTH_PROCESSOR_LIMIT		800		// Tenths of a percent of the CPU, in the audio interrupt
+#define HEALTH_FFT_RATE_LIMIT		90		// Percent of the analyzer's nominal fftsPerSecond
+
+#define HEALTH_FRAMES_LOST			0x01
+#define HEALTH_AUDIO_MEMORY			0x02
+#define HEALTH_PROCESSOR			0x04
+#define HEALTH_FFT_RATE				0x08
+
+typedef struct {
+	U8 flags;						// From the last healthCheck()
+	U8 latched;						// Every flag raised since healthReset()
+	U32 firstProblem;				// millis() when latched was first set
+	U32 checks;
+	U32 unhealthyChecks;			// Checks that raised a flag
+
+	// Since healthReset()
+	U32 framesLost;
+	U16 audioBlocksMaximum;
+	U16 processorMaximum;			// Tenths of a percent
+	U16 fftsPerSecondMinimum;		// 0 before the first full second
+
+	// The last check's, to take the differences from
+	U32 overruns;
+	int fftSize;					// The rate isn't checked across a change of analyzer
+} healthType;
+
+extern healthType health;
+
+extern void healthReset(void);
+extern U8 healthCheck(void);
+extern void healthReport(void);
+
+#endif   /* #ifndef HEALTH_MONITOR_H */
+
+/*********************************** End of File ******************************************************/
@@ -0,0 +1,110 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Arduino.h - Host (Linux) stand-in for the Teensyduino core
+//
+// Only the pieces of the core that the sketch actually touches are provided.  Serial writes to
+// stdout (or wherever hostSerialStream points) and reads from a buffer filled by the host
+// program, so the sketch sources compile unchanged with the host Makefile.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define HOST_BUILD
+
+typedef uint8_t boolean;
+typedef uint8_t byte;
+
+#define DEC		10
+#define HEX		16
+#define INPUT	0
+#define OUTPUT	1
+
+extern uint32_t millis(void);
+extern uint32_t micros(void);
+extern void delay(uint32_t);
+extern void delayMicroseconds(uint32_t);
+extern void pinMode(uint8_t, uint8_t);
+extern int analogRead(uint8_t);
+extern void randomSeed(uint32_t);
+extern int32_t random(int32_t);
+extern int32_t random(int32_t, int32_t);
+
+//-------------------------------------------------------------------------------------------------
+// Serial
+//-------------------------------------------------------------------------------------------------
+#define HOST_SERIAL_RX_BUFFER_SIZE	256
+
+class hostSerialClass {
+public:
+	hostSerialClass() : stream(stdout), txSpace(4096), rxHead(0), rxTail(0) {}
+
+	FILE *stream;							// NULL discards everything that is printed
+	int txSpace;							// What availableForWrite() reports, to model a slow port
+	void begin(long) {}
+	void flush(void) { if (stream) fflush(stream); }
+	int available(void);
+	int availableForWrite(void) { return(txSpace); }
+	int read(void);
+	void inject(const char *);				// Queue bytes as if they arrived on the rx pin
+	void inject(const uint8_t *, int);		// The same, for bytes that may be zero
+
+	size_t write(uint8_t);
+	size_t write(const uint8_t *, size_t);
+
+	size_t print(const char *);
+	size_t print(char);
+	size_t print(int, int = DEC);
+	size_t print(unsigned int, int = DEC);
+	size_t print(long, int = DEC);
+	size_t print(unsigned long, int = DEC);
+	size_t print(double, int = 2);
+
+	size_t println(void);
+	size_t println(const char *);
+	size_t println(char);
+	size_t println(int, int = DEC);
+	size_t println(unsigned int, int = DEC);
+	size_t println(long, int = DEC);
+	size_t println(unsigned long, int = DEC);
+	size_t println(double, int = 2);
+
+private:
+	uint8_t rxBuffer[HOST_SERIAL_RX_BUFFER_SIZE];
+	int rxHead;
+	int rxTail;
+};
+
+extern hostSerialClass Serial;
+
+//-------------------------------------------------------------------------------------------------
+// IntervalTimer
+//
+// The host never fires the callback on its own.  A host program that wants the millisecond ISR
+// calls hostTick() to run it once.
+//-------------------------------------------------------------------------------------------------
+class IntervalTimer {
+public:
+	IntervalTimer() : callback(0), period_us(0) {}
+	bool begin(void (*function)(void), unsigned int microseconds) {
+		callback	= function;
+		period_us	= microseconds;
+		return(true);
+	}
+	void end(void) { callback = 0; }
+	void hostTick(void) { if (callback) callback(); }
+
+	void (*callback)(void);
+	unsigned int period_us;
+};
+
+#endif	/* #ifndef HOST_ARDUINO_H */
+
+/*********************************** End of File ******************************************************/
@@ -0,0 +1,104 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Audio.h - Host (Linux) stand-in for the Teensy Audio library
+//
+// The analyzers expose the same output[] arrays as the real objects.  A host program writes a
+// spectrum into output[] and calls hostPublish() to make available() return true once and run
+// update(), the way the audio ISR does after each FFT completes.
+//
+// The block pool and CPU usage counters are in hostAudioUsage, for a host program to set.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef HOST_AUDIO_H
+#define HOST_AUDIO_H
+
+#include "Arduino.h"
+
+#define TONE_TYPE_SINE		0
+#define TONE_TYPE_SAWTOOTH	1
+#define TONE_TYPE_SQUARE	2
+#define TONE_TYPE_TRIANGLE	3
+
+#define AUDIO_INPUT_LINEIN	0
+#define AUDIO_INPUT_MIC		1
+
+class AudioStream {
+public:
+	virtual ~AudioStream() {}
+	virtual void update(void) {}
+};
+
+class AudioConnection {
+public:
+	AudioConnection(AudioStream &, unsigned char, AudioStream &, unsigned char) {}
+	int connect(void) { return(0); }
+	int disconnect(void) { return(0); }
+};
+
+typedef struct {
+	int memoryBlocks;				// Given to AudioMemory()
+	unsigned int memoryUsed;
+	unsigned int memoryUsedMax;
+	float processorUsage;			// Percent
+	float processorUsageMax;
+} hostAudioUsageType;
+
+extern hostAudioUsageType hostAudioUsage;
+
+#define AudioMemory(num)				(hostAudioUsage.memoryBlocks = (num))
+#define AudioMemoryUsage()				(hostAudioUsage.memoryUsed)
+#define AudioMemoryUsageMax()			(hostAudioUsage.memoryUsedMax)
+#define AudioMemoryUsageMaxReset()		(hostAudioUsage.memoryUsedMax = hostAudioUsage.memoryUsed)
+#define AudioProcessorUsage()			(hostAudioUsage.processorUsage)
+#define AudioProcessorUsageMax()		(hostAudioUsage.processorUsageMax)
+#define AudioProcessorUsageMaxReset()	(hostAudioUsage.processorUsageMax = hostAudioUsage.processorUsage)
+
+//-------------------------------------------------------------------------------------------------
+template <int BINS>
+class hostAudioAnalyzeFFT : public AudioStream {
+public:
+	hostAudioAnalyzeFFT(uint8_t = 8) : outputflag(false) { memset(output, 0, sizeof(output)); }
+	bool available(void) {
+		if (outputflag) {
+			outputflag = false;
+			return(true);
+		}
+		return(false);
+	}
+	void hostPublish(void) { outputflag = true; update(); }
+
+	uint16_t output[BINS];
+
+private:
+	volatile bool outputflag;
+};
+
+typedef hostAudioAnalyzeFFT<512>	AudioAnalyzeFFT1024;
+typedef hostAudioAnalyzeFFT<128>	AudioAnalyzeFFT256;
+
+//-------------------------------------------------------------------------------------------------
+class AudioSynthWaveform : public AudioStream {
+public:
+	void begin(float, float, short) {}
+};
+
+class AudioMixer4 : public AudioStream {
+public:
+	void gain(unsigned int, float) {}
+};
+
+class AudioInputI2S : public AudioStream {};
+class AudioOutputI2S : public AudioStream {};
+
+class AudioControlSGTL5000 {
+public:
+	bool enable(void) { return(true); }
+	bool inputSelect(int) { return(true); }
+	bool inputLevel(float) { return(true); }
+	bool volume(float) { return(true); }
+};
+
+#endif	/* #ifndef HOST_AUDIO_H */
+
+/*********************************** End of File ******************************************************/
@@ -0,0 +1,92 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// SD.h - Host (Linux) stand-in for the Teensy SD library
+//
+// Files map onto the host file system relative to the working directory.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef HOST_SD_H
+#define HOST_SD_H
+
+#include "Arduino.h"
+
+#define FILE_READ	0
+#define FILE_WRITE	1
+
+class File {
+public:
+	File() : fp(0) {}
+	File(FILE *f) : fp(f) {}
+	operator bool() const { return(fp != 0); }
+	int available(void) {
+		int ch;
+
+		if (!fp) {
+			return(0);
+		}
+		ch = fgetc(fp);
+		if (ch == EOF) {
+			return(0);
+		}
+		ungetc(ch, fp);
+		return(1);
+	}
+	int read(void) { return(fp ? fgetc(fp) : -1); }
+	int read(void *buffer, size_t length) { return(fp ? (int)fread(buffer, 1, length, fp) : -1); }
+	size_t write(uint8_t value) { return(fp ? fwrite(&value, 1, 1, fp) : 0); }
+	size_t write(const uint8_t *buffer, size_t length) { return(fp ? fwrite(buffer, 1, length, fp) : 0); }
+	bool seek(uint32_t position) { return(fp && (fseek(fp, position, SEEK_SET) == 0)); }
+	uint32_t position(void) { return(fp ? (uint32_t)ftell(fp) : 0); }
+	void flush(void) { if (fp) fflush(fp); }
+	void close(void) {
+		if (fp) {
+			fclose(fp);
+			fp = 0;
+		}
+	}
+	size_t print(const char *s) { return(fp ? fprintf(fp, "%s", s) : 0); }
+	size_t print(int value) { return(fp ? fprintf(fp, "%d", value) : 0); }
+	size_t print(double value, int digits = 2) { return(fp ? fprintf(fp, "%.*f", digits, value) : 0); }
+	size_t println(void) { return(fp ? fprintf(fp, "\r\n") : 0); }
+
+private:
+	FILE *fp;
+};
+
+class hostSDClass {
+public:
+	bool begin(uint8_t = 0) { return(true); }
+	bool exists(const char *path) {
+		FILE *fp = fopen(path, "rb");
+
+		if (fp) {
+			fclose(fp);
+			return(true);
+		}
+		return(false);
+	}
+	// FILE_WRITE opens at the end, as the SD library does, but seek() still moves where writes go
+	File open(const char *path, uint8_t mode = FILE_READ) {
+		FILE *fp;
+
+		if (mode != FILE_WRITE) {
+			return(File(fopen(path, "rb")));
+		}
+		fp = fopen(path, "r+b");
+		if (!fp) {
+			fp = fopen(path, "w+b");
+		}
+		if (fp) {
+			fseek(fp, 0, SEEK_END);
+		}
+		return(File(fp));
+	}
+	bool remove(const char *path) { return(::remove(path) == 0); }
+};
+
+extern hostSDClass SD;
+
+#endif	/* #ifndef HOST_SD_H */
+
+/*********************************** End of File ******************************************************/
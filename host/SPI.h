@@ -0,0 +1,18 @@
+//-------------------------------------------------------------------------------------------------
+// SPI.h - Host (Linux) stand-in.  Nothing on the host talks SPI.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include "Arduino.h"
+
+class hostSPIClass {
+public:
+	void setMOSI(uint8_t) {}
+	void setSCK(uint8_t) {}
+};
+
+extern hostSPIClass SPI;
+
+#endif	/* #ifndef HOST_SPI_H */
@@ -0,0 +1,10 @@
+//-------------------------------------------------------------------------------------------------
+// Wire.h - Host (Linux) stand-in.  Nothing on the host talks I2C.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include "Arduino.h"
+
+#endif	/* #ifndef HOST_WIRE_H */
@@ -0,0 +1,190 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Host (Linux) implementation of the Arduino core stand-ins
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include <time.h>
+#include "Arduino.h"
+#include "SD.h"
+#include "SPI.h"
+#include "Audio.h"
+
+hostSerialClass Serial;
+hostSDClass		SD;
+hostSPIClass	SPI;
+
+hostAudioUsageType hostAudioUsage;
+
+static uint32_t randomState = 1;
+
+//-------------------------------------------------------------------------------------------------
+static uint64_t _monotonic_us(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return(((uint64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000));
+}
+
+uint32_t micros(void) {
+	static uint64_t start = _monotonic_us();
+
+	return((uint32_t)(_monotonic_us() - start));
+}
+
+uint32_t millis(void) {
+	return(micros() / 1000);
+}
+
+// Delays are skipped so setup() doesn't stall host runs
+void delay(uint32_t) {
+}
+
+void delayMicroseconds(uint32_t) {
+}
+
+void pinMode(uint8_t, uint8_t) {
+}
+
+int analogRead(uint8_t) {
+	return(0);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Deterministic so that host runs are repeatable
+//-------------------------------------------------------------------------------------------------
+void randomSeed(uint32_t seed) {
+	randomState = seed ? seed : 1;
+}
+
+int32_t random(int32_t howbig) {
+	if (howbig <= 0) {
+		return(0);
+	}
+	randomState = (randomState * 1103515245) + 12345;
+	return((int32_t)((randomState >> 1) % (uint32_t)howbig));
+}
+
+int32_t random(int32_t howsmall, int32_t howbig) {
+	if (howsmall >= howbig) {
+		return(howsmall);
+	}
+	return(howsmall + random(howbig - howsmall));
+}
+
+//-------------------------------------------------------------------------------------------------
+// Serial
+//-------------------------------------------------------------------------------------------------
+int hostSerialClass::available(void) {
+	return((rxHead - rxTail + HOST_SERIAL_RX_BUFFER_SIZE) % HOST_SERIAL_RX_BUFFER_SIZE);
+}
+
+int hostSerialClass::read(void) {
+	int value;
+
+	if (rxHead == rxTail) {
+		return(-1);
+	}
+	value = rxBuffer[rxTail++];
+	if (rxTail >= HOST_SERIAL_RX_BUFFER_SIZE) {
+		rxTail = 0;
+	}
+	return(value);
+}
+
+void hostSerialClass::inject(const char *s) {
+	while (*s) {
+		rxBuffer[rxHead++] = (uint8_t)*s++;
+		if (rxHead >= HOST_SERIAL_RX_BUFFER_SIZE) {
+			rxHead = 0;
+		}
+	}
+}
+
+void hostSerialClass::inject(const uint8_t *p, int length) {
+	while (length-- > 0) {
+		rxBuffer[rxHead++] = *p++;
+		if (rxHead >= HOST_SERIAL_RX_BUFFER_SIZE) {
+			rxHead = 0;
+		}
+	}
+}
+
+size_t hostSerialClass::write(uint8_t value) {
+	return(stream ? fwrite(&value, 1, 1, stream) : 1);
+}
+
+size_t hostSerialClass::write(const uint8_t *buffer, size_t length) {
+	return(stream ? fwrite(buffer, 1, length, stream) : length);
+}
+
+size_t hostSerialClass::print(const char *s) {
+	return(write((const uint8_t *)s, strlen(s)));
+}
+
+size_t hostSerialClass::print(char value) {
+	return(write((uint8_t)value));
+}
+
+size_t hostSerialClass::print(int value, int base) {
+	return(print((long)value, base));
+}
+
+size_t hostSerialClass::print(unsigned int value, int base) {
+	return(print((unsigned long)value, base));
+}
+
+size_t hostSerialClass::print(long value, int base) {
+	char buffer[24];
+
+	snprintf(buffer, sizeof(buffer), (base == HEX) ? "%lX" : "%ld", value);
+	return(print(buffer));
+}
+
+size_t hostSerialClass::print(unsigned long value, int base) {
+	char buffer[24];
+
+	snprintf(buffer, sizeof(buffer), (base == HEX) ? "%lX" : "%lu", value);
+	return(print(buffer));
+}
+
+size_t hostSerialClass::print(double value, int digits) {
+	char buffer[48];
+
+	snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+	return(print(buffer));
+}
+
+size_t hostSerialClass::println(void) {
+	return(print("\r\n"));
+}
+
+size_t hostSerialClass::println(const char *s) {
+	return(print(s) + println());
+}
+
+size_t hostSerialClass::println(char value) {
+	return(print(value) + println());
+}
+
+size_t hostSerialClass::println(int value, int base) {
+	return(print(value, base) + println());
+}
+
+size_t hostSerialClass::println(unsigned int value, int base) {
+	return(print(value, base) + println());
+}
+
+size_t hostSerialClass::println(long value, int base) {
+	return(print(value, base) + println());
+}
+
+size_t hostSerialClass::println(unsigned long value, int base) {
+	return(print(value, base) + println());
+}
+
+size_t hostSerialClass::println(double value, int digits) {
+	return(print(value, digits) + println());
+}
+
+/*---- End Of File ----*/
@@ -0,0 +1,1590 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Host (Linux) per-stage throughput benchmark for the vehicle tracker
+//
+// Queues synthetic spectra in frameQueue, as the analyzer's update() does, and runs the tracker
+// pipeline on each as loop() does per FFT.  Stage times come from the pipeline's own timing, on
+// the profiler's clock.  Any failure stops the run with a message and exit code 1.  In run order:
+//
+//	- Spectrum kernels: every version built in, and the block-max index, against the scalar ones
+//	- Track association: against a brute force search
+//	- Peak search: detect() against the rescanning search it replaced
+//	- Stages: every FFT size and tracker configuration over the same traffic, per-stage times
+//	- Frame queue: a producer thread paced, overrunning, and through display bursts
+//	- Telemetry: both spectrum protocols over a port at TELEMETRY_BAUD, and SP_POLLED as two units
+//	- Data logger: to a temporary file through a sink that can be made slow or failing
+//	- Replay: the frames recorded as a data log and as displayFFT() text have to count the same
+//	- Scaling: generated traffic with more and more vehicles on the road at once
+//	- Text output: the time the text protocols' displays take
+//	- Health: each problem the monitor checks for has to be flagged, and only it
+//	- Profile: loop() with SP_SFR and what the probes cost, with USE_PROFILING (make PROFILE=1)
+//	- Trace: loop() and the timer interrupt into the trace file, with USE_TRACING (make TRACE=1)
+//
+// What each one checks is with the function that runs it.
+//
+// Usage: benchmark [frames] [vehicles] [trace file]
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <Audio.h>
+#include "environ.h"
+
+extern void setup(void);
+extern void loop(void);
+extern void millisecondTimer(void);
+
+#define DEFAULT_NUMBER_OF_FRAMES	20000
+#define DEFAULT_NUMBER_OF_VEHICLES	4
+#define NUMBER_OF_SYNTHETIC_FRAMES	1024	// Frames are precomputed and replayed in a loop
+#define VEHICLE_PERIOD				300		// Frames for one pass of a vehicle past the radar
+#define NOISE_FLOOR					20
+#define VEHICLE_AMPLITUDE			2000.0
+#define KERNEL_CHECK_ITERATIONS		20000
+#define ASSOCIATION_CHECK_ITERATIONS	2000	// Of each cluster size
+#define ASSOCIATION_CHECK_BINS		256
+#define PEAK_CHECK_ITERATIONS		20000	// Of each tracker configuration
+#define QUEUE_PACING_FACTOR			2		// The paced producer runs at 1/2 the tracker's frame rate
+#define QUEUE_OVERRUN_PERCENT		90		// The overrunning producer's frame period, of the tracker's
+#define QUEUE_DISPLAY_PERIODS		(FRAME_QUEUE_DEPTH + 1)	// A display burst, in producer frame periods
+#define TELEMETRY_BAUD				115200	// 10 bits a byte on the wire
+#define POLL_INTERVAL				100		// Frames
+#define DATALOG_TEST_PREALLOCATE	3		// Blocks a frame, more than a log of every record takes
+#define DATALOG_TEST_FULL			256		// Blocks, for the log that fills up
+#define SCENARIO_SEED				12345
+#define PROBE_COST_ITERATIONS		1000000
+#define HEALTH_SECONDS				5		// Of each health case
+#define TRACE_COST_ITERATIONS		1000000
+#define TRACE_FRAMES				64		// Traced, the last of them kept in the ring
+#define TIMER_INTERRUPTS_PER_PASS	7		// Of loop(), about 1 ms apart at 69 FFTs/s
+
+typedef struct {
+	const char *name;
+	int fftsPerSecond;						// Completed by the analyzer
+	int popEvery;							// The tracker takes one frame in popEvery
+	unsigned int audioBlocks;				// Most in use
+	float audioProcessor;					// Percent, at most
+	U8 expected;
+} healthCaseType;
+
+static const healthCaseType healthCases[] = {
+	// name,					FFTs/s,	popEvery,	blocks,	CPU,	expected
+	{"healthy",					69,		1,			6,		30.0,	0},
+	{"tracker falls behind",	69,		2,			6,		30.0,	HEALTH_FRAMES_LOST | HEALTH_FFT_RATE},
+	{"audio blocks run low",	69,		1,			11,		30.0,	HEALTH_AUDIO_MEMORY},
+	{"audio interrupt busy",	69,		1,			6,		85.0,	HEALTH_PROCESSOR},
+	{"FFTs never completed",	50,		1,			12,		30.0,	HEALTH_AUDIO_MEMORY | HEALTH_FFT_RATE},
+};
+#define NUMBER_OF_HEALTH_CASES	(int)(sizeof(healthCases) / sizeof(healthCases[0]))
+
+typedef struct {
+	int numberOfFrames;
+	int numberOfBins;
+	uint64_t period_ns;						// Between frames
+	volatile boolean done;
+} queueProducerType;
+
+// One association problem, and the brute force search of it
+typedef struct {
+	const int16_t *pSpectrum;
+	const associationGateType *pGates;
+	int numberOfTracks;
+	int16_t threshold;
+	boolean used[ASSOCIATION_CHECK_BINS];
+	int32_t lowerBound[MAX_NUMBER_OF_TARGETS_TRACKED+1];	// Of the tracks from here on
+	int32_t best;
+} associationCheckType;
+
+static uint16_t syntheticFrames[NUMBER_OF_SYNTHETIC_FRAMES][FFT_OUTPUT_ARRAY_SIZE];	// numberOfBins used of each
+
+// The data logger's test sink, which fails every failEvery'th write.  0 never fails.
+static int sinkFailEvery;
+static U32 sinkWrites;
+
+//-------------------------------------------------------------------------------------------------
+static inline uint64_t _now_ns(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return(((uint64_t)now.tv_sec * 1000000000) + now.tv_nsec);
+}
+
+//-------------------------------------------------------------------------------------------------
+// From the pipeline's profileCycles() ticks
+//-------------------------------------------------------------------------------------------------
+static double _ticksToNs(uint64_t ticks) {
+	return((double)ticks * 1000000.0 / profileTicksPerMillisecond);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Side-firing style traffic: each vehicle sweeps from a high bin down towards zero as it passes
+// the radar and back up as it leaves, loudest when it is directly in front.
+//-------------------------------------------------------------------------------------------------
+static void _buildSyntheticFrames(int numberOfBins, int numberOfVehicles) {
+	uint32_t seed = 12345;
+	int frame, vehicle, bin, offset;
+	float phase, sweep, position, amplitude, value;
+
+	for (frame=0; frame<NUMBER_OF_SYNTHETIC_FRAMES; frame++) {
+		for (bin=0; bin<numberOfBins; bin++) {
+			seed = (seed * 1103515245) + 12345;
+			syntheticFrames[frame][bin] = (seed >> 16) % NOISE_FLOOR;
+		}
+
+		for (vehicle=0; vehicle<numberOfVehicles; vehicle++) {
+			phase		= (float)((frame + (vehicle * VEHICLE_PERIOD / numberOfVehicles)) % VEHICLE_PERIOD) / VEHICLE_PERIOD;
+			sweep		= fabsf(cosf(PI * phase));
+			position	= MIN_INDEX + (sweep * (numberOfBins * 3 / 4));
+			amplitude	= VEHICLE_AMPLITUDE * (1.0 - (0.8 * sweep)) / (1 + (vehicle % 3));
+
+			for (offset=-3; offset<=3; offset++) {
+				bin = (int)position + offset;
+				if ((bin >= 0) && (bin < numberOfBins)) {
+					value = syntheticFrames[frame][bin] + (amplitude * expf(-0.5 * offset * offset));
+					syntheticFrames[frame][bin] = (value > 65535.0) ? 65535 : (uint16_t)value;
+				}
+			}
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Random spectra (including negative values, flat tops and all-zero stretches), random masks and
+// random search windows.  Returns the number of results that differ from the scalar version.
+//-------------------------------------------------------------------------------------------------
+static int _checkSpectrumKernels(void) {
+	static int16_t spectrum[FFT_OUTPUT_ARRAY_SIZE];
+	binMaskType mask;
+	spectrumIndexType blockIndexUnderTest;
+	uint32_t seed = 54321;
+	int iteration, version, bin, startBin, endBin, range, mismatches;
+	int expectedIndex, index;
+	int16_t expected, result;
+	int16_t blockMaximum[FFT_OUTPUT_ARRAY_SIZE/SPECTRUM_BLOCK_SIZE], expectedBlockMaximum[FFT_OUTPUT_ARRAY_SIZE/SPECTRUM_BLOCK_SIZE];
+	U16 blockIndex[FFT_OUTPUT_ARRAY_SIZE/SPECTRUM_BLOCK_SIZE], expectedBlockIndex[FFT_OUTPUT_ARRAY_SIZE/SPECTRUM_BLOCK_SIZE];
+
+	mismatches = 0;
+	for (iteration=0; iteration<KERNEL_CHECK_ITERATIONS; iteration++) {
+		range = (iteration % 3) ? 40 : 30000;
+		for (bin=0; bin<FFT_OUTPUT_ARRAY_SIZE; bin++) {
+			seed = (seed * 1103515245) + 12345;
+			spectrum[bin] = (int16_t)(((seed >> 8) % (2 * range)) - (range / 4));
+			if ((bin > 0) && ((seed >> 28) == 0)) {
+				spectrum[bin] = spectrum[bin-1];
+			}
+		}
+
+		binMaskClear(&mask);
+		for (bin=0; bin<(int)(iteration % 5); bin++) {
+			seed		= (seed * 1103515245) + 12345;
+			startBin	= (seed >> 8) % FFT_OUTPUT_ARRAY_SIZE;
+			binMaskMarkRange(&mask, startBin, startBin + ((seed >> 20) % 64));
+		}
+
+		seed		= (seed * 1103515245) + 12345;
+		startBin	= (seed >> 8) % FFT_OUTPUT_ARRAY_SIZE;
+		endBin		= startBin + ((seed >> 18) % (FFT_OUTPUT_ARRAY_SIZE + 1 - startBin));
+
+		// The block-max index has to give the same answers as searching the bins
+		spectrumIndexBuild(&blockIndexUnderTest, spectrum, FFT_OUTPUT_ARRAY_SIZE);
+		expected	= spectrumKernelVersions[0]->maskedArgmax(spectrum, &mask, startBin, endBin, &expectedIndex);
+		result		= spectrumIndexMaskedArgmax(&blockIndexUnderTest, spectrum, &mask, startBin, endBin, &index);
+		if ((result != expected) || (index != expectedIndex)) {
+			mismatches++;
+		}
+		expected	= spectrumKernelVersions[0]->windowMax(spectrum, startBin, endBin, &expectedIndex);
+		result		= spectrumIndexWindowMax(&blockIndexUnderTest, spectrum, startBin, endBin, &index);
+		if ((result != expected) || (index != expectedIndex)) {
+			mismatches++;
+		}
+
+		for (version=1; version<numberOfSpectrumKernelVersions; version++) {
+			expected	= spectrumKernelVersions[0]->maskedArgmax(spectrum, &mask, startBin, endBin, &expectedIndex);
+			result		= spectrumKernelVersions[version]->maskedArgmax(spectrum, &mask, startBin, endBin, &index);
+			if ((result != expected) || (index != expectedIndex)) {
+				mismatches++;
+			}
+
+			expected	= spectrumKernelVersions[0]->windowMax(spectrum, startBin, endBin, &expectedIndex);
+			result		= spectrumKernelVersions[version]->windowMax(spectrum, startBin, endBin, &index);
+			if ((result != expected) || (index != expectedIndex)) {
+				mismatches++;
+			}
+
+			spectrumKernelVersions[0]->blockMax(spectrum, FFT_OUTPUT_ARRAY_SIZE/SPECTRUM_BLOCK_SIZE, expectedBlockMaximum, expectedBlockIndex);
+			spectrumKernelVersions[version]->blockMax(spectrum, FFT_OUTPUT_ARRAY_SIZE/SPECTRUM_BLOCK_SIZE, blockMaximum, blockIndex);
+			if ((memcmp(blockMaximum, expectedBlockMaximum, sizeof(blockMaximum)) != 0) ||
+				(memcmp(blockIndex, expectedBlockIndex, sizeof(blockIndex)) != 0)) {
+				mismatches++;
+			}
+		}
+	}
+
+	return(mismatches);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Gates, peaks and costs as trackAssociation.cpp has them
+//-------------------------------------------------------------------------------------------------
+static int _associationGateStart(const associationGateType *pGate) {
+	int start = pGate->predictedIndex - pGate->gate;
+
+	return((start < SAMPLE_START_LOCATION) ? SAMPLE_START_LOCATION : start);
+}
+
+//-------------------------------------------------------------------------------------------------
+static int _associationGateEnd(const associationGateType *pGate) {
+	int end = pGate->predictedIndex + pGate->gate + 1;
+
+	return((end > ASSOCIATION_CHECK_BINS) ? ASSOCIATION_CHECK_BINS : end);
+}
+
+//-------------------------------------------------------------------------------------------------
+static boolean _associationIsPeak(const associationCheckType *pCheck, int bin) {
+	int16_t value = pCheck->pSpectrum[bin];
+
+	return((value >= pCheck->threshold) &&
+		((bin == 0) || (value > pCheck->pSpectrum[bin-1])) &&
+		((bin == (ASSOCIATION_CHECK_BINS-1)) || (value >= pCheck->pSpectrum[bin+1])));
+}
+
+//-------------------------------------------------------------------------------------------------
+static int32_t _associationCost(const associationCheckType *pCheck, int track, int bin) {
+	int32_t distance = bin - pCheck->pGates[track].predictedIndex;
+
+	return((distance * distance * ASSOCIATION_DISTANCE_COST) - (pCheck->pSpectrum[bin] >> ASSOCIATION_MAGNITUDE_SHIFT));
+}
+
+//-------------------------------------------------------------------------------------------------
+static int32_t _associationMissCost(const associationCheckType *pCheck, int track) {
+	int32_t gate = pCheck->pGates[track].gate;
+
+	return((gate + 1) * (gate + 1) * ASSOCIATION_DISTANCE_COST);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Every track tries a miss and every free peak in its gate.  Branches that can't beat the best so
+// far are cut using each remaining track's cheapest choice.
+//-------------------------------------------------------------------------------------------------
+static void _bruteForceAssociation(associationCheckType *pCheck, int track, int32_t cost) {
+	int bin;
+
+	if ((cost + pCheck->lowerBound[track]) >= pCheck->best) {
+		return;
+	}
+	if (track == pCheck->numberOfTracks) {
+		pCheck->best = cost;
+		return;
+	}
+
+	_bruteForceAssociation(pCheck, track+1, cost + _associationMissCost(pCheck, track));
+	for (bin=_associationGateStart(&pCheck->pGates[track]); bin<_associationGateEnd(&pCheck->pGates[track]); bin++) {
+		if (!pCheck->used[bin] && _associationIsPeak(pCheck, bin)) {
+			pCheck->used[bin] = TRUE;
+			_bruteForceAssociation(pCheck, track+1, cost + _associationCost(pCheck, track, bin));
+			pCheck->used[bin] = FALSE;
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// The lowest total cost of any assignment
+//-------------------------------------------------------------------------------------------------
+static int32_t _bestAssociation(associationCheckType *pCheck) {
+	int32_t cheapest, cost;
+	int track, bin;
+
+	pCheck->lowerBound[pCheck->numberOfTracks] = 0;
+	for (track=pCheck->numberOfTracks-1; track>=0; track--) {
+		cheapest = _associationMissCost(pCheck, track);
+		for (bin=_associationGateStart(&pCheck->pGates[track]); bin<_associationGateEnd(&pCheck->pGates[track]); bin++) {
+			cost = _associationCost(pCheck, track, bin);
+			if (_associationIsPeak(pCheck, bin) && (cost < cheapest)) {
+				cheapest = cost;
+			}
+		}
+		pCheck->lowerBound[track] = pCheck->lowerBound[track+1] + cheapest;
+	}
+
+	memset(pCheck->used, 0, sizeof(pCheck->used));
+	pCheck->best = INT32_MAX;
+	_bruteForceAssociation(pCheck, 0, 0);
+	return(pCheck->best);
+}
+
+//-------------------------------------------------------------------------------------------------
+// No peak given to two tracks, and every peak given inside its track's gate.  Returns FALSE if
+// not, otherwise the total cost in *pCost.
+//-------------------------------------------------------------------------------------------------
+static boolean _associationIsValid(associationCheckType *pCheck, const int *pAssignedIndex, int32_t *pCost) {
+	int track, bin;
+
+	memset(pCheck->used, 0, sizeof(pCheck->used));
+	*pCost = 0;
+	for (track=0; track<pCheck->numberOfTracks; track++) {
+		bin = pAssignedIndex[track];
+		if (bin == ASSOCIATION_NOT_ASSIGNED) {
+			*pCost += _associationMissCost(pCheck, track);
+			continue;
+		}
+		if ((bin < _associationGateStart(&pCheck->pGates[track])) || (bin >= _associationGateEnd(&pCheck->pGates[track])) ||
+			pCheck->used[bin] || !_associationIsPeak(pCheck, bin)) {
+			return(FALSE);
+		}
+		pCheck->used[bin] = TRUE;
+		*pCost += _associationCost(pCheck, track, bin);
+	}
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Random spectra and one cluster of overlapping gates, in random slots, for every cluster size up
+// to MAX_NUMBER_OF_TARGETS_TRACKED.  Every assignment has to be valid, and up to
+// ASSOCIATION_OPTIMAL_LIMIT tracks it has to cost no more than the best the brute force finds.
+// Returns the number that fail.
+//-------------------------------------------------------------------------------------------------
+static int _checkAssociation(void) {
+	static int16_t spectrum[ASSOCIATION_CHECK_BINS];
+	associationGateType gates[MAX_NUMBER_OF_TARGETS_TRACKED], swap;
+	associationCheckType check;
+	int assignedIndex[MAX_NUMBER_OF_TARGETS_TRACKED];
+	uint32_t seed = 24680;
+	int numberOfTracks, iteration, bin, range, track, other, predictedIndex, failures;
+	int32_t cost;
+
+	failures = 0;
+	for (numberOfTracks=2; numberOfTracks<=MAX_NUMBER_OF_TARGETS_TRACKED; numberOfTracks++) {
+		for (iteration=0; iteration<ASSOCIATION_CHECK_ITERATIONS; iteration++) {
+			range = (iteration % 3) ? 40 : 30000;
+			for (bin=0; bin<ASSOCIATION_CHECK_BINS; bin++) {
+				seed = (seed * 1103515245) + 12345;
+				spectrum[bin] = (int16_t)(((seed >> 8) % (2 * range)) - (range / 4));
+				if ((bin > 0) && ((seed >> 29) == 0)) {
+					spectrum[bin] = spectrum[bin-1];
+				}
+			}
+
+			// Each gate starts before the furthest end so far, so the gates form one cluster
+			seed			= (seed * 1103515245) + 12345;
+			predictedIndex	= (seed >> 8) % (ASSOCIATION_CHECK_BINS - (numberOfTracks * 2 * MIN_TRACK_GATE));
+			for (track=0; track<numberOfTracks; track++) {
+				seed						= (seed * 1103515245) + 12345;
+				gates[track].predictedIndex	= predictedIndex;
+				gates[track].gate			= MIN_TRACK_GATE + ((seed >> 8) % (MAX_TRACK_GATE + 1 - MIN_TRACK_GATE));
+				predictedIndex				+= (seed >> 20) % ((2 * MIN_TRACK_GATE) + 1);
+			}
+			for (track=numberOfTracks-1; track>0; track--) {
+				seed			= (seed * 1103515245) + 12345;
+				other			= (seed >> 8) % (track + 1);
+				swap			= gates[track];
+				gates[track]	= gates[other];
+				gates[other]	= swap;
+			}
+
+			seed					= (seed * 1103515245) + 12345;
+			check.pSpectrum			= spectrum;
+			check.pGates			= gates;
+			check.numberOfTracks	= numberOfTracks;
+			check.threshold			= (int16_t)((seed >> 8) % range);
+			trackAssociationSolve(spectrum, ASSOCIATION_CHECK_BINS, gates, numberOfTracks, check.threshold, assignedIndex);
+
+			if (!_associationIsValid(&check, assignedIndex, &cost) ||
+				((numberOfTracks <= ASSOCIATION_OPTIMAL_LIMIT) && (cost > _bestAssociation(&check)))) {
+				failures++;
+			}
+		}
+	}
+
+	return(failures);
+}
+
+//-------------------------------------------------------------------------------------------------
+// The search detect() replaced, kept to check it against: rescan the free bins for the strongest
+// once per target, then mark its extent, walking down both shoulders until the spectrum rises.
+// Returns the number of peaks taken, in the order they were taken.
+//-------------------------------------------------------------------------------------------------
+static int _rescanPeaks(boolean *pIsFree, int maximumTargets, int *pIndex, int16_t *pMagnitude) {
+	const int16_t *pSpectrum = fftData.fftOutputArray;
+	int newVehicleIndex, sampleIndex, maximumIndex, startIndex, endIndex, i;
+	int16_t maximum, value, previousValue;
+	boolean matchFound;
+
+	for (newVehicleIndex=0; newVehicleIndex < maximumTargets; newVehicleIndex++) {
+		maximum			= 0;
+		maximumIndex	= 0;
+		for (sampleIndex = SAMPLE_START_LOCATION; sampleIndex < fftData.numberOfBins; sampleIndex++) {
+			if (pIsFree[sampleIndex] && (pSpectrum[sampleIndex] > maximum)) {
+				maximum			= pSpectrum[sampleIndex];
+				maximumIndex	= sampleIndex;
+			}
+		}
+		if ((_IQfromInt(maximum) < fftData.minimumMagnitude) || (maximum < MINIMUM_MAGNITUDE_FROM_SENSITIVITY_ARRAY)) {
+			break;
+		}
+		pIndex[newVehicleIndex]		= maximumIndex;
+		pMagnitude[newVehicleIndex]	= maximum;
+
+		previousValue	= maximum;
+		matchFound		= FALSE;
+		startIndex		= maximumIndex;
+		for (i=maximumIndex-1; (i>=SAMPLE_START_LOCATION) && !matchFound; i--) {
+			value = pSpectrum[i];
+			if (value > previousValue) {
+				matchFound	= TRUE;
+				startIndex	= i;
+			}
+			previousValue = value;
+		}
+
+		previousValue	= maximum;
+		matchFound		= FALSE;
+		endIndex		= maximumIndex;
+		for (i=maximumIndex+1; (i<fftData.numberOfBins) && !matchFound; i++) {
+			value = pSpectrum[i];
+			if (value > previousValue) {
+				matchFound	= TRUE;
+				endIndex	= i;
+			}
+			previousValue = value;
+		}
+
+		for (i=startIndex; i<=endIndex; i++) {
+			pIsFree[i] = FALSE;
+		}
+	}
+	return(newVehicleIndex);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Random spectra, masks of bins under investigation and minimum magnitudes, through ingest and
+// detect of every tracker configuration, with no tracks to start with.  The tracks detect()
+// starts, slot by slot, have to be the peaks the rescan takes.  Returns the number that differ.
+//-------------------------------------------------------------------------------------------------
+static int _checkPeakSearch(void) {
+	static spectrumFrameType frame;
+	static boolean isFree[FFT_OUTPUT_ARRAY_SIZE];
+	const pipelineStageType *pPipeline;
+	int expectedIndex[MAX_NUMBER_OF_TARGETS_TRACKED];
+	int16_t expectedMagnitude[MAX_NUMBER_OF_TARGETS_TRACKED];
+	uint32_t seed = 13579;
+	int size, configuration, iteration, bin, startBin, range, expected, slot, mismatches;
+
+	mismatches = 0;
+	for (size=0; size<NUMBER_OF_FFT_SIZES; size++) {
+		selectFFTSize(fftAnalyzers[size].fftSize);
+		for (configuration=0; configuration<numberOfTrackerConfigurations; configuration++) {
+			if (selectTrackerConfiguration(configuration) != TRUE) {
+				continue;
+			}
+
+			// Leaves the tracker holding frame, which is filled in again for each iteration
+			memset(&frame, 0, sizeof(frame));
+			frame.numberOfBins = fftAnalyzer.numberOfBins;
+			targetTracking.processFrame(&frame);
+			pPipeline = targetTracking.pipeline;
+
+			for (iteration=0; iteration<PEAK_CHECK_ITERATIONS; iteration++) {
+				range = (iteration % 3) ? 40 : 30000;
+				for (bin=0; bin<frame.numberOfBins; bin++) {
+					seed = (seed * 1103515245) + 12345;
+					frame.output[bin] = (uint16_t)(int16_t)(((seed >> 8) % (2 * range)) - (range / 4));
+					if ((bin > 0) && ((seed >> 28) == 0)) {
+						frame.output[bin] = frame.output[bin-1];
+					}
+				}
+
+				targetTracking.reset();
+				binMaskClear(&fftData.binIsUnderInvestigation);
+				for (bin=0; bin<(int)(iteration % 5); bin++) {
+					seed		= (seed * 1103515245) + 12345;
+					startBin	= (seed >> 8) % targetTracking.numberOfBins;
+					binMaskMarkRange(&fftData.binIsUnderInvestigation, startBin, startBin + ((seed >> 20) % 32));
+				}
+				for (bin=0; bin<targetTracking.numberOfBins; bin++) {
+					isFree[bin] = !binMaskIsMarked(&fftData.binIsUnderInvestigation, bin);
+				}
+				seed						= (seed * 1103515245) + 12345;
+				fftData.minimumMagnitude	= _IQfromInt((seed >> 8) % range);
+				if (seed & 0x80000000) {
+					fftData.minimumMagnitude += _IQ(0.5);
+				}
+
+				pPipeline[PIPELINE_INGEST].run();
+				pPipeline[PIPELINE_DETECT].run();
+				expected = _rescanPeaks(isFree, targetTracking.maximumTargets, expectedIndex, expectedMagnitude);
+
+				for (slot=0; slot<targetTracking.maximumTargets; slot++) {
+					if ((slot < expected) ?
+						((systemData.track.index[slot] != expectedIndex[slot]) || (_IQint(systemData.track.magnitude[slot]) != expectedMagnitude[slot])) :
+						(systemData.track.index[slot] != INVALID_VEHICLE_ENTRY)) {
+						mismatches++;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	return(mismatches);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Stands in for the audio interrupt
+//-------------------------------------------------------------------------------------------------
+static void *_queueProducer(void *pArgument) {
+	queueProducerType *pProducer = (queueProducerType *)pArgument;
+	uint64_t next;
+	int frame;
+
+	next = _now_ns();
+	for (frame=0; frame<pProducer->numberOfFrames; frame++) {
+		next += pProducer->period_ns;
+		while (_now_ns() < next) {
+			sched_yield();
+		}
+		frameQueuePush(syntheticFrames[frame % NUMBER_OF_SYNTHETIC_FRAMES], pProducer->numberOfBins);
+	}
+	__atomic_store_n(&pProducer->done, TRUE, __ATOMIC_RELEASE);
+	return(NULL);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Track the producer's frames on this thread.  Each frame has to arrive whole and in order, and
+// every FFT has to be either tracked or counted as an overrun.  With display_ns, the first empty
+// pop after a frame is followed by a display burst that long, as in loop(), and the frame the
+// displays read has to be the one tracked, untouched, at the end of it.  Returns the number of
+// failures.
+//-------------------------------------------------------------------------------------------------
+static int _runFrameQueue(const char *name, int numberOfFrames, uint64_t period_ns, uint64_t display_ns) {
+	queueProducerType producer;
+	pthread_t thread;
+	const spectrumFrameType *pFrame;
+	U32 previousSequence, displays;
+	uint64_t end;
+	boolean done, readyToPrint;
+	int failures;
+
+	frameQueueReset();
+	producer.numberOfFrames	= numberOfFrames;
+	producer.numberOfBins	= fftAnalyzer.numberOfBins;
+	producer.period_ns		= period_ns;
+	producer.done			= FALSE;
+
+	failures			= 0;
+	previousSequence	= 0;
+	displays			= 0;
+	readyToPrint		= FALSE;
+	pthread_create(&thread, NULL, _queueProducer, &producer);
+	for (;;) {
+		// Done has to be read before the queue is found empty, or the last frame could be missed
+		done	= __atomic_load_n(&producer.done, __ATOMIC_ACQUIRE);
+		pFrame	= frameQueuePop();
+		if (pFrame == NULL) {
+			if (done) {
+				break;
+			}
+			if (readyToPrint && (display_ns != 0)) {
+				readyToPrint = FALSE;
+				end = _now_ns() + display_ns;
+				while (_now_ns() < end) {
+					sched_yield();
+				}
+				if ((fftData.pFrame->sequence != previousSequence) ||
+					((const uint16_t *)fftData.fftOutputArray != fftData.pFrame->output) ||
+					(memcmp(fftData.pFrame->output, syntheticFrames[(previousSequence - 1) % NUMBER_OF_SYNTHETIC_FRAMES],
+						fftData.pFrame->numberOfBins * sizeof(uint16_t)) != 0)) {
+					failures++;
+				}
+				displays++;
+			}
+			sched_yield();
+			continue;
+		}
+		if ((pFrame->sequence <= previousSequence) ||
+			(memcmp(pFrame->output, syntheticFrames[(pFrame->sequence - 1) % NUMBER_OF_SYNTHETIC_FRAMES],
+				pFrame->numberOfBins * sizeof(uint16_t)) != 0)) {
+			failures++;
+		}
+		previousSequence = pFrame->sequence;
+		targetTracking.processFrame(pFrame);
+		readyToPrint = TRUE;
+	}
+	pthread_join(thread, NULL);
+
+	// Overruns after the last frame tracked leave no gap for the consumer to see.  The ring has to
+	// have wrapped, or none of this was tested against a slot being reused.
+	if ((frameQueue.popped + frameQueue.overruns != frameQueue.sequence) ||
+		(frameQueue.lost + (frameQueue.sequence - previousSequence) != frameQueue.overruns) ||
+		(frameQueue.popped <= FRAME_QUEUE_DEPTH)) {
+		failures++;
+	}
+	printf("%-24s %9u produced %9u tracked %9u overruns %9u lost %9u displays, deepest %u/%d, %d failures\n",
+		name, frameQueue.sequence, frameQueue.popped, frameQueue.overruns, frameQueue.lost, displays,
+		frameQueue.maximumDepth, FRAME_QUEUE_DEPTH, failures);
+	return(failures);
+}
+
+//-------------------------------------------------------------------------------------------------
+// A streamed spectrum has to match the codes of the frame it was sent on
+//-------------------------------------------------------------------------------------------------
+static boolean _checkStreamedSpectrum(const U8 *pCodes, int frame) {
+	const uint16_t *pSpectrum = syntheticFrames[frame % NUMBER_OF_SYNTHETIC_FRAMES];
+	int bin;
+
+	for (bin=0; bin<fftAnalyzer.numberOfBins; bin++) {
+		if (pCodes[bin] != ((pSpectrum[bin] > spectrumStream.noiseFloor) ? spectrumLogCode(pSpectrum[bin]) : 0)) {
+			return(FALSE);
+		}
+	}
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+// The protocol's telemetry on every frame, with the port taking only what TELEMETRY_BAUD carries
+// in a frame time.  The capture is decoded afterwards, and streamed spectra checked against the
+// frames they were sent on.  Returns the number of failures.
+//-------------------------------------------------------------------------------------------------
+static int _runTelemetry(const char *name, protocolEnumType protocol, int numberOfFrames) {
+	static U8 encoded[TELEMETRY_MAXIMUM_FRAME], message[TELEMETRY_MAXIMUM_FRAME], codes[FFT_OUTPUT_ARRAY_SIZE];
+	const spectrumFrameType *pFrame;
+	FILE *pCapture;
+	int *pStreamedFrame;
+	U32 decoded, bad, gaps, frames, streamed, streamChecked;
+	int frame, value, length, messageLength, sequence, failures;
+	long bytes;
+
+	pCapture		= tmpfile();
+	pStreamedFrame	= (int *)malloc(numberOfFrames * sizeof(int));
+	if ((pCapture == NULL) || (pStreamedFrame == NULL)) {
+		return(1);
+	}
+	Serial.stream = pCapture;
+	serialPort.open();
+	spectrumStreamOpen();
+	spectrumStream.noiseFloor	= NOISE_FLOOR;
+	serialData.protocol			= protocol;
+	frameQueueReset();
+	streamed = 0;
+	for (frame=0; frame<numberOfFrames; frame++) {
+		frameQueuePush(syntheticFrames[frame % NUMBER_OF_SYNTHETIC_FRAMES], fftAnalyzer.numberOfBins);
+		pFrame = frameQueuePop();
+		targetTracking.processFrame(pFrame);
+		if (serialData.protocol == SP_SPECTRUM_STREAM) {
+			frames = serialData.tx.frames;
+			spectrumStreamFrame(pFrame);
+			if (serialData.tx.frames != frames) {
+				pStreamedFrame[streamed++] = frame;
+			}
+		}
+		serialPort.updateDisplay(0);
+		Serial.txSpace = TELEMETRY_BAUD / 10 / fftAnalyzer.fftsPerSecond;
+		serialPort.drain();
+	}
+	Serial.txSpace = TX_RING_SIZE;
+	serialPort.drain();
+	Serial.stream = NULL;
+	bytes = ftell(pCapture);
+
+	rewind(pCapture);
+	decoded			= 0;
+	bad				= 0;
+	gaps			= 0;
+	streamChecked	= 0;
+	sequence		= -1;
+	length			= 0;
+	failures		= 0;
+	while ((value = fgetc(pCapture)) != EOF) {
+		if (value != 0) {
+			if (length < TELEMETRY_MAXIMUM_FRAME) {
+				encoded[length++] = value;
+			}
+			continue;
+		}
+		messageLength = (length < TELEMETRY_MAXIMUM_FRAME) ? cobsDecode(encoded, length, message) : -1;
+		length = 0;
+		if ((messageLength < (TELEMETRY_HEADER_SIZE + TELEMETRY_CRC_SIZE)) ||
+			(telemetryCrc(message, messageLength - TELEMETRY_CRC_SIZE) !=
+				(message[messageLength - 2] | (message[messageLength - 1] << 8)))) {
+			bad++;
+			continue;
+		}
+		if (sequence >= 0) {
+			gaps += (U8)(message[1] - sequence - 1);
+		}
+		sequence = message[1];
+		decoded++;
+
+		// The whole spectrum every frame, so a message that isn't a keyframe follows the last one
+		if (message[0] == TELEMETRY_SPECTRUM_STREAM) {
+			if (message[TELEMETRY_HEADER_SIZE] & SPECTRUM_STREAM_KEYFRAME) {
+				memset(codes, 0, sizeof(codes));
+			}
+			if ((streamChecked >= streamed) ||
+				!spectrumStreamDecode(&message[TELEMETRY_HEADER_SIZE + SPECTRUM_STREAM_HEADER_SIZE],
+					messageLength - TELEMETRY_HEADER_SIZE - SPECTRUM_STREAM_HEADER_SIZE - TELEMETRY_CRC_SIZE,
+					codes, fftAnalyzer.numberOfBins) ||
+				!_checkStreamedSpectrum(codes, pStreamedFrame[streamChecked])) {
+				failures++;
+			}
+			streamChecked++;
+		}
+	}
+	fclose(pCapture);
+	free(pStreamedFrame);
+
+	failures += ((bad != 0) || (length != 0) || (decoded != serialData.tx.frames) || (gaps != serialData.tx.dropped) ||
+		(streamChecked != streamed));
+	printf("%-24s %9u sent %9u dropped %9u bad %9u streamed %9.1f bytes/frame, %d failures\n",
+		name, serialData.tx.frames, serialData.tx.dropped, bad, streamed, (double)bytes / numberOfFrames, failures);
+	return(failures);
+}
+
+//-------------------------------------------------------------------------------------------------
+// SP_POLLED on a link shared by two units, as the unit at unitAddress.  Every POLL_INTERVAL frames
+// and at the end the host polls both units for everything, with an XON and an XOFF and a query
+// with a bad CRC in among the queries.  Only the queries for this unit may be answered, every
+// good frame has to be one of those replies, and the counts since the last poll have to add up
+// across the other unit's queries.  Then a query in a text protocol has to go unanswered.
+// Returns the number of failures.
+//-------------------------------------------------------------------------------------------------
+static int _runPolled(const char *name, U16 unitAddress, int numberOfFrames) {
+	static U8 encoded[TELEMETRY_MAXIMUM_FRAME], message[TELEMETRY_MAXIMUM_FRAME];
+	const U8 flowControl[] = {0x11, 0x13};
+	U8 query[4][POLL_QUERY_SIZE];
+	FILE *pCapture;
+	const U8 *pCounts;
+	U32 polls, replies, wrong, junk, counted, ffts, answered;
+	int frame, value, length, messageLength, failures;
+	uint64_t start, poll_ns;
+
+	pCapture = tmpfile();
+	if (pCapture == NULL) {
+		return(1);
+	}
+	telemetryBuildPollQuery(1, POLL_ALL, query[0]);
+	telemetryBuildPollQuery(2, POLL_ALL, query[1]);
+	telemetryBuildPollQuery(unitAddress, POLL_ALL, query[2]);
+	query[2][POLL_QUERY_SIZE - 1] ^= 0x01;				// Bad CRC
+	telemetryBuildPollQuery(unitAddress, POLL_COUNTS, query[3]);
+
+	Serial.txSpace = TX_RING_SIZE;
+	serialPort.open();
+	serialData.protocol = SP_POLLED;
+	memset(&pollState, 0, sizeof(pollState));
+	pollState.unitAddress = unitAddress;
+	frameQueueReset();
+	systemData.statistics.counter = 0;
+	Serial.inject(query[3], POLL_QUERY_SIZE);				// Start the counts from here
+	serialPort.monitor();
+	serialPort.drain();
+	memset(&pollState, 0, sizeof(pollState));
+	pollState.unitAddress = unitAddress;
+	Serial.stream = pCapture;
+
+	polls	= 0;
+	poll_ns	= 0;
+	for (frame=1; frame<=numberOfFrames; frame++) {
+		frameQueuePush(syntheticFrames[frame % NUMBER_OF_SYNTHETIC_FRAMES], fftAnalyzer.numberOfBins);
+		targetTracking.processFrame(frameQueuePop());
+		serialPort.updateDisplay(0);
+		if (((frame % POLL_INTERVAL) == 0) || (frame == numberOfFrames)) {
+			Serial.inject(query[2], POLL_QUERY_SIZE);
+			Serial.inject(query[0], POLL_QUERY_SIZE);
+			Serial.inject(flowControl, sizeof(flowControl));
+			Serial.inject(query[1], POLL_QUERY_SIZE);
+			start = _now_ns();
+			serialPort.monitor();
+			poll_ns += _now_ns() - start;
+			polls++;
+		}
+		serialPort.drain();
+	}
+	Serial.stream = NULL;
+
+	rewind(pCapture);
+	replies	= 0;
+	wrong	= 0;
+	junk	= 0;
+	counted	= 0;
+	ffts	= 0;
+	length	= 0;
+	while ((value = fgetc(pCapture)) != EOF) {
+		if (value != 0) {
+			if (length < TELEMETRY_MAXIMUM_FRAME) {
+				encoded[length++] = value;
+			}
+			continue;
+		}
+		messageLength = (length < TELEMETRY_MAXIMUM_FRAME) ? cobsDecode(encoded, length, message) : -1;
+		length = 0;
+		if ((messageLength < TELEMETRY_HEADER_SIZE + TELEMETRY_CRC_SIZE) ||
+			(telemetryCrc(message, messageLength - TELEMETRY_CRC_SIZE) !=
+				(message[messageLength - 2] | (message[messageLength - 1] << 8)))) {
+			junk++;							// The command processor's text reply to the flow control bytes
+			continue;
+		}
+		if ((messageLength < TELEMETRY_HEADER_SIZE + 3 + 26 + TELEMETRY_CRC_SIZE) || (message[0] != TELEMETRY_POLL_REPLY) ||
+			((message[TELEMETRY_HEADER_SIZE] | (message[TELEMETRY_HEADER_SIZE + 1] << 8)) != unitAddress) ||
+			(message[TELEMETRY_HEADER_SIZE + 2] != POLL_ALL)) {
+			wrong++;
+			continue;
+		}
+		// The counts come first: U32 millis, U32 counted, U32 milliseconds, U16 counted, U32 FFTs, ...
+		pCounts	= &message[TELEMETRY_HEADER_SIZE + 3];
+		counted	+= pCounts[12] | (pCounts[13] << 8);
+		ffts	+= pCounts[14] | (pCounts[15] << 8) | (pCounts[16] << 16) | ((U32)pCounts[17] << 24);
+		replies++;
+	}
+	fclose(pCapture);
+
+	// Not in a text protocol
+	answered = pollState.answered;
+	serialData.protocol = SP_TRACKING;
+	Serial.inject(query[unitAddress - 1], POLL_QUERY_SIZE);
+	serialPort.monitor();
+	serialPort.drain();
+
+	failures = ((wrong != 0) || (length != 0) || (replies != polls) || (pollState.answered != answered) ||
+		(pollState.bad != polls) || (pollState.otherUnits != polls) ||
+		(counted != (U32)systemData.statistics.counter) || (ffts != (U32)numberOfFrames));
+	printf("%-24s %9u polls %9u replies %9u other %9u counted %9.1f ns/poll, %d failures\n",
+		name, polls, replies, wrong + junk, counted, (double)poll_ns / polls, failures);
+	return(failures);
+}
+
+//-------------------------------------------------------------------------------------------------
+// The file sink, with a failure every sinkFailEvery writes
+//-------------------------------------------------------------------------------------------------
+static boolean _testSinkWrite(const U8 *pBlock, U32 number) {
+	sinkWrites++;
+	if ((sinkFailEvery != 0) && ((sinkWrites % sinkFailEvery) == 0)) {
+		return(FALSE);
+	}
+	return(dataLogFileSink.write(pBlock, number));
+}
+
+static const dataLogSinkType testSink = {
+	"test",
+	dataLogFileSink.open,
+	_testSinkWrite,
+	dataLogFileSink.flush,
+	dataLogFileSink.close,
+};
+
+//-------------------------------------------------------------------------------------------------
+// Reads the log back.  Returns the number of failures: spectra that don't match their frame,
+// records that don't parse, and records or blocks missing that the logger didn't count.
+//-------------------------------------------------------------------------------------------------
+static int _checkDataLog(const char *pPath, U32 *pRecords) {
+	static U8 block[DATALOG_BLOCK_SIZE], record[DATALOG_RECORD_HEADER_SIZE + 10 + (2 * FFT_OUTPUT_ARRAY_SIZE)];
+	FILE *pLog;
+	U32 blocks, blocksLost, records, recordsMissing, nextRecord, sequence;
+	int position, length, needed, failures;
+	boolean resync;
+
+	*pRecords	= 0;
+	pLog		= fopen(pPath, "rb");
+	if (pLog == NULL) {
+		return(1);
+	}
+	blocks			= 0;
+	blocksLost		= 0;
+	records			= 0;
+	recordsMissing	= 0;
+	nextRecord		= 0;
+	failures		= 0;
+	length			= 0;
+	needed			= 0;
+	resync			= FALSE;
+	while (fread(block, 1, DATALOG_BLOCK_SIZE, pLog) == DATALOG_BLOCK_SIZE) {
+		if ((block[0] | (block[1] << 8)) != DATALOG_BLOCK_MAGIC) {
+			continue;
+		}
+		sequence = block[4] | (block[5] << 8) | (block[6] << 16) | ((U32)block[7] << 24);
+		position = DATALOG_BLOCK_HEADER_SIZE;
+		if (sequence != blocks + blocksLost) {
+			blocksLost	+= sequence - (blocks + blocksLost);
+			resync		= TRUE;
+		}
+		blocks++;
+		if (resync) {
+			position	= block[2] | (block[3] << 8);
+			length		= 0;
+			if (position == DATALOG_NO_RECORD) {
+				continue;
+			}
+			resync = FALSE;
+		}
+		for (; position<DATALOG_BLOCK_SIZE; position++) {
+			if ((length == 0) && (block[position] == DATALOG_PADDING)) {
+				break;
+			}
+			record[length++] = block[position];
+			if (length == DATALOG_RECORD_HEADER_SIZE) {
+				needed = DATALOG_RECORD_HEADER_SIZE + (record[2] | (record[3] << 8));
+				if (needed > (int)sizeof(record)) {
+					failures++;
+					resync = TRUE;
+					break;
+				}
+			}
+			if ((length < DATALOG_RECORD_HEADER_SIZE) || (length != needed)) {
+				continue;
+			}
+			sequence		= record[4] | (record[5] << 8) | (record[6] << 16) | ((U32)record[7] << 24);
+			recordsMissing	+= sequence - nextRecord;
+			nextRecord		= sequence + 1;
+			records++;
+			if (record[0] == DATALOG_SPECTRUM) {
+				// Frame sequence 1 was syntheticFrames[0]
+				sequence = record[8] | (record[9] << 8) | (record[10] << 16) | ((U32)record[11] << 24);
+				if ((needed != (DATALOG_RECORD_HEADER_SIZE + 10 + (2 * fftAnalyzer.numberOfBins))) ||
+					(memcmp(&record[DATALOG_RECORD_HEADER_SIZE + 10], syntheticFrames[(sequence - 1) % NUMBER_OF_SYNTHETIC_FRAMES],
+					2 * fftAnalyzer.numberOfBins) != 0)) {
+					failures++;
+				}
+			}
+			length = 0;
+		}
+	}
+	fclose(pLog);
+
+	// Records cut off by a lost block are missing too, so only a log without failures is exact
+	recordsMissing += dataLog.recordSequence - nextRecord;
+	if (dataLog.blocksFailed == 0) {
+		failures += (recordsMissing != dataLog.recordsDropped) || (blocks != dataLog.blocksWritten);
+	} else {
+		failures += (recordsMissing < dataLog.recordsDropped) || (blocks + blocksLost > dataLog.blocksWritten + dataLog.blocksFailed);
+	}
+	*pRecords = records;
+	return(failures);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Logs every frame, calling dataLogService() up to servicesPerFrame times after each, or until
+// nothing is waiting if 0, into a log of capacity blocks.  A log that fills up has to say so and
+// stay inside its blocks.  Returns the number of failures.
+//-------------------------------------------------------------------------------------------------
+static int _runDataLog(const char *name, int servicesPerFrame, int failEvery, U32 capacity, int numberOfFrames) {
+	char path[] = "/tmp/datalogXXXXXX";
+	const spectrumFrameType *pFrame;
+	uint64_t start, log_ns;
+	U32 records;
+	int frame, service, descriptor, failures;
+
+	descriptor = mkstemp(path);
+	if (descriptor < 0) {
+		return(1);
+	}
+	close(descriptor);
+	sinkFailEvery	= failEvery;
+	sinkWrites		= 0;
+	frameQueueReset();
+	systemData.statistics.counter = 0;
+	if (!dataLogOpen(&testSink, path, capacity)) {
+		remove(path);
+		return(1);
+	}
+
+	log_ns = 0;
+	for (frame=0; frame<numberOfFrames; frame++) {
+		frameQueuePush(syntheticFrames[frame % NUMBER_OF_SYNTHETIC_FRAMES], fftAnalyzer.numberOfBins);
+		pFrame = frameQueuePop();
+		targetTracking.processFrame(pFrame);
+		start = _now_ns();
+		dataLogFrame(pFrame);
+		for (service=0; (servicesPerFrame == 0) || (service < servicesPerFrame); service++) {
+			if (dataLog.tail == dataLog.head) {
+				break;
+			}
+			dataLogService();
+		}
+		log_ns += _now_ns() - start;
+	}
+	dataLogClose();
+
+	failures = _checkDataLog(path, &records);
+	failures += (dataLog.blocksWritten + dataLog.blocksFailed > capacity) ||
+		(dataLog.full != ((U32)(numberOfFrames * DATALOG_TEST_PREALLOCATE) != capacity)) ||
+		((dataLog.flushes == 0) && (dataLog.blocksWritten != 0));
+	remove(path);
+	printf("%-24s %9.1f ns/frame %9u blocks %9u failed %9u records %9u dropped %6u flushes%s, %d failures\n",
+		name, (double)log_ns / numberOfFrames, dataLog.blocksWritten, dataLog.blocksFailed, records, dataLog.recordsDropped,
+		dataLog.flushes, dataLog.full ? ", full" : "", failures);
+	return(failures);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Replays the recording from the start of the tracker configuration, in protocol, through a port
+// that takes a second's bytes in fftsPerSecond passes of loop().  Returns the number of failures:
+// frames lost or bad, telemetry dropped, or a count different from the run that was recorded.
+//-------------------------------------------------------------------------------------------------
+static int _replayRecording(const char *name, const char *pPath, protocolEnumType protocol, int numberOfFrames, int counted) {
+	U32 dropped;
+	int failures;
+
+	selectFFTSize(1024);
+	memset(sfrData, 0, sizeof(sfrData));
+	systemData.statistics.counter = 0;
+	serialData.protocol = protocol;
+	dropped = serialData.tx.dropped;
+	if (replayOpen(pPath) != TRUE) {
+		return(1);
+	}
+	Serial.txSpace = TELEMETRY_BAUD / 10 / fftAnalyzer.fftsPerSecond;
+	while (replayFrame() == TRUE) {
+		serialPort.drain();
+	}
+	Serial.txSpace = TX_RING_SIZE;
+	serialPort.drain();
+	serialData.protocol = SP_NONE;
+
+	dropped		= serialData.tx.dropped - dropped;
+	failures	= (replay.frames != (U32)numberOfFrames) || (replay.badFrames != 0) ||
+		(systemData.statistics.counter != counted) || (dropped != 0);
+	printf("%-24s %9u frames %9u bad %9d counted %9u waits %9u dropped %9.0f frames/s, tracker %9.0f frames/s, %d failures\n",
+		name, replay.frames, replay.badFrames, systemData.statistics.counter, replay.txWaits, dropped,
+		replay.frames * 1e6 / replay.elapsed_us, replay.frames * 1e6 / replay.tracker_us, failures);
+	return(failures);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Records the frames, as the tracker sees them, to a data log and to displayFFT() text, then
+// replays both.  Returns the number of failures.
+//-------------------------------------------------------------------------------------------------
+static int _runReplay(int numberOfFrames) {
+	char logPath[] = "/tmp/replayXXXXXX", textPath[] = "/tmp/replayXXXXXX";
+	const spectrumFrameType *pFrame;
+	FILE *pText;
+	int frame, bin, descriptor, counted, failures;
+
+	descriptor = mkstemp(logPath);
+	if (descriptor < 0) {
+		return(1);
+	}
+	close(descriptor);
+	descriptor = mkstemp(textPath);
+	if ((descriptor < 0) || ((pText = fdopen(descriptor, "w")) == NULL)) {
+		remove(logPath);
+		return(1);
+	}
+
+	serialPort.open();
+	serialData.protocol = SP_NONE;
+	serialPort.updateDisplay(0);			// "Protocol Changed"
+	selectFFTSize(1024);
+	memset(sfrData, 0, sizeof(sfrData));
+	systemData.statistics.counter = 0;
+	frameQueueReset();
+	failures = (dataLogOpen(&dataLogFileSink, logPath, numberOfFrames * DATALOG_TEST_PREALLOCATE) != TRUE);
+	for (frame=0; frame<numberOfFrames; frame++) {
+		frameQueuePush(syntheticFrames[frame % NUMBER_OF_SYNTHETIC_FRAMES], fftAnalyzer.numberOfBins);
+		pFrame = frameQueuePop();
+		targetTracking.processFrame(pFrame);
+		dataLogFrame(pFrame);
+		while (dataLog.tail != dataLog.head) {
+			dataLogService();
+		}
+		fprintf(pText, "%s, ", fftAnalyzer.name);
+		for (bin=0; bin<pFrame->numberOfBins; bin++) {
+			fprintf(pText, "%u, ", pFrame->output[bin]);
+		}
+		fprintf(pText, "\r\n");
+	}
+	dataLogClose();
+	fclose(pText);
+	counted = systemData.statistics.counter;
+
+	failures += _replayRecording("data log", logPath, SP_NONE, numberOfFrames, counted);
+	failures += _replayRecording("displayFFT text", textPath, SP_NONE, numberOfFrames, counted);
+	failures += _replayRecording("data log, spectrum out", logPath, SP_BINARY_SPECTRUM, numberOfFrames, counted);
+	remove(logPath);
+	remove(textPath);
+	return(failures);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Generated traffic with numberOfVehicles on the road, from the start of the tracker
+// configuration.  The generator and the tracker are timed apart.
+//-------------------------------------------------------------------------------------------------
+static void _runScenario(int numberOfVehicles, int numberOfFrames) {
+	static trafficScenarioType scenario;
+	static uint16_t output[FFT_OUTPUT_ARRAY_SIZE];
+	scenarioSettingsType settings = SCENARIO_SETTINGS_DEFAULTS;
+	uint64_t start, generate_ns, track_ns;
+	int frame;
+
+	selectFFTSize(1024);
+	memset(sfrData, 0, sizeof(sfrData));
+	systemData.statistics.counter = 0;
+	frameQueueReset();
+	settings.seed				= SCENARIO_SEED;
+	settings.numberOfVehicles	= numberOfVehicles;
+	scenarioOpen(&scenario, &settings, &fftAnalyzer);
+
+	generate_ns	= 0;
+	track_ns	= 0;
+	for (frame=0; frame<numberOfFrames; frame++) {
+		start = _now_ns();
+		scenarioFrame(&scenario, output, fftAnalyzer.numberOfBins);
+		generate_ns += _now_ns() - start;
+
+		start = _now_ns();
+		frameQueuePush(output, fftAnalyzer.numberOfBins);
+		targetTracking.processFrame(frameQueuePop());
+		track_ns += _now_ns() - start;
+	}
+	printf("%8d %9u %9d %14.1f %14.1f %9.0fx\n", numberOfVehicles, scenario.vehiclesPassed, systemData.statistics.counter,
+		(double)generate_ns / numberOfFrames, (double)track_ns / numberOfFrames,
+		(numberOfFrames * scenario.framePeriod) / ((generate_ns + track_ns) * 1e-9));
+}
+
+#ifdef USE_PROFILING
+//-------------------------------------------------------------------------------------------------
+// loop() as it runs on the unit: one pass takes the frame, the next finds none and updates the
+// display.  The profile is printed, then what a probe costs against the time per frame.
+//-------------------------------------------------------------------------------------------------
+static void _runProfile(int numberOfFrames) {
+	uint64_t start, loop_ns, probe_ns, record_ns;
+	U32 probes, stageRecords, trackerProbes;
+	double tracker_ns, overhead_ns;
+	int frame, point, i;
+
+	selectFFTSize(1024);
+	memset(sfrData, 0, sizeof(sfrData));
+	systemData.statistics.counter = 0;
+	serialPort.open();
+	serialData.protocol = SP_SFR;
+	frameQueueReset();
+	Serial.stream	= NULL;
+	Serial.txSpace	= TX_RING_SIZE;
+	profileReset();
+
+	loop_ns = 0;
+	for (frame=0; frame<numberOfFrames; frame++) {
+		frameQueuePush(syntheticFrames[frame % NUMBER_OF_SYNTHETIC_FRAMES], fftAnalyzer.numberOfBins);
+		timer.displayCounter = 1000;		// The millisecond interrupt doesn't run on the host
+		start = _now_ns();
+		loop();
+		loop();
+		loop_ns += _now_ns() - start;
+	}
+
+	// The pipeline times its stages anyway, so a stage only adds the record.  The tracker's time is
+	// the frame probe's, around processFrame().
+	stageRecords = 0;
+	for (point=0; point<NUMBER_OF_PIPELINE_STAGES; point++) {
+		stageRecords += profile[point].runs;
+	}
+	probes = 0;
+	for (point=NUMBER_OF_PIPELINE_STAGES; point<NUMBER_OF_PROFILE_POINTS; point++) {
+		probes += profile[point].runs;
+	}
+	trackerProbes	= profile[PROFILE_SORT].runs + profile[PROFILE_SIDE_FIRING].runs;
+	tracker_ns		= _ticksToNs(profile[PROFILE_FRAME].total);
+	Serial.stream = stdout;
+	profileReport(TRUE);
+	Serial.stream = NULL;
+
+	start = _now_ns();
+	for (i=0; i<PROBE_COST_ITERATIONS; i++) {
+		PROFILE_BEGIN(cycles);
+		PROFILE_END(PROFILE_SERIAL, cycles);
+	}
+	probe_ns = _now_ns() - start;
+	start = _now_ns();
+	for (i=0; i<PROBE_COST_ITERATIONS; i++) {
+		PROFILE_ADD(PROFILE_SERIAL, 0, (U32)i);
+	}
+	record_ns = _now_ns() - start;
+	profileReset();
+
+	printf("%.1f probes a frame at %.1f ns and %.1f stage records at %.1f ns\n",
+		(double)probes / numberOfFrames, (double)probe_ns / PROBE_COST_ITERATIONS,
+		(double)stageRecords / numberOfFrames, (double)record_ns / PROBE_COST_ITERATIONS);
+	overhead_ns = ((double)probes * probe_ns / PROBE_COST_ITERATIONS) + ((double)stageRecords * record_ns / PROBE_COST_ITERATIONS);
+	printf("Overhead: %.2f%% of %.1f ns/frame in loop(), %.4f%% of the %d FFTs/s frame time\n",
+		100.0 * overhead_ns / loop_ns, (double)loop_ns / numberOfFrames,
+		100.0 * overhead_ns / numberOfFrames / (1e9 / fftAnalyzer.fftsPerSecond), fftAnalyzer.fftsPerSecond);
+	overhead_ns = ((double)trackerProbes * probe_ns / PROBE_COST_ITERATIONS) + ((double)stageRecords * record_ns / PROBE_COST_ITERATIONS);
+	printf("Tracker overhead: %.2f%% of %.1f ns/frame in processFrame()\n",
+		100.0 * overhead_ns / tracker_ns, tracker_ns / numberOfFrames);
+}
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// One second of frames as the case has them, and the check loop() makes at the end of it
+//-------------------------------------------------------------------------------------------------
+static U8 _healthSecond(const healthCaseType *pCase) {
+	const spectrumFrameType *pFrame;
+	int frame, popped;
+
+	popped = 0;
+	for (frame=0; frame<pCase->fftsPerSecond; frame++) {
+		frameQueuePush(syntheticFrames[frame % NUMBER_OF_SYNTHETIC_FRAMES], fftAnalyzer.numberOfBins);
+		if ((frame % pCase->popEvery) == 0) {
+			pFrame = frameQueuePop();
+			if (pFrame != NULL) {
+				targetTracking.processFrame(pFrame);
+				popped++;
+			}
+		}
+	}
+	hostAudioUsage.memoryUsed			= 2;
+	hostAudioUsage.memoryUsedMax		= pCase->audioBlocks;
+	hostAudioUsage.processorUsage		= 10.0;
+	hostAudioUsage.processorUsageMax	= pCase->audioProcessor;
+	systemData.fftsPerSecond			= popped;
+	return(healthCheck());
+}
+
+//-------------------------------------------------------------------------------------------------
+// HEALTH_SECONDS of the case, then the tracker catches up and has a healthy second.  The case's
+// flags have to be raised, and no others, and stay latched after it recovers.  Every frame the
+// queue dropped has to be counted lost.  Returns the number of failures.
+//-------------------------------------------------------------------------------------------------
+static int _runHealth(const healthCaseType *pCase) {
+	uint64_t start, check_ns;
+	int second, failures;
+	U8 flags;
+
+	frameQueueReset();
+	healthReset();
+	flags		= 0;
+	check_ns	= 0;
+	for (second=0; second<HEALTH_SECONDS; second++) {
+		flags |= _healthSecond(pCase);
+	}
+	while (frameQueuePop() != NULL) {
+	}
+	_healthSecond(&healthCases[0]);
+	while (frameQueuePop() != NULL) {
+	}
+
+	start = _now_ns();
+	healthCheck();
+	check_ns = _now_ns() - start;
+
+	failures = ((flags != pCase->expected) || (health.latched != pCase->expected) || (health.flags != 0) ||
+		(health.framesLost != frameQueue.overruns) || (frameQueue.lost != frameQueue.overruns));
+	printf("%-24s flags 0x%02X latched 0x%02X %6u lost %2u/%d blocks %5.1f%% CPU %3u FFTs/s fewest %6.1f ns/check, %d failures\n",
+		pCase->name, flags, health.latched, health.framesLost, health.audioBlocksMaximum, AUDIO_MEMORY_BLOCKS,
+		health.processorMaximum / 10.0, health.fftsPerSecondMinimum, (double)check_ns, failures);
+	return(failures);
+}
+
+#ifdef USE_TRACING
+//-------------------------------------------------------------------------------------------------
+// TRACE_FRAMES of loop() with the millisecond timer interrupt, standing in for the real one, run
+// between passes.  The dump is read back: each line has to be an event, and each stage has to be
+// inside the frame event that ends after it.  Returns the number of failures.
+//-------------------------------------------------------------------------------------------------
+static int _runTrace(const char *pTraceName) {
+	FILE *pDump;
+	char line[256], name[256];
+	U32 ticksPerMillisecond, numberOfEvents, overwritten, frame, start, length, events, stages, frames;
+	U32 stageFrame, stageStart, stageEnd;
+	uint64_t begin, cost_ns;
+	int i, point, failures;
+
+	selectFFTSize(1024);
+	serialPort.open();
+	serialData.protocol = SP_SFR;
+	frameQueueReset();
+	Serial.txSpace = TX_RING_SIZE;
+	traceOpen();
+
+	for (frame=0; frame<TRACE_FRAMES; frame++) {
+		frameQueuePush(syntheticFrames[frame % NUMBER_OF_SYNTHETIC_FRAMES], fftAnalyzer.numberOfBins);
+		timer.displayCounter = 1000;
+		for (i=0; i<TIMER_INTERRUPTS_PER_PASS; i++) {
+			millisecondTimer();
+		}
+		loop();
+		for (i=0; i<TIMER_INTERRUPTS_PER_PASS; i++) {
+			millisecondTimer();
+		}
+		loop();
+	}
+
+	pDump = (pTraceName != NULL) ? fopen(pTraceName, "w+") : tmpfile();
+	if (pDump == NULL) {
+		return(1);
+	}
+	Serial.stream = pDump;
+	traceDump();
+	Serial.stream = NULL;
+
+	// Read it back
+	rewind(pDump);
+	failures	= 0;
+	events		= 0;
+	stages		= 0;
+	frames		= 0;
+	stageFrame	= 0;
+	stageStart	= 0;
+	stageEnd	= 0;
+	numberOfEvents = 0;
+	if ((fgets(line, sizeof(line), pDump) == NULL) ||
+		(sscanf(line, "Trace, %255[^,], %u, %u, %u", name, &ticksPerMillisecond, &numberOfEvents, &overwritten) != 4)) {
+		failures++;
+	}
+	while (fgets(line, sizeof(line), pDump) != NULL) {
+		if (strncmp(line, "Trace end", 9) == 0) {
+			break;
+		}
+		if (sscanf(line, "%255[^,], %u, %u, %u", name, &frame, &start, &length) != 4) {
+			failures++;
+			continue;
+		}
+		events++;
+		for (point=0; (point<NUMBER_OF_PROFILE_POINTS) && (strcmp(name, profilePointNames[point]) != 0); point++) {
+		}
+		if (point < NUMBER_OF_PIPELINE_STAGES) {
+			if ((stages == 0) || (frame != stageFrame)) {
+				stageFrame	= frame;
+				stageStart	= start;
+			}
+			stageEnd = start + length;
+			stages++;
+		} else if (point == PROFILE_FRAME) {
+			if ((frame == stageFrame) && (stages != 0) &&
+				(((int32_t)(stageStart - start) < 0) || ((int32_t)(start + length - stageEnd) < 0))) {
+				failures++;
+			}
+			frames++;
+		} else if (point >= NUMBER_OF_PROFILE_POINTS) {
+			failures++;
+		}
+	}
+	fclose(pDump);
+	if ((events != numberOfEvents) || (frames == 0) || (stages == 0)) {
+		failures++;
+	}
+
+	trace.stopped = FALSE;
+	begin = _now_ns();
+	for (i=0; i<TRACE_COST_ITERATIONS; i++) {
+		traceRecord(PROFILE_SERIAL, i, 0);
+	}
+	cost_ns = _now_ns() - begin;
+	traceReset();
+
+	printf("%u events of %u frames, %u written over, %u %s a millisecond, %.1f ns an event, %d failures\n",
+		events, TRACE_FRAMES, overwritten, ticksPerMillisecond, PROFILE_CLOCK_NAME,
+		(double)cost_ns / TRACE_COST_ITERATIONS, failures);
+	return(failures);
+}
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// The text display for the protocol after every frame, written to a temporary file.  Only the
+// display is timed.
+//-------------------------------------------------------------------------------------------------
+static void _runTextOutput(const char *name, protocolEnumType protocol, int numberOfFrames) {
+	uint64_t start, display_ns;
+	long bytes;
+	int frame;
+
+	serialPort.open();
+	serialData.protocol = protocol;
+	frameQueueReset();
+	serialPort.updateDisplay(0);			// "Protocol Changed"
+	Serial.stream = tmpfile();
+	if (Serial.stream == NULL) {
+		return;
+	}
+	display_ns = 0;
+	for (frame=0; frame<numberOfFrames; frame++) {
+		frameQueuePush(syntheticFrames[frame % NUMBER_OF_SYNTHETIC_FRAMES], fftAnalyzer.numberOfBins);
+		targetTracking.processFrame(frameQueuePop());
+		start = _now_ns();
+		serialPort.updateDisplay(0);
+		display_ns += _now_ns() - start;
+	}
+	bytes = ftell(Serial.stream);
+	fclose(Serial.stream);
+	Serial.stream = NULL;
+	printf("%-24s %12.1f ns/frame %9.1f bytes/frame\n", name, (double)display_ns / numberOfFrames, (double)bytes / numberOfFrames);
+}
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+	int numberOfFrames		= DEFAULT_NUMBER_OF_FRAMES;
+	int numberOfVehicles	= DEFAULT_NUMBER_OF_VEHICLES;
+	const char *pTraceName	= NULL;
+	int size, configuration, frame, stage, failures, vehicle, i;
+	pipelineStageTimingType *pTiming;
+	uint64_t start, total_ns, fft1024_ns_per_frame;
+	double ns_per_frame, ns_per_run;
+
+	if (argc > 1) {
+		numberOfFrames = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		numberOfVehicles = atoi(argv[2]);
+	}
+	if (argc > 3) {
+		pTraceName = argv[3];
+	}
+	if ((numberOfFrames <= 0) || (numberOfVehicles < 0)) {
+		fprintf(stderr, "Usage: %s [frames] [vehicles] [trace file]\n", argv[0]);
+		return(1);
+	}
+
+	printf("Spectrum kernels:");
+	for (stage=0; stage<numberOfSpectrumKernelVersions; stage++) {
+		printf(" %s", spectrumKernelVersions[stage]->name);
+	}
+	printf(", using %s\n", spectrumKernels.name);
+	if (_checkSpectrumKernels() != 0) {
+		printf("Spectrum kernels or block-max index do not match the scalar version\n");
+		return(1);
+	}
+	printf("Track association: clusters of 2 to %d tracks, checked against brute force up to %d\n",
+		MAX_NUMBER_OF_TARGETS_TRACKED, (MAX_NUMBER_OF_TARGETS_TRACKED < ASSOCIATION_OPTIMAL_LIMIT) ? MAX_NUMBER_OF_TARGETS_TRACKED : ASSOCIATION_OPTIMAL_LIMIT);
+	if (_checkAssociation() != 0) {
+		printf("Track association gave a peak twice, outside its gate, or not at the lowest cost\n");
+		return(1);
+	}
+
+	// Keep the sketch's own prints out of the report
+	Serial.stream = NULL;
+	setup();
+
+	printf("Peak search: %d frames through detect() of each tracker configuration, against the rescan it replaced\n", PEAK_CHECK_ITERATIONS);
+	if (_checkPeakSearch() != 0) {
+		printf("detect() didn't start tracks on the peaks the rescan takes\n");
+		return(1);
+	}
+
+	fft1024_ns_per_frame = 0;
+	for (size=0; size<NUMBER_OF_FFT_SIZES; size++) {
+		selectFFTSize(fftAnalyzers[size].fftSize);
+		_buildSyntheticFrames(fftAnalyzer.numberOfBins, numberOfVehicles);
+
+		for (configuration=0; configuration<numberOfTrackerConfigurations; configuration++) {
+			if (selectTrackerConfiguration(configuration) != TRUE) {
+				continue;
+			}
+			memset(sfrData, 0, sizeof(sfrData));
+			systemData.statistics.counter = 0;
+			trackerPipelineResetTiming();
+			frameQueueReset();
+
+			start = _now_ns();
+			for (frame=0; frame<numberOfFrames; frame++) {
+				frameQueuePush(syntheticFrames[frame % NUMBER_OF_SYNTHETIC_FRAMES], fftAnalyzer.numberOfBins);
+				targetTracking.processFrame(frameQueuePop());
+			}
+			total_ns = _now_ns() - start;
+
+			printf("\n%s %s: %d bins, %d targets, %d frames, %d vehicles, %d counted\n",
+				fftAnalyzer.name, targetTracking.name, targetTracking.numberOfBins, targetTracking.maximumTargets,
+				numberOfFrames, numberOfVehicles, systemData.statistics.counter);
+			printf("%-24s %12s %12s %14s %10s\n", "stage", "ns/frame", "ns/run", "frames/sec", "skipped");
+
+			for (stage=0; stage<NUMBER_OF_PIPELINE_STAGES; stage++) {
+				pTiming		= &trackerPipeline.timing[stage];
+				ns_per_run	= pTiming->runs ? _ticksToNs(pTiming->totalTime) / pTiming->runs : 0.0;
+				printf("%-24s %12.1f %12.1f %14.0f %10u\n", targetTracking.pipeline[stage].name,
+					_ticksToNs(pTiming->totalTime) / numberOfFrames, ns_per_run,
+					(ns_per_run > 0) ? 1e9 / ns_per_run : 0.0, pTiming->skips);
+			}
+			ns_per_frame = (double)total_ns / numberOfFrames;
+			printf("%-24s %12.1f %12s %14.0f %10s\n", "total (wall clock)", ns_per_frame, "", 1e9 / ns_per_frame, "");
+			printf("Headroom over %d FFTs/s: %.1fx\n", fftAnalyzer.fftsPerSecond, (1e9 / ns_per_frame) / fftAnalyzer.fftsPerSecond);
+			if ((size == FFT_SIZE_1024) && (fft1024_ns_per_frame == 0)) {
+				fft1024_ns_per_frame = (uint64_t)ns_per_frame;
+			}
+		}
+	}
+
+	// The full resolution FFT1024 tracker against a producer thread
+	printf("\nFrame queue, FFT1024, producer on its own thread\n");
+	selectFFTSize(1024);
+	_buildSyntheticFrames(fftAnalyzer.numberOfBins, numberOfVehicles);
+	failures	=  _runFrameQueue("paced", numberOfFrames, QUEUE_PACING_FACTOR * fft1024_ns_per_frame, 0);
+	failures	+= _runFrameQueue("overrunning", numberOfFrames, QUEUE_OVERRUN_PERCENT * fft1024_ns_per_frame / 100, 0);
+	failures	+= _runFrameQueue("display bursts", numberOfFrames, QUEUE_PACING_FACTOR * fft1024_ns_per_frame,
+		QUEUE_DISPLAY_PERIODS * QUEUE_PACING_FACTOR * fft1024_ns_per_frame);
+	if (failures != 0) {
+		printf("Frame queue lost or reordered frames\n");
+		return(1);
+	}
+
+	printf("\nTelemetry, FFT1024, %d baud, %d bytes a frame\n", TELEMETRY_BAUD, TELEMETRY_BAUD / 10 / fftAnalyzer.fftsPerSecond);
+	failures	=  _runTelemetry("SP_BINARY_SPECTRUM", SP_BINARY_SPECTRUM, numberOfFrames);
+	failures	+= _runTelemetry("SP_SPECTRUM_STREAM", SP_SPECTRUM_STREAM, numberOfFrames);
+	failures	+= _runPolled("SP_POLLED, unit 1 of 2", 1, numberOfFrames);
+	failures	+= _runPolled("SP_POLLED, unit 2 of 2", 2, numberOfFrames);
+	if (failures != 0) {
+		printf("Telemetry frames were corrupted or dropped without being counted\n");
+		return(1);
+	}
+
+	printf("\nData logger, FFT1024, %d byte blocks, %d buffered\n", DATALOG_BLOCK_SIZE, DATALOG_BUFFER_BLOCKS);
+	failures	=  _runDataLog("card keeping up", 0, 0, numberOfFrames * DATALOG_TEST_PREALLOCATE, numberOfFrames);
+	failures	+= _runDataLog("one block a frame", 1, 0, numberOfFrames * DATALOG_TEST_PREALLOCATE, numberOfFrames);
+	failures	+= _runDataLog("every 16th write fails", 0, 16, numberOfFrames * DATALOG_TEST_PREALLOCATE, numberOfFrames);
+	failures	+= _runDataLog("every write fails", 0, 1, numberOfFrames * DATALOG_TEST_PREALLOCATE, numberOfFrames);
+	failures	+= _runDataLog("log fills up", 0, 0, DATALOG_TEST_FULL, numberOfFrames);
+	if (failures != 0) {
+		printf("Data log records were corrupted or lost without being counted\n");
+		return(1);
+	}
+
+	printf("\nReplay, FFT1024, %d frames, %d vehicles\n", numberOfFrames, numberOfVehicles);
+	if (_runReplay(numberOfFrames) != 0) {
+		printf("Replayed recordings didn't give the same counts\n");
+		return(1);
+	}
+
+	printf("\nScaling, FFT1024 %s, %d frames of generated traffic\n", targetTracking.name, numberOfFrames);
+	printf("%8s %9s %9s %14s %14s %10s\n", "vehicles", "passed", "counted", "generate ns", "track ns", "real time");
+	for (vehicle=1; vehicle<=256; vehicle*=4) {
+		_runScenario(vehicle, numberOfFrames);
+	}
+
+	printf("\nText output, FFT1024\n");
+	_runTextOutput("SP_TRACKING", SP_TRACKING, numberOfFrames);
+	_runTextOutput("SP_SFR", SP_SFR, numberOfFrames);
+	_runTextOutput("SP_SIMULATED", SP_SIMULATED, numberOfFrames);
+
+	printf("\nHealth, FFT1024, %d seconds of each\n", HEALTH_SECONDS);
+	failures = 0;
+	for (i=0; i<NUMBER_OF_HEALTH_CASES; i++) {
+		failures += _runHealth(&healthCases[i]);
+	}
+	Serial.stream = stdout;
+	healthReport();
+	Serial.stream = NULL;
+	if (failures != 0) {
+		printf("The health monitor missed a problem or raised a false one\n");
+		return(1);
+	}
+
+#ifdef USE_PROFILING
+	printf("\nProfile, FFT1024 %s, loop() with SP_SFR\n", targetTracking.name);
+	_runProfile(numberOfFrames);
+#endif
+
+#ifdef USE_TRACING
+	printf("\nTrace, FFT1024 %s, loop() with SP_SFR and the millisecond timer, %d events\n", targetTracking.name, TRACE_EVENTS);
+	if (_runTrace(pTraceName) != 0) {
+		printf("The trace didn't read back\n");
+		return(1);
+	}
+#else
+	if (pTraceName != NULL) {
+		printf("\nNo trace written to %s, tracing isn't built in (make TRACE=1)\n", pTraceName);
+	}
+#endif
+
+	return(0);
+}
+
+/*---- End Of File ----*/
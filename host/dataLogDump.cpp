@@ -0,0 +1,180 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Host (Linux) dump of a USE_DATALOGGING log (see dataLogger.h)
+//
+// Reads the blocks in order and prints one line per record, the same way telemetryDecode prints
+// the matching messages, so spectra come out the way displayFFT() prints them and can be replayed.
+// Blocks without the magic are skipped: the preallocated zeros after the end of the log, and the
+// holes left where the sink failed to write.  A gap in the block sequence is those blocks: the
+// record that was cut off is thrown away and reading starts again at the next block's first record.  Gaps in the record
+// sequence are records the unit dropped.
+//
+// Usage: dataLogDump file
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+#define TRACK_ENTRY_SIZE		9
+#define MAXIMUM_RECORD_SIZE		(DATALOG_RECORD_HEADER_SIZE + 10 + (2 * FFT_OUTPUT_ARRAY_SIZE))
+
+typedef struct {
+	U32 blocks;
+	U32 blocksLost;				// Going by the block sequence
+	U32 records;
+	U32 recordsDropped;			// Going by the record sequence
+	U32 badRecords;
+} dumpStatisticsType;
+
+static dumpStatisticsType dump;
+
+//-------------------------------------------------------------------------------------------------
+static U16 _getU16(const U8 *p) {
+	return(p[0] | (p[1] << 8));
+}
+
+static U32 _getU32(const U8 *p) {
+	return(_getU16(p) | ((U32)_getU16(p + 2) << 16));
+}
+
+//-------------------------------------------------------------------------------------------------
+static void _printSpectrumName(int numberOfBins) {
+	int size;
+
+	for (size=0; (size<NUMBER_OF_FFT_SIZES) && (fftAnalyzers[size].numberOfBins != numberOfBins); size++) {
+	}
+	printf("%s, ", (size < NUMBER_OF_FFT_SIZES) ? fftAnalyzers[size].name : "FFT?");
+}
+
+//-------------------------------------------------------------------------------------------------
+// Prints the record.  Returns FALSE if it's the wrong length for its type.
+//-------------------------------------------------------------------------------------------------
+static boolean _dumpRecord(const U8 *pRecord, int length) {
+	static boolean firstRecord = TRUE;
+	static U32 nextSequence;
+	const U8 *p;
+	U32 sequence;
+	int payloadLength, n, i;
+
+	sequence = _getU32(&pRecord[4]);
+	if (!firstRecord && (sequence != nextSequence)) {
+		dump.recordsDropped += sequence - nextSequence;
+	}
+	firstRecord		= FALSE;
+	nextSequence	= sequence + 1;
+	dump.records++;
+
+	p				= &pRecord[DATALOG_RECORD_HEADER_SIZE];
+	payloadLength	= length - DATALOG_RECORD_HEADER_SIZE;
+
+	switch (pRecord[0]) {
+	case DATALOG_HEADER:
+		if ((payloadLength != 8) || (memcmp(p, "VTLG", 4) != 0)) {
+			return(FALSE);
+		}
+		printf("HEADER version %u, block size %u\n", _getU16(&p[4]), _getU16(&p[6]));
+		break;
+	case DATALOG_SPECTRUM:
+		if ((payloadLength < 10) || (payloadLength != (10 + (2 * _getU16(&p[8]))))) {
+			return(FALSE);
+		}
+		n = _getU16(&p[8]);
+		_printSpectrumName(n);
+		for (i=0, p+=10; i<n; i++, p+=2) {
+			printf("%u, ", _getU16(p));
+		}
+		printf("\n");
+		break;
+	case DATALOG_TRACKS:
+		if ((payloadLength < 5) || (payloadLength != (5 + (p[4] * TRACK_ENTRY_SIZE)))) {
+			return(FALSE);
+		}
+		n = p[4];
+		printf("TRACKS %d", n);
+		for (i=0, p+=5; i<n; i++, p+=TRACK_ENTRY_SIZE) {
+			printf(", %u: I%u M%u C%u T%u", _getU16(&p[0]), _getU16(&p[2]), _getU16(&p[4]), p[6], _getU16(&p[7]));
+		}
+		printf("\n");
+		break;
+	case DATALOG_COUNTS:
+		if (payloadLength != 20) {
+			return(FALSE);
+		}
+		printf("COUNTS %ums, counted %u, FFTs %u, overruns %u, log records dropped %u\n",
+			_getU32(&p[0]), _getU32(&p[4]), _getU32(&p[8]), _getU32(&p[12]), _getU32(&p[16]));
+		break;
+	default:
+		return(FALSE);
+	}
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+	static U8 block[DATALOG_BLOCK_SIZE];
+	static U8 record[MAXIMUM_RECORD_SIZE];
+	FILE *pInput;
+	U32 expected, sequence;
+	int position, first, length, needed;
+	boolean resync;
+
+	if ((argc < 2) || ((pInput = fopen(argv[1], "rb")) == NULL)) {
+		fprintf(stderr, "Usage: %s file\n", argv[0]);
+		return(1);
+	}
+
+	expected	= 0;
+	length		= 0;					// Of the record being put together
+	needed		= 0;					// Its whole length, once the header is in
+	resync		= FALSE;				// Start at the next block's first record
+	while (fread(block, 1, DATALOG_BLOCK_SIZE, pInput) == DATALOG_BLOCK_SIZE) {
+		if (_getU16(&block[0]) != DATALOG_BLOCK_MAGIC) {
+			continue;
+		}
+		dump.blocks++;
+		first		= _getU16(&block[2]);
+		sequence	= _getU32(&block[4]);
+		position	= DATALOG_BLOCK_HEADER_SIZE;
+		if (sequence != expected) {
+			dump.blocksLost += sequence - expected;
+			resync = TRUE;
+		}
+		expected = sequence + 1;
+		if (resync) {
+			length = 0;
+			if (first == DATALOG_NO_RECORD) {
+				continue;				// Still inside the record that was cut off
+			}
+			resync		= FALSE;
+			position	= first;
+		}
+
+		while (position < DATALOG_BLOCK_SIZE) {
+			if ((length == 0) && (block[position] == DATALOG_PADDING)) {
+				break;
+			}
+			record[length++] = block[position++];
+			if (length == DATALOG_RECORD_HEADER_SIZE) {
+				needed = DATALOG_RECORD_HEADER_SIZE + _getU16(&record[2]);
+				if (needed > MAXIMUM_RECORD_SIZE) {
+					dump.badRecords++;	// Lost track of the records
+					resync = TRUE;
+					break;
+				}
+			}
+			if ((length >= DATALOG_RECORD_HEADER_SIZE) && (length == needed)) {
+				if (!_dumpRecord(record, length)) {
+					dump.badRecords++;
+				}
+				length = 0;
+			}
+		}
+	}
+	fclose(pInput);
+
+	fprintf(stderr, "%u blocks, %u lost, %u records, %u dropped, %u bad\n",
+		dump.blocks, dump.blocksLost, dump.records, dump.recordsDropped, dump.badRecords);
+	return(dump.badRecords != 0);
+}
+
+/*---- End Of File ----*/
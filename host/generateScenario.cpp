@@ -0,0 +1,60 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Host (Linux) traffic scenario generator (see trafficScenario.h)
+//
+// Writes the frames to stdout the way displayFFT() prints them, so they can go straight to
+// replayRecording, and the ground truth to stderr.  Everything not given on the command line is
+// from SCENARIO_SETTINGS_DEFAULTS.
+//
+// Usage: generateScenario [frames] [vehicles] [seed] [fft size]
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+#define DEFAULT_NUMBER_OF_FRAMES	(69 * 60)	// A minute of FFT1024
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+	static trafficScenarioType scenario;
+	static uint16_t output[FFT_OUTPUT_ARRAY_SIZE];
+	scenarioSettingsType settings = SCENARIO_SETTINGS_DEFAULTS;
+	int numberOfFrames	= DEFAULT_NUMBER_OF_FRAMES;
+	int fftSize			= 1024;
+	int size, frame, bin;
+
+	if (argc > 1) {
+		numberOfFrames = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		settings.numberOfVehicles = atoi(argv[2]);
+	}
+	if (argc > 3) {
+		settings.seed = strtoul(argv[3], NULL, 0);
+	}
+	if (argc > 4) {
+		fftSize = atoi(argv[4]);
+	}
+	for (size=0; (size<NUMBER_OF_FFT_SIZES) && (fftAnalyzers[size].fftSize != fftSize); size++) {
+	}
+	if ((numberOfFrames <= 0) || (settings.numberOfVehicles < 0) || (size >= NUMBER_OF_FFT_SIZES)) {
+		fprintf(stderr, "Usage: %s [frames] [vehicles] [seed] [fft size]\n", argv[0]);
+		return(1);
+	}
+
+	scenarioOpen(&scenario, &settings, &fftAnalyzers[size]);
+	for (frame=0; frame<numberOfFrames; frame++) {
+		scenarioFrame(&scenario, output, fftAnalyzers[size].numberOfBins);
+		printf("%s, ", fftAnalyzers[size].name);
+		for (bin=0; bin<fftAnalyzers[size].numberOfBins; bin++) {
+			printf("%u, ", output[bin]);
+		}
+		printf("\r\n");
+	}
+
+	fprintf(stderr, "%d frames, %.1f s, %d vehicles on the road, %u passed the radar\n",
+		numberOfFrames, numberOfFrames * scenario.framePeriod, scenario.settings.numberOfVehicles, scenario.vehiclesPassed);
+	return(0);
+}
+
+/*---- End Of File ----*/
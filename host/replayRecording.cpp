@@ -0,0 +1,58 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Host (Linux) replay of a recording through the tracker (see replay.h)
+//
+// Runs the sketch's setup(), then every frame of the recording through the tracker as fast as it
+// can, and writes what the protocol sends for each frame to stdout: SP_TRACKING text by default,
+// or telemetry for telemetryDecode with protocol 9 or above.  The same recording always gives the
+// same tracks and counts.  The frame rates, with and without the reading and the output, go to
+// stderr.
+//
+// Usage: replayRecording file [protocol]
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+extern void setup(void);
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+	int protocol = SP_TRACKING;
+
+	if (argc > 2) {
+		protocol = atoi(argv[2]);
+	}
+	if ((argc < 2) || (protocol <= SP_NONE) || (protocol > SP_POLLED)) {
+		fprintf(stderr, "Usage: %s file [protocol]\n", argv[0]);
+		return(1);
+	}
+
+	// Keep the sketch's own prints, and "Protocol Changed", out of the output
+	Serial.stream = NULL;
+	setup();
+	serialData.protocol = (protocolEnumType)protocol;
+	serialPort.updateDisplay(0);
+	serialPort.drain();
+	systemData.statistics.counter = 0;
+
+	if (replayOpen(argv[1]) != TRUE) {
+		fprintf(stderr, "Can't open %s\n", argv[1]);
+		return(1);
+	}
+	Serial.stream	= stdout;
+	Serial.txSpace	= TX_RING_SIZE;		// The port keeps up, so no telemetry is dropped
+	while (replayFrame() == TRUE) {
+		serialPort.drain();
+	}
+	serialPort.drain();
+	fflush(stdout);
+
+	Serial.stream = stderr;
+	Serial.print(argv[1]);
+	replayReport();
+	Serial.println();
+	return(replay.badFrames != 0);
+}
+
+/*---- End Of File ----*/
@@ -0,0 +1,288 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Host (Linux) decoder for the SP_BINARY telemetry stream
+//
+// Reads what the port sent, from a file or stdin, splits it into frames at each 0x00 and prints
+// one line per message.  Spectra, streamed ones too, are printed the way displayFFT() prints them,
+// so a capture can be replayed.  Frames that are not valid COBS, fail the CRC or have the wrong
+// length for their type are counted and skipped; a run of bytes that isn't telemetry at all (a
+// text reply) shows up as one bad frame.  Gaps in the sequence are frames the unit dropped, or
+// that were lost on the way.
+//
+// A streamed spectrum is a delta from the last one, so after a gap they are skipped until the
+// next keyframe.  Bins outside the streamed range are printed as 0, and magnitudes are the
+// bottom of their log step (see spectrumStream.h).
+//
+// Usage: telemetryDecode [file]
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+#define TRACK_ENTRY_SIZE	9
+#define SFR_ENTRY_SIZE		7
+#define COUNTS_SIZE			22
+#define POLL_COUNTS_SIZE	26
+#define POLL_HEALTH_SIZE	14
+
+typedef struct {
+	U32 frames;
+	U32 badFrames;
+	U32 sequenceGaps;			// Frames missing, going by the sequence numbers
+	int sequence;				// Of the last good frame, -1 before the first
+	U32 streamSkipped;			// Streamed spectra that came before a keyframe
+} decoderStatisticsType;
+
+static decoderStatisticsType decoder = {0, 0, 0, -1, 0};
+
+// The streamed spectrum so far.  Only valid while streamSynced.
+static boolean streamSynced = FALSE;
+static U16 streamHeader[3];		// Analyzer bins, first bin and bins of the last one
+static U8 streamCodes[FFT_OUTPUT_ARRAY_SIZE];
+
+//-------------------------------------------------------------------------------------------------
+static U16 _getU16(const U8 *p) {
+	return(p[0] | (p[1] << 8));
+}
+
+static U32 _getU32(const U8 *p) {
+	return(_getU16(p) | ((U32)_getU16(p + 2) << 16));
+}
+
+//-------------------------------------------------------------------------------------------------
+static void _printSpectrumName(int numberOfBins) {
+	int size;
+
+	for (size=0; (size<NUMBER_OF_FFT_SIZES) && (fftAnalyzers[size].numberOfBins != numberOfBins); size++) {
+	}
+	printf("%s, ", (size < NUMBER_OF_FFT_SIZES) ? fftAnalyzers[size].name : "FFT?");
+}
+
+//-------------------------------------------------------------------------------------------------
+// Returns FALSE if the message is malformed
+//-------------------------------------------------------------------------------------------------
+static boolean _decodeSpectrumStream(const U8 *p, int payloadLength) {
+	int analyzerBins, firstBin, numberOfBins, i;
+
+	if (payloadLength < SPECTRUM_STREAM_HEADER_SIZE) {
+		return(FALSE);
+	}
+	analyzerBins	= _getU16(&p[1]);
+	firstBin		= _getU16(&p[3]);
+	numberOfBins	= _getU16(&p[5]);
+	if ((analyzerBins > FFT_OUTPUT_ARRAY_SIZE) || ((firstBin + numberOfBins) > analyzerBins)) {
+		return(FALSE);
+	}
+
+	if (p[0] & SPECTRUM_STREAM_KEYFRAME) {
+		memset(streamCodes, 0, sizeof(streamCodes));
+		streamHeader[0]	= analyzerBins;
+		streamHeader[1]	= firstBin;
+		streamHeader[2]	= numberOfBins;
+		streamSynced	= TRUE;
+	} else if (!streamSynced || (streamHeader[0] != analyzerBins) || (streamHeader[1] != firstBin) || (streamHeader[2] != numberOfBins)) {
+		decoder.streamSkipped++;
+		streamSynced = FALSE;
+		return(TRUE);
+	}
+	if (!spectrumStreamDecode(&p[SPECTRUM_STREAM_HEADER_SIZE], payloadLength - SPECTRUM_STREAM_HEADER_SIZE, streamCodes, numberOfBins)) {
+		streamSynced = FALSE;
+		return(FALSE);
+	}
+
+	_printSpectrumName(analyzerBins);
+	for (i=0; i<analyzerBins; i++) {
+		if ((i < firstBin) || (i >= (firstBin + numberOfBins))) {
+			printf("0, ");
+		} else {
+			printf("%u, ", spectrumLogValue(streamCodes[i - firstBin]));
+		}
+	}
+	printf("\n");
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Returns FALSE if the message is malformed
+//-------------------------------------------------------------------------------------------------
+static boolean _decodePollReply(const U8 *p, int payloadLength) {
+	const U8 *pEnd = p + payloadLength;
+	int mask, n, i;
+
+	if (payloadLength < 3) {
+		return(FALSE);
+	}
+	printf("POLL unit %u", _getU16(p));
+	p += 2;
+	mask = *p++;
+	if (mask & POLL_COUNTS) {
+		if ((pEnd - p) < POLL_COUNTS_SIZE) {
+			return(FALSE);
+		}
+		printf(" %ums, counted %u, last %ums: counted %u, FFTs %u, overruns %u, dropped %u;",
+			_getU32(&p[0]), _getU32(&p[4]), _getU32(&p[8]), _getU16(&p[12]), _getU32(&p[14]), _getU32(&p[18]), _getU32(&p[22]));
+		p += POLL_COUNTS_SIZE;
+	}
+	if (mask & POLL_TRACKS) {
+		if (((pEnd - p) < 1) || ((pEnd - p) < (1 + (p[0] * TRACK_ENTRY_SIZE)))) {
+			return(FALSE);
+		}
+		n = *p++;
+		printf(" tracks %d", n);
+		for (i=0; i<n; i++, p+=TRACK_ENTRY_SIZE) {
+			printf(", %u: I%u M%u C%u T%u", _getU16(&p[0]), _getU16(&p[2]), _getU16(&p[4]), p[6], _getU16(&p[7]));
+		}
+		printf(";");
+	}
+	if (mask & POLL_NOISE_FLOOR) {
+		if ((pEnd - p) < 4) {
+			return(FALSE);
+		}
+		printf(" minimum magnitude %u, new track threshold %u;", _getU16(&p[0]), _getU16(&p[2]));
+		p += 4;
+	}
+	if (mask & POLL_RATE) {
+		if ((pEnd - p) < 4) {
+			return(FALSE);
+		}
+		printf(" %u FFTs/s, deepest %u/%d;", _getU16(&p[0]), _getU16(&p[2]), FRAME_QUEUE_DEPTH);
+		p += 4;
+	}
+	if (mask & POLL_HEALTH) {
+		if ((pEnd - p) < POLL_HEALTH_SIZE) {
+			return(FALSE);
+		}
+		printf(" health 0x%02X, latched 0x%02X, lost %u, audio blocks %u/%u, audio CPU %u.%u%%, fewest %u FFTs/s;",
+			p[0], p[1], _getU32(&p[2]), _getU16(&p[6]), _getU16(&p[8]), _getU16(&p[10]) / 10, _getU16(&p[10]) % 10, _getU16(&p[12]));
+		p += POLL_HEALTH_SIZE;
+	}
+	printf("\n");
+	return(p == pEnd);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Prints the message.  Returns FALSE if it's the wrong length for its type.
+//-------------------------------------------------------------------------------------------------
+static boolean _decodeMessage(const U8 *pMessage, int length) {
+	const U8 *p;
+	int payloadLength, n, i;
+
+	p				= &pMessage[TELEMETRY_HEADER_SIZE];
+	payloadLength	= length - TELEMETRY_HEADER_SIZE - TELEMETRY_CRC_SIZE;
+
+	switch (pMessage[0]) {
+	case TELEMETRY_COUNTS:
+		if (payloadLength != COUNTS_SIZE) {
+			return(FALSE);
+		}
+		printf("COUNTS %ums, %u FFTs/s, counted %u, FFTs %u, overruns %u, dropped %u\n",
+			_getU32(&p[0]), _getU16(&p[4]), _getU32(&p[6]), _getU32(&p[10]), _getU32(&p[14]), _getU32(&p[18]));
+		break;
+	case TELEMETRY_TRACKS:
+		if ((payloadLength < 1) || (payloadLength != (1 + (p[0] * TRACK_ENTRY_SIZE)))) {
+			return(FALSE);
+		}
+		n = p[0];
+		printf("TRACKS %d", n);
+		for (i=0, p++; i<n; i++, p+=TRACK_ENTRY_SIZE) {
+			printf(", %u: I%u M%u C%u T%u", _getU16(&p[0]), _getU16(&p[2]), _getU16(&p[4]), p[6], _getU16(&p[7]));
+		}
+		printf("\n");
+		break;
+	case TELEMETRY_SFR:
+		if ((payloadLength < 1) || (payloadLength != (1 + (p[0] * SFR_ENTRY_SIZE)))) {
+			return(FALSE);
+		}
+		n = p[0];
+		printf("SFR %d", n);
+		for (i=0, p++; i<n; i++, p+=SFR_ENTRY_SIZE) {
+			printf(", %u: state %u I%u Index:%u Magnitude:%u", _getU16(&p[0]), p[2], _getU16(&p[3]), p[5], p[6]);
+		}
+		printf("\n");
+		break;
+	case TELEMETRY_SPECTRUM:
+		if ((payloadLength < 2) || (payloadLength != (2 + (2 * _getU16(p))))) {
+			return(FALSE);
+		}
+		n = _getU16(p);
+		_printSpectrumName(n);
+		for (i=0, p+=2; i<n; i++, p+=2) {
+			printf("%u, ", _getU16(p));
+		}
+		printf("\n");
+		break;
+	case TELEMETRY_SPECTRUM_STREAM:
+		return(_decodeSpectrumStream(p, payloadLength));
+	case TELEMETRY_POLL_REPLY:
+		return(_decodePollReply(p, payloadLength));
+	default:
+		return(FALSE);
+	}
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+static void _decodeFrame(const U8 *pFrame, int length) {
+	static U8 message[TELEMETRY_MAXIMUM_FRAME];		// A bad frame can decode longer than any message
+	int messageLength;
+
+	if (length == 0) {
+		return;							// Back to back delimiters
+	}
+	decoder.frames++;
+	messageLength = -1;
+	if (length < TELEMETRY_MAXIMUM_FRAME) {
+		messageLength = cobsDecode(pFrame, length, message);
+	}
+	if ((messageLength < (TELEMETRY_HEADER_SIZE + TELEMETRY_CRC_SIZE)) ||
+		(telemetryCrc(message, messageLength - TELEMETRY_CRC_SIZE) != _getU16(&message[messageLength - TELEMETRY_CRC_SIZE]))) {
+		decoder.badFrames++;
+		streamSynced = FALSE;
+		return;
+	}
+	if ((decoder.sequence >= 0) && ((U8)(message[1] - decoder.sequence) != 1)) {
+		decoder.sequenceGaps += (U8)(message[1] - decoder.sequence - 1);
+		streamSynced = FALSE;
+	}
+	decoder.sequence = message[1];
+	if (!_decodeMessage(message, messageLength)) {
+		decoder.badFrames++;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+	static U8 frame[TELEMETRY_MAXIMUM_FRAME];
+	FILE *pInput;
+	int value, length;
+
+	pInput = stdin;
+	if (argc > 1) {
+		pInput = fopen(argv[1], "rb");
+		if (pInput == NULL) {
+			fprintf(stderr, "Usage: %s [file]\n", argv[0]);
+			return(1);
+		}
+	}
+
+	// Anything past TELEMETRY_MAXIMUM_FRAME is too long to be telemetry and fails in _decodeFrame()
+	length = 0;
+	while ((value = fgetc(pInput)) != EOF) {
+		if (value == 0) {
+			_decodeFrame(frame, length);
+			length = 0;
+		} else if (length < TELEMETRY_MAXIMUM_FRAME) {
+			frame[length++] = value;
+		}
+	}
+	if (length != 0) {
+		decoder.frames++;
+		decoder.badFrames++;			// Cut off at the end of the capture
+	}
+
+	fprintf(stderr, "%u frames, %u bad, %u missing by sequence, %u streamed spectra skipped waiting for a keyframe\n",
+		decoder.frames, decoder.badFrames, decoder.sequenceGaps, decoder.streamSkipped);
+	return(decoder.badFrames != 0);
+}
+
+/*---- End Of File ----*/
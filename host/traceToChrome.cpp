@@ -0,0 +1,199 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Host (Linux) converter of a USE_TRACING dump (see eventTrace.h) to Chrome trace JSON
+//
+// Reads a capture of the port, skipping everything outside "Trace, ..." and "Trace end", and
+// writes every dump in it to stdout as a Chrome trace: each dump a process, and loop(), the audio
+// interrupt and the millisecond timer interrupt its threads.  Each event is a complete ("X")
+// event with the tracker frame in its args.  Open it in chrome://tracing or ui.perfetto.dev.
+//
+// The events are in the order they ended, so the 32 bit clock is unwrapped from one end to the
+// next.  Times start from the first event of each dump.
+//
+// Usage: traceToChrome [capture]		Reads stdin without a file
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+#define MAXIMUM_LINE		256
+
+typedef enum {
+	THREAD_LOOP = 1,
+	THREAD_AUDIO_INTERRUPT,
+	THREAD_TIMER_INTERRUPT,
+} threadType;
+
+static const char *const threadNames[] = {
+	"",
+	"loop()",
+	"audio interrupt",
+	"millisecond timer interrupt",
+};
+
+typedef struct {
+	int point;
+	U32 frame;
+	uint64_t start;				// Unwrapped
+	U32 length;
+} chromeEventType;
+
+static boolean firstJsonEvent = TRUE;
+
+//-------------------------------------------------------------------------------------------------
+static void _separator(void) {
+	printf(firstJsonEvent ? "\n" : ",\n");
+	firstJsonEvent = FALSE;
+}
+
+//-------------------------------------------------------------------------------------------------
+static threadType _thread(int point) {
+	switch (point) {
+	case PROFILE_FRAME_COPY:
+		return(THREAD_AUDIO_INTERRUPT);
+	case PROFILE_MILLISECOND_TIMER:
+		return(THREAD_TIMER_INTERRUPT);
+	default:
+		return(THREAD_LOOP);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+static int _point(const char *pName) {
+	int point;
+
+	for (point=0; point<NUMBER_OF_PROFILE_POINTS; point++) {
+		if (strcmp(pName, profilePointNames[point]) == 0) {
+			return(point);
+		}
+	}
+	return(-1);
+}
+
+//-------------------------------------------------------------------------------------------------
+static void _stripLine(char *pLine) {
+	pLine[strcspn(pLine, "\r\n")] = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// One dump, from the line after its header.  Returns the number of events, or -1 if it was cut
+// short.
+//-------------------------------------------------------------------------------------------------
+static int _convertDump(FILE *pFile, int dump, U32 ticksPerMillisecond, U32 numberOfEvents) {
+	static chromeEventType *pEvents = NULL;
+	static U32 eventsAllocated = 0;
+	chromeEventType *pEvent;
+	char line[MAXIMUM_LINE], name[MAXIMUM_LINE];
+	U32 frame, start, length, end, lastEnd, count, i;
+	uint64_t time, firstStart;
+	boolean ended = FALSE;
+	int thread;
+
+	if (numberOfEvents > eventsAllocated) {
+		pEvents = (chromeEventType *)realloc(pEvents, numberOfEvents * sizeof(chromeEventType));
+		if (pEvents == NULL) {
+			return(-1);
+		}
+		eventsAllocated = numberOfEvents;
+	}
+
+	count	= 0;
+	time	= 0;
+	lastEnd	= 0;
+	while (fgets(line, sizeof(line), pFile) != NULL) {
+		_stripLine(line);
+		if (strcmp(line, "Trace end") == 0) {
+			ended = TRUE;
+			break;
+		}
+		if ((count >= numberOfEvents) || (sscanf(line, "%255[^,], %u, %u, %u", name, &frame, &start, &length) != 4)) {
+			continue;
+		}
+		end = start + length;
+		if (count == 0) {
+			time = (uint64_t)1 << 32;		// Room for an event a little out of order
+		} else {
+			time += (int32_t)(end - lastEnd);
+		}
+		lastEnd = end;
+
+		pEvent			= &pEvents[count++];
+		pEvent->point	= _point(name);
+		pEvent->frame	= frame;
+		pEvent->start	= time - length;
+		pEvent->length	= length;
+	}
+
+	firstStart = time;
+	for (i=0; i<count; i++) {
+		if (pEvents[i].start < firstStart) {
+			firstStart = pEvents[i].start;
+		}
+	}
+
+	_separator();
+	printf("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Trace %d\"}}", dump, dump);
+	for (thread=THREAD_LOOP; thread<=THREAD_TIMER_INTERRUPT; thread++) {
+		_separator();
+		printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+			dump, thread, threadNames[thread]);
+	}
+	for (i=0, pEvent=pEvents; i<count; i++, pEvent++) {
+		_separator();
+		printf("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+			(pEvent->point >= 0) ? profilePointNames[pEvent->point] : "?", dump, _thread(pEvent->point),
+			(double)(pEvent->start - firstStart) * 1000.0 / ticksPerMillisecond,
+			(double)pEvent->length * 1000.0 / ticksPerMillisecond, pEvent->frame);
+	}
+	return(ended ? (int)count : -1);
+}
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+	FILE *pFile = stdin;
+	char line[MAXIMUM_LINE], clockName[MAXIMUM_LINE];
+	U32 ticksPerMillisecond, numberOfEvents, overwritten;
+	int dump, events;
+
+	if (argc > 2) {
+		fprintf(stderr, "Usage: %s [capture]\n", argv[0]);
+		return(1);
+	}
+	if (argc > 1) {
+		pFile = fopen(argv[1], "r");
+		if (pFile == NULL) {
+			fprintf(stderr, "Can't open %s\n", argv[1]);
+			return(1);
+		}
+	}
+
+	printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	dump = 0;
+	while (fgets(line, sizeof(line), pFile) != NULL) {
+		_stripLine(line);
+		if ((sscanf(line, "Trace, %255[^,], %u, %u, %u", clockName, &ticksPerMillisecond, &numberOfEvents, &overwritten) != 4) ||
+			(ticksPerMillisecond == 0)) {
+			continue;
+		}
+		dump++;
+		events = _convertDump(pFile, dump, ticksPerMillisecond, numberOfEvents);
+		if (events < 0) {
+			fprintf(stderr, "Trace %d: cut short\n", dump);
+		} else {
+			fprintf(stderr, "Trace %d: %d events, %u %s a millisecond, %u written over before the dump\n",
+				dump, events, ticksPerMillisecond, clockName, overwritten);
+		}
+	}
+	printf("\n]}\n");
+
+	if (pFile != stdin) {
+		fclose(pFile);
+	}
+	if (dump == 0) {
+		fprintf(stderr, "No trace found\n");
+		return(1);
+	}
+	return(0);
+}
+
+/*---- End Of File ----*/
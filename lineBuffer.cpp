@@ -0,0 +1,128 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Line Buffer
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+// value / 10 for any 32-bit value, as a multiply and a shift
+#define DIVIDE_BY_10(value)		((U32)(((uint64_t)(value) * 0xCCCCCCCDu) >> 35))
+
+#define NUMBER_SIZE				16		// "-4294967295." and room to spare
+
+static const int32_t _powerOf10[LINE_MAXIMUM_DECIMALS + 1] = {1, 10, 100, 1000, 10000};
+
+//-------------------------------------------------------------------------------------------------
+// Room for length more, sending what is there if it won't fit
+//-------------------------------------------------------------------------------------------------
+static void _reserve(lineBufferType *pLine, int length) {
+	if ((pLine->length + length) > LINE_BUFFER_SIZE) {
+		lineSend(pLine);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Digits from the right, with a point before the last decimals of them.  Returns the first.
+//-------------------------------------------------------------------------------------------------
+static char *_formatDigits(char *pEnd, U32 value, int decimals) {
+	char *p = pEnd;
+	int count;
+	U32 quotient;
+
+	count = 0;
+	do {
+		quotient	= DIVIDE_BY_10(value);
+		*--p		= '0' + (value - (quotient * 10));
+		value		= quotient;
+		if (++count == decimals) {
+			*--p = '.';
+		}
+	} while ((value != 0) || (count <= decimals));
+	return(p);
+}
+
+//-------------------------------------------------------------------------------------------------
+void lineBegin(lineBufferType *pLine) {
+	pLine->length = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+void linePutString(lineBufferType *pLine, const char *pString) {
+	while (*pString) {
+		_reserve(pLine, 1);
+		pLine->text[pLine->length++] = *pString++;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+void linePutChar(lineBufferType *pLine, char value) {
+	_reserve(pLine, 1);
+	pLine->text[pLine->length++] = value;
+}
+
+//-------------------------------------------------------------------------------------------------
+void linePutInt(lineBufferType *pLine, int32_t value) {
+	linePutFixed(pLine, value, 0);
+}
+
+//-------------------------------------------------------------------------------------------------
+void linePutUnsigned(lineBufferType *pLine, U32 value) {
+	char number[NUMBER_SIZE], *p;
+	int length;
+
+	p		= _formatDigits(&number[NUMBER_SIZE], value, 0);
+	length	= &number[NUMBER_SIZE] - p;
+	_reserve(pLine, length);
+	memcpy(&pLine->text[pLine->length], p, length);
+	pLine->length += length;
+}
+
+//-------------------------------------------------------------------------------------------------
+// value is in units of the last decimal: 12345 with 2 decimals is "123.45"
+//-------------------------------------------------------------------------------------------------
+void linePutFixed(lineBufferType *pLine, int32_t value, int decimals) {
+	char number[NUMBER_SIZE], *p;
+	int length;
+
+	p = _formatDigits(&number[NUMBER_SIZE], (value < 0) ? -(U32)value : (U32)value, decimals);
+	if (value < 0) {
+		*--p = '-';
+	}
+	length = &number[NUMBER_SIZE] - p;
+	_reserve(pLine, length);
+	memcpy(&pLine->text[pLine->length], p, length);
+	pLine->length += length;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Rounded to nearest.  floor(2x) + 1, halved, is floor(x + 0.5) without adding a half in _iq.
+//-------------------------------------------------------------------------------------------------
+void linePutIQ(lineBufferType *pLine, _iq value, int decimals) {
+	linePutFixed(pLine, (_IQmpyI32int(value, 2 * _powerOf10[decimals]) + 1) >> 1, decimals);
+}
+
+//-------------------------------------------------------------------------------------------------
+void linePutFloat(lineBufferType *pLine, float value, int decimals) {
+	linePutFixed(pLine, (int32_t)floorf((value * _powerOf10[decimals]) + 0.5f), decimals);
+}
+
+//-------------------------------------------------------------------------------------------------
+void lineSend(lineBufferType *pLine) {
+	if (pLine->length > 0) {
+		Serial.write((const uint8_t *)pLine->text, pLine->length);
+	}
+	pLine->length = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Ends the line the way println() does and sends it
+//-------------------------------------------------------------------------------------------------
+void lineEnd(lineBufferType *pLine) {
+	_reserve(pLine, 2);
+	pLine->text[pLine->length++] = '\r';
+	pLine->text[pLine->length++] = '\n';
+	lineSend(pLine);
+}
+
+/*---- End Of File ----*/
@@ -0,0 +1,39 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Line Buffer
+//
+// Text output for the display protocols.  A line is built in a caller's lineBufferType and goes to
+// the port in one Serial.write() from lineSend(), instead of a call per field.  Numbers are written
+// straight into the buffer: no printf, no dtoa and no division.  A digit is taken off with a
+// multiply by the reciprocal of 10, and fractions are scaled to whole numbers of the last decimal
+// first, so linePutIQ() uses no floating point in the USE_FIXED_POINT build.
+//
+// A line longer than LINE_BUFFER_SIZE is sent in pieces as it is built, never cut short.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef LINE_BUFFER_H
+#define LINE_BUFFER_H
+
+#define LINE_BUFFER_SIZE		128
+#define LINE_MAXIMUM_DECIMALS	4
+
+typedef struct {
+	int length;
+	char text[LINE_BUFFER_SIZE];
+} lineBufferType;
+
+extern void lineBegin(lineBufferType *);
+extern void linePutString(lineBufferType *, const char *);
+extern void linePutChar(lineBufferType *, char);
+extern void linePutInt(lineBufferType *, int32_t);
+extern void linePutUnsigned(lineBufferType *, U32);
+extern void linePutFixed(lineBufferType *, int32_t, int);
+extern void linePutIQ(lineBufferType *, _iq, int);
+extern void linePutFloat(lineBufferType *, float, int);
+extern void lineSend(lineBufferType *);
+extern void lineEnd(lineBufferType *);
+
+#endif   /* #ifndef LINE_BUFFER_H */
+
+/*********************************** End of File ******************************************************/
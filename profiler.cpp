@@ -0,0 +1,102 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Profiler
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+#define CALIBRATION_US		10000
+
+profileStatisticsType profile[NUMBER_OF_PROFILE_POINTS];
+U32 profileTicksPerMillisecond;
+
+const char *const profilePointNames[NUMBER_OF_PROFILE_POINTS] = {
+	"ingest",
+	"findNewTracks",
+	"associate",
+	"update",
+	"classify",
+	"updateMinimumMagnitude",
+	"sort",
+	"sideFiringAlgorithm",
+	"frame copy",
+	"display",
+	"serial",
+	"frame",
+	"command",
+	"millisecond timer",
+};
+
+//-------------------------------------------------------------------------------------------------
+// Starts the cycle counter, which the Teensy core leaves off.  The pipeline timing reads it with or
+// without USE_PROFILING.  It runs at F_CPU; the TSC's rate isn't known, so it is timed against
+// micros().
+//-------------------------------------------------------------------------------------------------
+void profileOpen(void) {
+#if defined(ARM_DWT_CYCCNT)
+	ARM_DEMCR		|= ARM_DEMCR_TRCENA;
+	ARM_DWT_CTRL	|= ARM_DWT_CTRL_CYCCNTENA;
+	profileTicksPerMillisecond = F_CPU / 1000;
+#elif defined(__x86_64__) || defined(__i386__)
+	U32 start_us, start;
+
+	start_us	= micros();
+	start		= profileCycles();
+	while ((micros() - start_us) < CALIBRATION_US) {
+	}
+	profileTicksPerMillisecond = (U32)(((uint64_t)(profileCycles() - start) * 1000) / (micros() - start_us));
+#else
+	profileTicksPerMillisecond = 1000000;
+#endif
+	profileReset();
+}
+
+//-------------------------------------------------------------------------------------------------
+void profileReset(void) {
+	memset(profile, 0, sizeof(profile));
+}
+
+//-------------------------------------------------------------------------------------------------
+// One line a profile point that has run: runs, then minimum, average and maximum.  With
+// histograms, each is followed by its non-empty buckets as "log2:runs".
+//-------------------------------------------------------------------------------------------------
+void profileReport(boolean histograms) {
+	static lineBufferType line;
+	profileStatisticsType *pStatistics;
+	int point, bucket;
+
+	lineBegin(&line);
+	linePutString(&line, "Profile, " PROFILE_CLOCK_NAME ": runs, min, avg, max");
+	lineEnd(&line);
+
+	for (point=0, pStatistics=profile; point<NUMBER_OF_PROFILE_POINTS; point++, pStatistics++) {
+		if (pStatistics->runs == 0) {
+			continue;
+		}
+		lineBegin(&line);
+		linePutString(&line, profilePointNames[point]);
+		linePutString(&line, ": ");
+		linePutUnsigned(&line, pStatistics->runs);
+		linePutString(&line, ", ");
+		linePutUnsigned(&line, pStatistics->minimum);
+		linePutString(&line, ", ");
+		linePutUnsigned(&line, (U32)(pStatistics->total / pStatistics->runs));
+		linePutString(&line, ", ");
+		linePutUnsigned(&line, pStatistics->maximum);
+		if (histograms) {
+			linePutString(&line, " |");
+			for (bucket=0; bucket<PROFILE_HISTOGRAM_BUCKETS; bucket++) {
+				if (pStatistics->histogram[bucket] != 0) {
+					linePutChar(&line, ' ');
+					linePutInt(&line, bucket);
+					linePutChar(&line, ':');
+					linePutUnsigned(&line, pStatistics->histogram[bucket]);
+				}
+			}
+		}
+		lineEnd(&line);
+	}
+}
+
+/*---- End Of File ----*/
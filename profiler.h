@@ -0,0 +1,145 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Profiler
+//
+// Cycle counts of each hot-path stage, for USE_PROFILING, which is off unless built in.  A stage is
+// wrapped in PROFILE_BEGIN() and PROFILE_END(), which read the cycle counter and keep, for each
+// profile point, the runs, the minimum, total and maximum, and a histogram of log2 of the cycles.
+// Without USE_PROFILING the probes are nothing at all.
+//
+// The pipeline times its stages from the same counter (see trackerPipeline.h), so a stage only
+// adds the record, with PROFILE_ADD().  sort and sideFiringAlgorithm run inside a stage and are
+// only probed one frame in PROFILE_SAMPLE_FRAMES, so their runs are a sample.  That keeps the
+// probes to under 1% of the tracker's time (0.7% in the host benchmark, where a pair of TSC reads
+// is over 40 ns).  The probes around the display, serial output and commands are outside the
+// tracker.
+//
+// The counter is the DWT cycle counter on Cortex-M (Teensy 3 and 4), the TSC on x86 hosts, and
+// nanoseconds from clock_gettime() anywhere else.
+//
+// The report goes out on the "profile" command, with the histograms, and with SP_FFT_TIMING
+// without them.  "profile,reset" starts the counts again.
+//
+// With USE_TRACING the same probes also put each run in the event trace - see eventTrace.h.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#if defined(ARM_DWT_CYCCNT)
+	#define PROFILE_CLOCK_NAME		"cycles"
+#elif defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define PROFILE_CLOCK_NAME		"TSC ticks"
+#else
+	#include <time.h>
+	#define PROFILE_CLOCK_NAME		"ns"
+#endif
+
+#define PROFILE_HISTOGRAM_BUCKETS	32		// Bucket n counts runs of 2^n to 2^(n+1)-1
+#define PROFILE_SAMPLE_FRAMES		16		// Probes inside a stage run one frame in this many.  A power of two.
+
+// The first NUMBER_OF_PIPELINE_STAGES are in pipeline stage order
+typedef enum {
+	PROFILE_INGEST,
+	PROFILE_FIND_NEW_TRACKS,
+	PROFILE_ASSOCIATE,
+	PROFILE_UPDATE,
+	PROFILE_CLASSIFY,
+	PROFILE_UPDATE_MINIMUM_MAGNITUDE,
+	PROFILE_SORT,							// In classify
+	PROFILE_SIDE_FIRING,					// In classify
+	PROFILE_FRAME_COPY,						// frameQueuePush(), in the audio interrupt
+	PROFILE_DISPLAY,						// serialPort.monitor() and updateDisplay()
+	PROFILE_SERIAL,							// serialPort.drain()
+	PROFILE_FRAME,							// targetTracking.processFrame(), all the stages
+	PROFILE_COMMAND,						// processCommands()
+	PROFILE_MILLISECOND_TIMER,				// millisecondTimer(), in its interrupt
+	NUMBER_OF_PROFILE_POINTS
+} profilePointType;
+
+typedef struct {
+	U32 runs;
+	U32 minimum;
+	U32 maximum;
+	uint64_t total;
+	U32 histogram[PROFILE_HISTOGRAM_BUCKETS];
+} profileStatisticsType;
+
+extern profileStatisticsType profile[NUMBER_OF_PROFILE_POINTS];
+extern const char *const profilePointNames[NUMBER_OF_PROFILE_POINTS];
+extern U32 profileTicksPerMillisecond;		// Of profileCycles(), set by profileOpen()
+
+extern void profileOpen(void);
+extern void profileReset(void);
+extern void profileReport(boolean);
+
+//-------------------------------------------------------------------------------------------------
+static inline U32 profileCycles(void) {
+#if defined(ARM_DWT_CYCCNT)
+	return(ARM_DWT_CYCCNT);
+#elif defined(__x86_64__) || defined(__i386__)
+	return((U32)__rdtsc());
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return((U32)(((uint64_t)now.tv_sec * 1000000000) + now.tv_nsec));
+#endif
+}
+
+static inline void profileRecord(profilePointType point, U32 cycles) {
+	profileStatisticsType *pStatistics = &profile[point];
+
+	if ((pStatistics->runs == 0) || (cycles < pStatistics->minimum)) {
+		pStatistics->minimum = cycles;
+	}
+	if (cycles > pStatistics->maximum) {
+		pStatistics->maximum = cycles;
+	}
+	pStatistics->runs++;
+	pStatistics->total += cycles;
+	pStatistics->histogram[31 - __builtin_clz(cycles | 1)]++;
+}
+
+#ifdef USE_PROFILING
+	#define PROFILE_RECORD(point, start, cycles)	profileRecord((point), (cycles))
+#else
+	#define PROFILE_RECORD(point, start, cycles)
+#endif
+#ifdef USE_TRACING
+	#define TRACE_RECORD(point, start, cycles)		traceRecord((point), (start), (cycles))
+#else
+	#define TRACE_RECORD(point, start, cycles)
+#endif
+
+// PROFILE_ADD() takes a run that was already timed, such as a pipeline stage
+#define PROFILE_ADD(point, start, cycles)	do {											\
+		PROFILE_RECORD((point), (start), (cycles));											\
+		TRACE_RECORD((point), (start), (cycles));											\
+	} while (0)
+
+#if defined(USE_PROFILING) || defined(USE_TRACING)
+	#define PROFILE_BEGIN(start)			U32 start = profileCycles()
+	#define PROFILE_END(point, start)		do {											\
+			U32 _cycles = profileCycles() - (start);										\
+			PROFILE_ADD((point), (start), _cycles);											\
+		} while (0)
+	#define PROFILE_SAMPLED()				((trackerPipeline.frames & (PROFILE_SAMPLE_FRAMES - 1)) == 0)
+	#define PROFILE_SAMPLE_BEGIN(start)		U32 start = PROFILE_SAMPLED() ? profileCycles() : 0
+	#define PROFILE_SAMPLE_END(point, start)	do {										\
+			if (PROFILE_SAMPLED()) {														\
+				PROFILE_END((point), (start));												\
+			}																				\
+		} while (0)
+#else
+	#define PROFILE_BEGIN(start)
+	#define PROFILE_END(point, start)
+	#define PROFILE_SAMPLE_BEGIN(start)
+	#define PROFILE_SAMPLE_END(point, start)
+#endif
+
+#endif   /* #ifndef PROFILER_H */
+
+/*********************************** End of File ******************************************************/
@@ -0,0 +1,343 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Replay
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+#include <SD.h>
+
+#define REPLAY_END				-1
+#define REPLAY_CUT_OFF			-2		// Data log blocks were lost part way through a record
+
+replayType replay;
+
+static File replayFile;
+
+static int _getLogByte(void);
+static int _getLogBytes(U8 *, int);
+static boolean _nextLogFrame(void);
+static int _getTextChar(void);
+static boolean _nextTextFrame(void);
+
+//-------------------------------------------------------------------------------------------------
+static U16 _getU16(const U8 *p) {
+	return(p[0] | (p[1] << 8));
+}
+
+static U32 _getU32(const U8 *p) {
+	return(_getU16(p) | ((U32)_getU16(p + 2) << 16));
+}
+
+//-------------------------------------------------------------------------------------------------
+// Returns FALSE if the recording can't be opened.  A replay already running is stopped.
+//-------------------------------------------------------------------------------------------------
+boolean replayOpen(const char *pName) {
+	replayClose();
+	memset(&replay, 0, sizeof(replay));
+
+	replayFile = SD.open(pName, FILE_READ);
+	if (!replayFile) {
+		return(FALSE);
+	}
+	replay.format = REPLAY_TEXT;
+	if ((replayFile.read(replay.buffer, 2) == 2) && (_getU16(replay.buffer) == DATALOG_BLOCK_MAGIC)) {
+		replay.format = REPLAY_DATALOG;
+	}
+	replayFile.seek(0);
+	replay.position	= (replay.format == REPLAY_DATALOG) ? DATALOG_BLOCK_SIZE : 0;
+	replay.active	= TRUE;
+	replay.start_us	= micros();
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+void replayClose(void) {
+	if (!replay.active) {
+		return;
+	}
+	replay.elapsed_us	= micros() - replay.start_us;
+	replay.active		= FALSE;
+	replayFile.close();
+}
+
+//-------------------------------------------------------------------------------------------------
+// Runs the next frame of the recording through the tracker and the display.  Returns FALSE, and
+// closes the replay, at the end of the recording.
+//-------------------------------------------------------------------------------------------------
+boolean replayFrame(void) {
+	boolean haveFrame;
+	U32 start;
+	int size;
+
+	if (!replay.active) {
+		return(FALSE);
+	}
+
+	// The last frame's telemetry has to be out of the tx ring before the next frame's goes in.
+	// A frame with a spectrum fills over half of it, so a replay that didn't wait would outrun the port
+	// and drop frames the run being replayed sent.
+	if (serialData.tx.head != serialData.tx.tail) {
+		serialPort.drain();
+		if (serialData.tx.head != serialData.tx.tail) {
+			replay.txWaits++;
+			return(TRUE);
+		}
+	}
+
+	haveFrame = (replay.format == REPLAY_DATALOG) ? _nextLogFrame() : _nextTextFrame();
+	if (!haveFrame) {
+		replayClose();
+		return(FALSE);
+	}
+
+	if (replay.frame.numberOfBins != fftAnalyzer.numberOfBins) {
+		for (size=0; (size<NUMBER_OF_FFT_SIZES) && (fftAnalyzers[size].numberOfBins != replay.frame.numberOfBins); size++) {
+		}
+		if ((size >= NUMBER_OF_FFT_SIZES) || (selectFFTSize(fftAnalyzers[size].fftSize) != TRUE)) {
+			replay.badFrames++;
+			return(TRUE);
+		}
+	}
+
+	start = micros();
+	targetTracking.processFrame(&replay.frame);
+	replay.tracker_us += micros() - start;
+	replay.frames++;
+
+	if (serialData.protocol == SP_SPECTRUM_STREAM) {
+		spectrumStreamFrame(&replay.frame);
+	}
+	serialPort.updateDisplay(0);
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Appends ", 1234 frames, ..." to the line being printed.  Part way through, the rates so far.
+//-------------------------------------------------------------------------------------------------
+void replayReport(void) {
+	U32 elapsed_us;
+
+	elapsed_us = replay.active ? (micros() - replay.start_us) : replay.elapsed_us;
+	Serial.print(", ");
+	Serial.print(replay.frames);
+	Serial.print(" frames, ");
+	Serial.print(replay.badFrames);
+	Serial.print(" bad, ");
+	Serial.print(replay.blocksLost);
+	Serial.print(" blocks lost, counted ");
+	Serial.print(systemData.statistics.counter);
+	Serial.print(", ");
+	Serial.print((U32)(elapsed_us ? ((uint64_t)replay.frames * 1000000 / elapsed_us) : 0));
+	Serial.print(" frames/s, tracker ");
+	Serial.print((U32)(replay.tracker_us ? ((uint64_t)replay.frames * 1000000 / replay.tracker_us) : 0));
+	Serial.print(" frames/s, telemetry dropped ");
+	Serial.print(serialData.tx.dropped);
+}
+
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Data log
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// The next byte of the record being read, REPLAY_END, or REPLAY_CUT_OFF if blocks were lost and
+// the next record starts at replay.position.  Blocks without the magic are skipped.
+//-------------------------------------------------------------------------------------------------
+static int _getLogByte(void) {
+	U32 sequence;
+	int first;
+
+	while (replay.position >= DATALOG_BLOCK_SIZE) {
+		if (replayFile.read(replay.buffer, DATALOG_BLOCK_SIZE) != DATALOG_BLOCK_SIZE) {
+			return(REPLAY_END);
+		}
+		if (_getU16(&replay.buffer[0]) != DATALOG_BLOCK_MAGIC) {
+			continue;
+		}
+		sequence = _getU32(&replay.buffer[4]);
+		if (sequence != replay.nextBlock) {
+			replay.blocksLost	+= sequence - replay.nextBlock;
+			replay.resync		= TRUE;
+		}
+		replay.nextBlock	= sequence + 1;
+		replay.position		= DATALOG_BLOCK_HEADER_SIZE;
+		if (replay.resync) {
+			first = _getU16(&replay.buffer[2]);
+			if (first == DATALOG_NO_RECORD) {
+				replay.position = DATALOG_BLOCK_SIZE;
+				continue;						// All of it belongs to the record that was cut off
+			}
+			replay.position	= first;
+			replay.resync	= FALSE;
+			return(REPLAY_CUT_OFF);
+		}
+	}
+	return(replay.buffer[replay.position++]);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Into pBytes, or skipped if it's NULL.  Returns 0, REPLAY_END or REPLAY_CUT_OFF.
+//-------------------------------------------------------------------------------------------------
+static int _getLogBytes(U8 *pBytes, int length) {
+	int i, value;
+
+	for (i=0; i<length; i++) {
+		if ((value = _getLogByte()) < 0) {
+			return(value);
+		}
+		if (pBytes != NULL) {
+			pBytes[i] = value;
+		}
+	}
+	return(0);
+}
+
+//-------------------------------------------------------------------------------------------------
+// The next DATALOG_SPECTRUM record into replay.frame.  Returns FALSE at the end of the log.
+//-------------------------------------------------------------------------------------------------
+static boolean _nextLogFrame(void) {
+	U8 header[DATALOG_RECORD_HEADER_SIZE + 10];
+	U8 *pBytes;
+	int result, payloadLength, numberOfBins, i;
+
+	for (;;) {
+		result = _getLogBytes(header, 1);
+		if ((result == 0) && (header[0] == DATALOG_PADDING)) {
+			replay.position = DATALOG_BLOCK_SIZE;
+			continue;
+		}
+		if (result == 0) {
+			result = _getLogBytes(&header[1], DATALOG_RECORD_HEADER_SIZE - 1);
+		}
+		if (result == REPLAY_END) {
+			return(FALSE);
+		}
+		if (result == REPLAY_CUT_OFF) {
+			continue;
+		}
+
+		payloadLength = _getU16(&header[2]);
+		if (header[0] != DATALOG_SPECTRUM) {
+			result = _getLogBytes(NULL, payloadLength);
+		} else if (payloadLength < 10) {
+			replay.badFrames++;
+			result = _getLogBytes(NULL, payloadLength);
+		} else if ((result = _getLogBytes(&header[DATALOG_RECORD_HEADER_SIZE], 10)) == 0) {
+			numberOfBins = _getU16(&header[DATALOG_RECORD_HEADER_SIZE + 8]);
+			if ((numberOfBins > FFT_OUTPUT_ARRAY_SIZE) || (payloadLength != (10 + (2 * numberOfBins)))) {
+				replay.badFrames++;
+				result = _getLogBytes(NULL, payloadLength - 10);
+			} else {
+				// Little-endian into the U16s in place
+				pBytes = (U8 *)replay.frame.output;
+				if ((result = _getLogBytes(pBytes, 2 * numberOfBins)) == 0) {
+					for (i=0; i<numberOfBins; i++) {
+						replay.frame.output[i] = _getU16(&pBytes[2 * i]);
+					}
+					replay.frame.sequence		= _getU32(&header[DATALOG_RECORD_HEADER_SIZE]);
+					replay.frame.numberOfBins	= numberOfBins;
+					return(TRUE);
+				}
+			}
+		}
+		if (result == REPLAY_END) {
+			return(FALSE);
+		}
+		if (result == REPLAY_CUT_OFF) {
+			replay.badFrames += (header[0] == DATALOG_SPECTRUM);
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Text
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+static int _getTextChar(void) {
+	if (replay.position >= replay.length) {
+		replay.length	= replayFile.read(replay.buffer, REPLAY_BUFFER_SIZE);
+		replay.position	= 0;
+		if (replay.length <= 0) {
+			replay.length = 0;
+			return(REPLAY_END);
+		}
+	}
+	return(replay.buffer[replay.position++]);
+}
+
+//-------------------------------------------------------------------------------------------------
+// The next "FFT1024, v, v, ..." line into replay.frame, numbered in order.  Returns FALSE at the
+// end of the file.
+//-------------------------------------------------------------------------------------------------
+static boolean _nextTextFrame(void) {
+	char name[16];
+	int ch, length, size, count;
+	U32 value;
+	boolean digits, bad;
+
+	for (;;) {
+		// The analyzer name, up to the first comma
+		length = 0;
+		while (((ch = _getTextChar()) != REPLAY_END) && (ch != ',') && (ch != '\n')) {
+			if (length < (int)(sizeof(name) - 1)) {
+				name[length++] = ch;
+			}
+		}
+		if (ch == REPLAY_END) {
+			return(FALSE);
+		}
+		name[length] = 0;
+		for (size=0; (size<NUMBER_OF_FFT_SIZES) && (strcmp(name, fftAnalyzers[size].name) != 0); size++) {
+		}
+		if ((ch == '\n') || (size >= NUMBER_OF_FFT_SIZES)) {
+			while ((ch != REPLAY_END) && (ch != '\n')) {
+				ch = _getTextChar();
+			}
+			continue;
+		}
+
+		// The magnitudes, each followed by a comma
+		count	= 0;
+		value	= 0;
+		digits	= FALSE;
+		bad		= FALSE;
+		while (((ch = _getTextChar()) != REPLAY_END) && (ch != '\n')) {
+			if ((ch >= '0') && (ch <= '9')) {
+				value	= (value * 10) + (ch - '0');
+				value	= (value > 0xFFFF) ? 0xFFFF : value;
+				digits	= TRUE;
+			} else if (ch == ',') {
+				if (digits && (count < fftAnalyzers[size].numberOfBins)) {
+					replay.frame.output[count] = value;
+				}
+				count	+= digits;
+				bad		|= !digits;
+				value	= 0;
+				digits	= FALSE;
+			} else if ((ch != ' ') && (ch != '\r')) {
+				bad = TRUE;
+			}
+		}
+		if (digits) {
+			if (count < fftAnalyzers[size].numberOfBins) {
+				replay.frame.output[count] = value;
+			}
+			count++;
+		}
+
+		if (bad || (count != fftAnalyzers[size].numberOfBins)) {
+			replay.badFrames++;
+			continue;
+		}
+		replay.frame.sequence++;
+		replay.frame.numberOfBins = count;
+		return(TRUE);
+	}
+}
+
+/*---- End Of File ----*/
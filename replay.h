@@ -0,0 +1,69 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Replay
+//
+// Feeds recorded spectra through the tracker in place of the analyzer, as fast as they can be
+// read and sent, so a field problem can be run again on the bench or the host and come out the
+// same.  Each frame goes to targetTracking.processFrame() and then to serialPort.updateDisplay(),
+// so what comes out is the selected protocol's track and count stream: text, or telemetry for
+// telemetryDecode.
+//
+// A recording is read through the SD library (on the host, a file) and is one of:
+//	- A data log (dataLogger.h).  Its DATALOG_SPECTRUM records are replayed; the rest are skipped.
+//	- Text, one frame a line, the way displayFFT() prints them: "FFT1024, v, v, ...".  This is also
+//	  what telemetryDecode and dataLogDump print.  Lines that don't start with an analyzer name,
+//	  like the TRACKS lines in between, are skipped.
+// A data log is told apart by the block magic at the start.  The analyzer is changed to match the
+// frames, so a recording can switch FFT sizes part way through.
+//
+// A frame isn't taken until the last one's telemetry has left the tx ring, so a binary protocol
+// replays at the rate the port takes it and nothing is dropped.  replayFrame() returns TRUE
+// without a frame while it waits, and loop() drains the ring in between.
+//
+// The frames per second reported are for the whole replay, reading and output included, and for
+// the tracker alone.  The report ends with serialData.tx.dropped, which stays where it was.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#define REPLAY_BUFFER_SIZE		DATALOG_BLOCK_SIZE
+
+typedef enum {
+	REPLAY_TEXT,
+	REPLAY_DATALOG,
+} replayFormatType;
+
+typedef struct {
+	boolean active;
+	replayFormatType format;
+
+	U32 frames;
+	U32 badFrames;						// Lines or records that weren't a whole frame
+	U32 blocksLost;						// Gaps in a data log's block sequence
+	U32 txWaits;						// Calls that waited for the tx ring to empty
+	U32 start_us;
+	U32 elapsed_us;						// The whole replay, once it's done
+	U32 tracker_us;						// In targetTracking.processFrame()
+
+	// Reader.  A data log is read a block at a time, text in pieces of the same size.
+	U8 buffer[REPLAY_BUFFER_SIZE];
+	int length;
+	int position;
+	U32 nextBlock;						// The data log block sequence expected next
+	boolean resync;						// Blocks were lost, so wait for a block with a record start
+
+	spectrumFrameType frame;
+} replayType;
+
+extern replayType replay;
+
+extern boolean replayOpen(const char *);
+extern void replayClose(void);
+extern boolean replayFrame(void);
+extern void replayReport(void);
+
+#endif   /* #ifndef REPLAY_H */
+
+/*********************************** End of File ******************************************************/
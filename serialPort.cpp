@@ -7,9 +7,6 @@
 #define GLOBAL
 #include "environ.h"
 #include "Arduino.h"
-#include <SD.h>
-
-File myFile;
 
 // Local Function Declarations
 static void _open(void);
@@ -18,14 +15,19 @@ static boolean _processInput(byte);
 static int _getc(void);
 static void _reset(void);
 static void _updateDisplay(U16);
+static void _drainTx(void);
+static boolean _pollQuery(byte);
 static void displayAnalog(void);
 static void displayTracking(void);
 static void displaySFR(void);
-static void displaySFRstate(int);
+static const char *sfrStateName(int);
+static void displayPipelineTiming(void);
 extern void displayFFT(void);
 
 serialPortType serialPort = SERIALPORT_DEFAULTS;
 
+static lineBufferType line;			// The text line being built by the display functions
+
 //-------------------------------------------------------------------------------------------------
 // This function should fill a buffer and return instantly. If it sends too much data it will wait on the buffer to empty which is not correct operation.
 //-------------------------------------------------------------------------------------------------
@@ -40,7 +42,9 @@ static void _updateDisplay(U16 updateRate_ms) {
 
 	if (protocol_z != serialData.protocol) {
 		protocol_z = serialData.protocol;
-		Serial.println("Protocol Changed");
+		if (!PROTOCOL_IS_BINARY(protocol_z)) {
+			Serial.println("Protocol Changed");
+		}
 	}
 
 #ifdef SKIP_THIS
@@ -56,16 +60,24 @@ static void _updateDisplay(U16 updateRate_ms) {
 	case SP_FFT_TIMING:
 		Serial.print("FFTs per second: ");
 		Serial.println(systemData.fftsPerSecond);
+		displayPipelineTiming();
+		healthReport();
+	#ifdef USE_PROFILING
+		profileReport(FALSE);
+	#endif
 		break;
 	case SP_SIMULATED:
-		Serial.print("1:Target,");
-		Serial.print("2:Lock,");
-		Serial.print("3:Patrol,");
-		Serial.print("4:"); Serial.print(displayData.target,0); Serial.print(",");
-		Serial.print("5:"); Serial.print(displayData.lock,0); Serial.print(",");
-		Serial.print("6:"); Serial.print(displayData.patrol,0); Serial.print(",");
-		Serial.print("7:"); Serial.print(displayData.direction); Serial.print(",");
-		Serial.println("8:Faster");
+		lineBegin(&line);
+		linePutString(&line, "1:Target,2:Lock,3:Patrol,4:");
+		linePutFloat(&line, displayData.target, 0);
+		linePutString(&line, ",5:");
+		linePutFloat(&line, displayData.lock, 0);
+		linePutString(&line, ",6:");
+		linePutFloat(&line, displayData.patrol, 0);
+		linePutString(&line, ",7:");
+		linePutInt(&line, displayData.direction);
+		linePutString(&line, ",8:Faster");
+		lineEnd(&line);
 		break;
 	case SP_ANALOG:
 		displayAnalog();
@@ -89,45 +101,54 @@ static void _updateDisplay(U16 updateRate_ms) {
 		Serial.print(", ");
 		Serial.print(fftData.amplitude[1]);
 		Serial.print(": ");
-		for (i=0; (i<FFT_OUTPUT_ARRAY_SIZE) && (i<75); i++) {
+		for (i=0; (i<fftData.numberOfBins) && (i<75); i++) {
 			Serial.print(fftData.fftOutputArray[i]);
 			Serial.print(" ");
 		}
 		Serial.println();
 
-		#ifdef USE_DATALOGGING
-			if (SD.exists("datalog.txt")) {
-				Serial.println("datalog.txt exists.");
-			} else {
-				Serial.println("datalog.txt doesn't exist.");
-			}
-
-			// open the file. note that only one file can be open at a time,
-			// so you have to close this one before opening another.
-			myFile = SD.open("datalog.txt", FILE_WRITE);
-
-			// if the file is available, write to it:
-			if (myFile) {
-				myFile.print(fftData.frequency);
-				myFile.print(", ");
-				myFile.print(fftData.amplitude);
-				myFile.print(", ");
-				for (i=0; (i<FFT_OUTPUT_ARRAY_SIZE) && (i<50); i++) {
-					myFile.print(fftData.fftOutputArray[i]);
-					myFile.print(" ");
-				}
-				myFile.println();
-				myFile.close();
-			} else {
-				// if the file isn't open, pop up an error:
-				Serial.println("error opening datalog.txt");
-			}
-		#endif
 		break;
 	case SP_DEBUG:
+	case SP_POLLED:
+		break;
+	case SP_BINARY_SPECTRUM:
+		telemetrySendSpectrum();
+		// Fall through
+	case SP_BINARY:
+	case SP_SPECTRUM_STREAM:
+		telemetrySendCounts();
+		telemetrySendTracks();
+		telemetrySendSFR();
 		break;
 	}
 }  
+
+//-------------------------------------------------------------------------------------------------
+// Write as much of the tx ring as the port can take right now, which may be none of it
+//-------------------------------------------------------------------------------------------------
+static void _drainTx(void) {
+	U16 tail, pending, chunk;
+	int room;
+
+	tail	= serialData.tx.tail;
+	pending	= serialData.tx.head - tail;
+	room	= Serial.availableForWrite();
+	while ((pending > 0) && (room > 0)) {
+		// Up to the end of the buffer at most, the rest goes on the next pass
+		chunk = TX_RING_SIZE - (tail & (TX_RING_SIZE - 1));
+		if (chunk > pending) {
+			chunk = pending;
+		}
+		if (chunk > room) {
+			chunk = room;
+		}
+		Serial.write(&serialData.tx.buffer[tail & (TX_RING_SIZE - 1)], chunk);
+		tail	+= chunk;
+		pending	-= chunk;
+		room	-= chunk;
+	}
+	serialData.tx.tail = tail;
+}
   
 //-------------------------------------------------------------------------------------------------
 static void _reset(void) {
@@ -147,8 +168,12 @@ static void _monitor(void) {
 
 	commandReceived = FALSE;
 	while (Serial.available()) {
+		value = Serial.read();
+		if (_pollQuery(value)) {
+			continue;
+		}
 		commandReceived = TRUE;
-		serialPort.processInput(Serial.read());
+		serialPort.processInput(value);
 	}
 	if (commandReceived) {
 		commandReceived = FALSE;
@@ -156,7 +181,15 @@ static void _monitor(void) {
 		// clear simulation data
 		memset(&displayData, 0, sizeof(displayData));
 
+		PROFILE_BEGIN(commandStart);
 		processCommands();
+		PROFILE_END(PROFILE_COMMAND, commandStart);
+
+		// A reply lands in the middle of the telemetry.  End it with a delimiter so the receiver
+		// loses no more than the frame it interrupted.
+		if (PROTOCOL_IS_BINARY(serialData.protocol)) {
+			Serial.write((U8)0);
+		}
 
 #ifdef DISABLE
 		while(value) {
@@ -168,6 +201,18 @@ static void _monitor(void) {
 	}
 }
 
+//-------------------------------------------------------------------------------------------------
+// In the binary protocols a poll query is answered straight away and never reaches the command
+// processor, so a poll gets no text back.  Returns TRUE if the byte was part of a query.
+//-------------------------------------------------------------------------------------------------
+static boolean _pollQuery(byte incomingByte) {
+	if (!PROTOCOL_IS_BINARY(serialData.protocol)) {
+		pollState.length = 0;
+		return(FALSE);
+	}
+	return(telemetryPollByte(incomingByte));
+}
+
 //-------------------------------------------------------------------------------------------------
 static boolean _processInput(byte incomingByte) {
 	int i;
@@ -184,14 +229,12 @@ static boolean _processInput(byte incomingByte) {
 		serialData.protocol = SP_NONE;
 		break;
 	case 'c':
-		for (i=0; i<FFT_OUTPUT_ARRAY_SIZE; i++) {
-			fftData.binIsUnderInvestigation[i] = FALSE;
-		}
+		binMaskClear(&fftData.binIsUnderInvestigation);
 		Serial.println("BinInvestigation has been cleared");
 		break;
 	case 'b':
 		for (i=0; i<25; i++) {
-			if (fftData.binIsUnderInvestigation[i]) {
+			if (binMaskIsMarked(&fftData.binIsUnderInvestigation, i)) {
 				Serial.print(i);
 				Serial.print(".");
 			}
@@ -217,7 +260,7 @@ static boolean _processInput(byte incomingByte) {
 
 //-------------------------------------------------------------------------------------------------
 static int _getc(void) {
-	byte returnValue = NULL;
+	byte returnValue = 0;
 
 	if (serialData.rx.tail != serialData.rx.head) {
 		returnValue = serialData.rx.buffer[serialData.rx.tail++];
@@ -229,12 +272,50 @@ static int _getc(void) {
 	return(returnValue);
 }
 
+//-------------------------------------------------------------------------------------------------
+// Average time per run for each pipeline stage, and how many frames it was skipped, since the
+// last report.  The frame queue counts are since startup.
+//-------------------------------------------------------------------------------------------------
+static void displayPipelineTiming(void) {
+	int stage;
+
+	Serial.print("Frames: ");
+	Serial.print(frameQueue.sequence);
+	Serial.print(", overruns ");
+	Serial.print(frameQueue.overruns);
+	Serial.print(", lost ");
+	Serial.print(frameQueue.lost);
+	Serial.print(", deepest ");
+	Serial.print(frameQueue.maximumDepth);
+	Serial.print("/");
+	Serial.println(FRAME_QUEUE_DEPTH);
+	Serial.print("Telemetry frames: ");
+	Serial.print(serialData.tx.frames);
+	Serial.print(", dropped ");
+	Serial.println(serialData.tx.dropped);
+
+	for (stage=0; stage<NUMBER_OF_PIPELINE_STAGES; stage++) {
+		Serial.print(targetTracking.pipeline[stage].name);
+		Serial.print(": ");
+		if (trackerPipeline.timing[stage].runs) {
+			Serial.print((U32)((trackerPipeline.timing[stage].totalTime * 1000) / trackerPipeline.timing[stage].runs / profileTicksPerMillisecond));
+		} else {
+			Serial.print(0);
+		}
+		Serial.print("us, skipped ");
+		Serial.print(trackerPipeline.timing[stage].skips);
+		Serial.print("/");
+		Serial.println(trackerPipeline.frames);
+	}
+	trackerPipelineResetTiming();
+}
+
 //-------------------------------------------------------------------------------------------------
 static void displayAnalog(void) {
 	int i;
 
 	Serial.println("+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++");
-	for (i=0; (i<FFT_OUTPUT_ARRAY_SIZE) && (i<45); i++) {
+	for (i=0; (i<fftData.numberOfBins) && (i<45); i++) {
 //	for (i=0; (i<FFT_OUTPUT_ARRAY_SIZE); i++) {
 #ifdef OLD_VERSION
 		Serial.print(fftData.fftOutputArray[i]);
@@ -246,25 +327,30 @@ static void displayAnalog(void) {
 	Serial.println("===========================================================");
 }
 
+//-------------------------------------------------------------------------------------------------
+// A line per track
 //-------------------------------------------------------------------------------------------------
 static void displayTracking(void) {
-	int searchIndex;
+	int order, searchIndex;
 	int targetsFound;
 	static int counter = 0;
 
 	targetsFound = 0;
 
-	for (searchIndex=0; searchIndex < MAX_NUMBER_OF_TARGETS_TRACKED; searchIndex++) {
-		if ((systemData.targetTracker[searchIndex].index != INVALID_VEHICLE_ENTRY) &&
-			(systemData.targetTracker[searchIndex].index > MIN_INDEX) &&
-			(systemData.targetTracker[searchIndex].magnitude > MIN_MAGNITUDE) &&
-			(systemData.targetTracker[searchIndex].trackCounter > MIN_TRACK)) {
+	// Strongest first
+	for (order=0; order < targetTracking.maximumTargets; order++) {
+		searchIndex = systemData.trackOrder[order];
+		if ((systemData.track.index[searchIndex] != INVALID_VEHICLE_ENTRY) &&
+			(systemData.track.index[searchIndex] > MIN_INDEX) &&
+			(systemData.track.magnitude[searchIndex] > _IQ(MIN_MAGNITUDE)) &&
+			(systemData.track.trackCounter[searchIndex] > MIN_TRACK)) {
 
+			lineBegin(&line);
 			if (targetsFound == 0) {
-				Serial.print(counter++);
-				Serial.print(", old:");
-				Serial.print(systemData.numberOfOldTargetsFound);
-				Serial.print(", ");
+				linePutInt(&line, counter++);
+				linePutString(&line, ", old:");
+				linePutInt(&line, systemData.numberOfOldTargetsFound);
+				linePutString(&line, ", ");
 				if (counter >= 10) {
 					counter = 0;
 				}
@@ -272,100 +358,84 @@ static void displayTracking(void) {
 
 			targetsFound++;
 
-
-			Serial.print(searchIndex);
-			Serial.print(": ");
-
-			Serial.print("Freq:");
-			targetTracking.findFrequency(systemData.targetTracker[searchIndex].index);
-			Serial.print(systemData.frequency.value, 1);
-			Serial.print(", Speed:");
-			Serial.print(systemData.speed.value, 1);
-
-			Serial.print(", ");
-			Serial.print(": I");
-//			Serial.print("Freq:");
-//			Serial.print(fftData.frequency[searchIndex],0);
-//			Serial.print(", ");
-			Serial.print(systemData.targetTracker[searchIndex].index);
-			Serial.print(", M");
-			Serial.print(systemData.targetTracker[searchIndex].magnitude, 0);
-//			Serial.print(systemData.targetTracker[searchIndex].direction);
-//			Serial.print(", ");
-			Serial.print(", T");
-			Serial.print(systemData.targetTracker[searchIndex].trackCounter);
-			Serial.println();
+			// Only the tracks shown need the interpolated frequency, so it is found here
+			targetTracking.findFrequency(systemData.track.index[searchIndex]);
+
+			linePutUnsigned(&line, systemData.track.id[searchIndex]);
+			linePutString(&line, ": Freq:");
+			linePutIQ(&line, systemData.frequency.value, 1);
+			linePutString(&line, ", Speed:");
+			linePutIQ(&line, systemData.speed.value, 1);
+			linePutString(&line, ", : I");
+			linePutInt(&line, systemData.track.index[searchIndex]);
+			linePutString(&line, ", M");
+			linePutIQ(&line, systemData.track.magnitude[searchIndex], 0);
+			linePutString(&line, ", T");
+			linePutInt(&line, systemData.track.trackCounter[searchIndex]);
+			lineEnd(&line);
 		}
 	}
-#ifdef SKIP_THIS
-	if (targetsFound == 0) {
-		Serial.print("0: ");
-		Serial.print(fftData.minimumMagnitude, 2);
-		Serial.println();
-	}
-#endif
 }
 
 //-------------------------------------------------------------------------------------------------
-// Side Firing Radar Algorithm
+// Side Firing Radar Algorithm.  One line for every track being followed.
 //-------------------------------------------------------------------------------------------------
 static void displaySFR(void) {
-	int index;
+	int order, index;
 	static int counter_z = 0;
 	boolean somethingWasDisplayed = FALSE;
 
+	lineBegin(&line);
 	if (counter_z != systemData.statistics.counter) {
 		counter_z = systemData.statistics.counter;
-		Serial.print("Count[");
-		Serial.print(systemData.statistics.counter);
-		Serial.print("]  ");
+		linePutString(&line, "Count[");
+		linePutInt(&line, systemData.statistics.counter);
+		linePutString(&line, "]  ");
 		somethingWasDisplayed = TRUE;
 	}
 
-	for (index=0; (index<MAX_NUMBER_OF_TARGETS_TRACKED) && (sfrData[index].state > SFR_WAITING_FOR_VEHICLE); index++) {
-		Serial.print(index);
-		Serial.print(": ");
-		displaySFRstate(index);
-		Serial.print(" Index:");
-		Serial.print(sfrData[index].confidence.index);
-		Serial.print(" Magnitude:");
-		Serial.print(sfrData[index].confidence.magnitude);
-		Serial.print(".");
-		Serial.print(systemData.targetTracker[index].index);
-		Serial.print(", ");
+	// Strongest first
+	for (order=0; order<targetTracking.maximumTargets; order++) {
+		index = systemData.trackOrder[order];
+		if (sfrData[index].state <= SFR_WAITING_FOR_VEHICLE) {
+			continue;
+		}
+		linePutUnsigned(&line, sfrData[index].trackId);
+		linePutString(&line, ": ");
+		linePutString(&line, sfrStateName(index));
+		linePutString(&line, " Index:");
+		linePutInt(&line, sfrData[index].confidence.index);
+		linePutString(&line, " Magnitude:");
+		linePutInt(&line, sfrData[index].confidence.magnitude);
+		linePutChar(&line, '.');
+		linePutInt(&line, systemData.track.index[index]);
+		linePutString(&line, ", ");
 		somethingWasDisplayed = TRUE;
 	}
 	if (somethingWasDisplayed) {
-		Serial.println();
+		lineEnd(&line);
 	}
 }
 
 //-------------------------------------------------------------------------------------------------
-static void displaySFRstate(int index) {
+static const char *sfrStateName(int index) {
 	switch (sfrData[index].state) {
 	case SFR_INITIAL_STATE:
-		Serial.print("Initial State");
-		break;
+		return("Initial State");
 	case SFR_WAITING_FOR_VEHICLE:
-		Serial.print("Waiting");
-		break;
+		return("Waiting");
 	case SFR_FOUND_VEHICLE:
-		Serial.print("Found");
-		break;
+		return("Found");
 	case SFR_TRACKING_TOWARDS:
-		Serial.print("Tracking Towards");
-		break;
+		return("Tracking Towards");
 	case SFR_DIRECTLY_IN_FRONT:
-		Serial.print("In Front");
-		break;
+		return("In Front");
 	case SFR_TRACKING_AWAY:
-		Serial.print("Tracking Away");
-		break;
+		return("Tracking Away");
 	case SFR_PROCESS_FOUND_VEHICLE_DATA:
-		Serial.print("Processing");
-		break;
+		return("Processing");
 	case SFR_DONE:
-		Serial.print("Done");
-		break;
+		return("Done");
 	}
+	return("");
 }
@@ -16,8 +16,14 @@ typedef enum {
 	SP_SFR,					// 6
 	SP_TRACKING_SIMULATION,	// 7
 	SP_DEBUG,				// 8
+	SP_BINARY,				// 9 Counts, tracks and SFR as telemetry frames - see telemetry.h
+	SP_BINARY_SPECTRUM,		// 10 SP_BINARY plus the spectrum
+	SP_SPECTRUM_STREAM,		// 11 SP_BINARY plus every frame compressed - see spectrumStream.h
+	SP_POLLED,				// 12 Nothing but replies to POLL_QUERY - see telemetry.h
 } protocolEnumType;
 
+#define PROTOCOL_IS_BINARY(protocol)	((protocol) >= SP_BINARY)
+
 #define RS232_BUFFER_SIZE  32
 typedef struct {
 	int head;								// Incremented by the ISR
@@ -25,11 +31,22 @@ typedef struct {
 	int buffer[RS232_BUFFER_SIZE];
 } rs232BufferType;
 
+// Outgoing telemetry frames.  Filled by telemetrySend() and emptied by _drainTx() only as fast
+// as the port will take bytes without blocking.
+#define TX_RING_SIZE		2048	// Bytes.  Has to be a power of two and hold a full spectrum frame.
+typedef struct {
+	U16 head;								// Bytes queued, wraps
+	U16 tail;								// Bytes written to the port, wraps
+	U32 frames;								// Frames queued
+	U32 dropped;							// Frames that didn't fit
+	U8 buffer[TX_RING_SIZE];
+} txRingType;
+
 typedef struct {
 	protocolEnumType protocol;
 	boolean commandReceived;
 	boolean txWaitingForBufferSpace;
-	rs232BufferType	tx;
+	txRingType tx;
 	rs232BufferType	rx;
 } rs232PortType;
 
@@ -49,6 +66,7 @@ typedef struct {
 	void (*reset)(void);
 	void (*updateDisplay)(U16);
 	void (*monitor)(void);
+	void (*drain)(void);			// Move what the port has room for from tx, never waits
 } serialPortType;
 
 extern serialPortType serialPort;
@@ -61,6 +79,7 @@ extern serialPortType serialPort;
 	_reset,						\
     _updateDisplay,				\
 	_monitor,					\
+	_drainTx,					\
 }
 
 /*********************************** End of File ******************************************************/
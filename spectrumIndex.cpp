@@ -0,0 +1,86 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Spectrum Block-Max Index
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+//-------------------------------------------------------------------------------------------------
+void spectrumIndexBuild(spectrumIndexType *pBlockIndex, const int16_t *pSpectrum, int numberOfBins) {
+	spectrumKernels.blockMax(pSpectrum, numberOfBins/SPECTRUM_BLOCK_SIZE, pBlockIndex->maximum, pBlockIndex->maximumIndex);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Keep the stronger of the two.  Callers go from low bins to high so a tie keeps the lower bin.
+//-------------------------------------------------------------------------------------------------
+static inline void _keepStronger(int16_t value, int index, int16_t *pMaximum, int *pMaximumIndex) {
+	if (value > *pMaximum) {
+		*pMaximum		= value;
+		*pMaximumIndex	= index;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Strongest bin from startBin up to endBin
+//-------------------------------------------------------------------------------------------------
+int16_t spectrumIndexWindowMax(const spectrumIndexType *pBlockIndex, const int16_t *pSpectrum, int startBin, int endBin, int *pIndex) {
+	int block, blockStart, blockEnd, index;
+	int16_t maximum, value;
+
+	maximum		= 0;
+	*pIndex		= 0;
+	while (startBin < endBin) {
+		block		= startBin >> SPECTRUM_BLOCK_SHIFT;
+		blockStart	= block << SPECTRUM_BLOCK_SHIFT;
+		blockEnd	= blockStart + SPECTRUM_BLOCK_SIZE;
+
+		if ((startBin == blockStart) && (blockEnd <= endBin)) {
+			_keepStronger(pBlockIndex->maximum[block], pBlockIndex->maximumIndex[block], &maximum, pIndex);
+		} else {
+			if (blockEnd > endBin) {
+				blockEnd = endBin;
+			}
+			value = spectrumKernels.windowMax(pSpectrum, startBin, blockEnd, &index);
+			_keepStronger(value, index, &maximum, pIndex);
+		}
+		startBin = blockEnd;
+	}
+
+	return(maximum);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Strongest bin from startBin up to endBin that is not marked in pMask
+//-------------------------------------------------------------------------------------------------
+int16_t spectrumIndexMaskedArgmax(const spectrumIndexType *pBlockIndex, const int16_t *pSpectrum, const binMaskType *pMask, int startBin, int endBin, int *pIndex) {
+	int block, blockStart, blockEnd, index;
+	U32 blockBits;
+	int16_t maximum, value;
+
+	maximum		= 0;
+	*pIndex		= 0;
+	while (startBin < endBin) {
+		block		= startBin >> SPECTRUM_BLOCK_SHIFT;
+		blockStart	= block << SPECTRUM_BLOCK_SHIFT;
+		blockEnd	= blockStart + SPECTRUM_BLOCK_SIZE;
+		blockBits	= binMaskGetBits(pMask, blockStart) & SPECTRUM_BLOCK_BITS;
+
+		if (blockBits == SPECTRUM_BLOCK_BITS) {
+			// Whole block is under investigation
+		} else if ((blockBits == 0) && (startBin == blockStart) && (blockEnd <= endBin)) {
+			_keepStronger(pBlockIndex->maximum[block], pBlockIndex->maximumIndex[block], &maximum, pIndex);
+		} else {
+			if (blockEnd > endBin) {
+				blockEnd = endBin;
+			}
+			value = spectrumKernels.maskedArgmax(pSpectrum, pMask, startBin, blockEnd, &index);
+			_keepStronger(value, index, &maximum, pIndex);
+		}
+		startBin = blockEnd;
+	}
+
+	return(maximum);
+}
+
+/*---- End Of File ----*/
@@ -0,0 +1,32 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Spectrum Block-Max Index
+//
+// The maximum and its position for every 16-bin block of the present frame, built in one pass
+// when the frame arrives.  Window and masked searches read the block summaries for the blocks
+// they cover completely and only search bins in the partial blocks at either end, or in blocks
+// that are partly under investigation.
+//
+// Results are the same as the spectrumKernels searches over the same range.  A spectrum shorter
+// than FFT_OUTPUT_ARRAY_SIZE only has its own blocks built, and is only searched within its bins.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef SPECTRUM_INDEX_H
+#define SPECTRUM_INDEX_H
+
+#define SPECTRUM_BLOCK_BITS			0xFFFF		// Mask bits for one whole block
+#define NUMBER_OF_SPECTRUM_BLOCKS	(FFT_OUTPUT_ARRAY_SIZE/SPECTRUM_BLOCK_SIZE)
+
+typedef struct {
+	int16_t maximum[NUMBER_OF_SPECTRUM_BLOCKS];			// 0 when no bin in the block is above zero
+	U16 maximumIndex[NUMBER_OF_SPECTRUM_BLOCKS];		// Lowest bin holding the maximum
+} spectrumIndexType;
+
+extern void spectrumIndexBuild(spectrumIndexType *, const int16_t *, int);
+extern int16_t spectrumIndexWindowMax(const spectrumIndexType *, const int16_t *, int, int, int *);
+extern int16_t spectrumIndexMaskedArgmax(const spectrumIndexType *, const int16_t *, const binMaskType *, int, int, int *);
+
+#endif   /* #ifndef SPECTRUM_INDEX_H */
+
+/*********************************** End of File ******************************************************/
@@ -0,0 +1,428 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Spectrum Search Kernels
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+	#include <immintrin.h>
+#endif
+
+// On the host the packed-halfword version is built against a C model of SSUB16/SEL so it is
+// checked along with the others.
+#if defined(__ARM_FEATURE_DSP) || defined(HOST_BUILD)
+	#define BUILD_DSP_SPECTRUM_KERNELS
+#endif
+
+//=================================================================================================
+// Scalar
+//=================================================================================================
+static int16_t _scalarMaskedArgmax(const int16_t *pSpectrum, const binMaskType *pMask, int startBin, int endBin, int *pIndex) {
+	int i, maximumIndex;
+	int16_t maximum, value;
+
+	maximum			= 0;
+	maximumIndex	= 0;
+	for (i=startBin; i<endBin; i++) {
+		if (!binMaskIsMarked(pMask, i)) {
+			value = pSpectrum[i];
+			if (value > maximum) {
+				maximum			= value;
+				maximumIndex	= i;
+			}
+		}
+	}
+
+	*pIndex = maximumIndex;
+	return(maximum);
+}
+
+static int16_t _scalarWindowMax(const int16_t *pSpectrum, int startBin, int endBin, int *pIndex) {
+	int i, maximumIndex;
+	int16_t maximum, value;
+
+	maximum			= 0;
+	maximumIndex	= 0;
+	for (i=startBin; i<endBin; i++) {
+		value = pSpectrum[i];
+		if (value > maximum) {
+			maximum			= value;
+			maximumIndex	= i;
+		}
+	}
+
+	*pIndex = maximumIndex;
+	return(maximum);
+}
+
+static void _scalarBlockMax(const int16_t *pSpectrum, int numberOfBlocks, int16_t *pMaximum, U16 *pMaximumIndex) {
+	int block, maximumIndex;
+
+	for (block=0; block<numberOfBlocks; block++) {
+		pMaximum[block]			= _scalarWindowMax(pSpectrum, block << SPECTRUM_BLOCK_SHIFT, (block+1) << SPECTRUM_BLOCK_SHIFT, &maximumIndex);
+		pMaximumIndex[block]	= maximumIndex;
+	}
+}
+
+static const spectrumKernelType spectrumKernelsScalar = {
+	"scalar",
+	_scalarMaskedArgmax,
+	_scalarWindowMax,
+	_scalarBlockMax,
+};
+
+//=================================================================================================
+// Cortex-M4 DSP extension - two bins per 32-bit word
+//
+// SSUB16 sets the GE flag of each halfword where a >= b and SEL then picks a or b per halfword,
+// which is a packed signed max.  Masked bins are forced to zero, which never beats the starting
+// maximum of zero.  A second pass finds the lowest bin holding the maximum.
+//=================================================================================================
+#ifdef BUILD_DSP_SPECTRUM_KERNELS
+static inline U32 _packedMax16(U32 a, U32 b) {
+#ifdef __ARM_FEATURE_DSP
+	U32 result;
+
+	asm ("ssub16 %0, %1, %2\n\t"
+		 "sel %0, %1, %2"
+		 : "=&r" (result) : "r" (a), "r" (b) : "cc");
+	return(result);
+#else
+	U32 low, high;
+
+	low		= ((int16_t)(a & 0xFFFF) >= (int16_t)(b & 0xFFFF)) ? (a & 0xFFFF) : (b & 0xFFFF);
+	high	= ((int16_t)(a >> 16) >= (int16_t)(b >> 16)) ? (a & 0xFFFF0000) : (b & 0xFFFF0000);
+	return(high | low);
+#endif
+}
+
+static inline U32 _loadPair(const int16_t *p) {
+	U32 pair;
+
+	memcpy(&pair, p, sizeof(pair));		// Unaligned LDR on the M4
+	return(pair);
+}
+
+// Zero the halfwords whose mask bit is set.  bits holds the mask for the pair in its low two bits.
+static inline U32 _maskPair(U32 pair, U32 bits) {
+	U32 keep = ((bits & 1) ? 0 : 0x0000FFFF) | ((bits & 2) ? 0 : 0xFFFF0000);
+
+	return(pair & keep);
+}
+
+static inline int16_t _maxOfPair(U32 pair) {
+	int16_t low		= (int16_t)(pair & 0xFFFF);
+	int16_t high	= (int16_t)(pair >> 16);
+
+	return((high > low) ? high : low);
+}
+
+static int16_t _dspSearch(const int16_t *pSpectrum, const binMaskType *pMask, int startBin, int endBin, int *pIndex) {
+	int i;
+	U32 pairMaximum = 0;
+	int16_t maximum, value;
+
+	for (i=startBin; (i+2)<=endBin; i+=2) {
+		if (pMask) {
+			pairMaximum = _packedMax16(_maskPair(_loadPair(&pSpectrum[i]), binMaskGetBits(pMask, i)), pairMaximum);
+		} else {
+			pairMaximum = _packedMax16(_loadPair(&pSpectrum[i]), pairMaximum);
+		}
+	}
+	maximum = _maxOfPair(pairMaximum);
+	if ((i < endBin) && (!pMask || !binMaskIsMarked(pMask, i)) && (pSpectrum[i] > maximum)) {
+		maximum = pSpectrum[i];
+	}
+
+	*pIndex = 0;
+	if (maximum > 0) {
+		for (i=startBin; i<endBin; i++) {
+			value = pSpectrum[i];
+			if ((value == maximum) && (!pMask || !binMaskIsMarked(pMask, i))) {
+				*pIndex = i;
+				break;
+			}
+		}
+	} else {
+		maximum = 0;
+	}
+	return(maximum);
+}
+
+static int16_t _dspMaskedArgmax(const int16_t *pSpectrum, const binMaskType *pMask, int startBin, int endBin, int *pIndex) {
+	return(_dspSearch(pSpectrum, pMask, startBin, endBin, pIndex));
+}
+
+static int16_t _dspWindowMax(const int16_t *pSpectrum, int startBin, int endBin, int *pIndex) {
+	return(_dspSearch(pSpectrum, NULL, startBin, endBin, pIndex));
+}
+
+static void _dspBlockMax(const int16_t *pSpectrum, int numberOfBlocks, int16_t *pMaximum, U16 *pMaximumIndex) {
+	int block, i, startBin;
+	U32 pairMaximum;
+	int16_t maximum;
+
+	for (block=0; block<numberOfBlocks; block++) {
+		startBin	= block << SPECTRUM_BLOCK_SHIFT;
+		pairMaximum	= 0;
+		for (i=startBin; i<(startBin+SPECTRUM_BLOCK_SIZE); i+=2) {
+			pairMaximum = _packedMax16(_loadPair(&pSpectrum[i]), pairMaximum);
+		}
+		maximum = _maxOfPair(pairMaximum);
+
+		pMaximum[block]			= maximum;
+		pMaximumIndex[block]	= 0;
+		if (maximum > 0) {
+			for (i=startBin; pSpectrum[i] != maximum; i++) {
+			}
+			pMaximumIndex[block] = i;
+		}
+	}
+}
+
+static const spectrumKernelType spectrumKernelsDsp = {
+	"dsp",
+	_dspMaskedArgmax,
+	_dspWindowMax,
+	_dspBlockMax,
+};
+#endif	// BUILD_DSP_SPECTRUM_KERNELS
+
+//=================================================================================================
+// SSE2 - eight bins per vector
+//
+// The mask bits for eight bins are spread across the lanes by comparing against one bit per lane.
+// Masked lanes are zeroed.  The lowest bin holding the maximum comes from a compare and movemask.
+//=================================================================================================
+#ifdef __SSE2__
+static inline __m128i _sse2MaskLanes(const binMaskType *pMask, int bin) {
+	const __m128i laneBits = _mm_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128);
+	__m128i bits = _mm_set1_epi16((short)(binMaskGetBits(pMask, bin) & 0xFF));
+
+	return(_mm_cmpeq_epi16(_mm_and_si128(bits, laneBits), laneBits));
+}
+
+static inline int16_t _sse2HorizontalMax(__m128i vector) {
+	vector = _mm_max_epi16(vector, _mm_srli_si128(vector, 8));
+	vector = _mm_max_epi16(vector, _mm_srli_si128(vector, 4));
+	vector = _mm_max_epi16(vector, _mm_srli_si128(vector, 2));
+	return((int16_t)_mm_cvtsi128_si32(vector));
+}
+
+static int16_t _sse2Search(const int16_t *pSpectrum, const binMaskType *pMask, int startBin, int endBin, int *pIndex) {
+	int i, lanes;
+	__m128i vectorMaximum, vector, target;
+	int16_t maximum, value;
+
+	vectorMaximum = _mm_setzero_si128();
+	for (i=startBin; (i+8)<=endBin; i+=8) {
+		vector = _mm_loadu_si128((const __m128i *)&pSpectrum[i]);
+		if (pMask) {
+			vector = _mm_andnot_si128(_sse2MaskLanes(pMask, i), vector);
+		}
+		vectorMaximum = _mm_max_epi16(vectorMaximum, vector);
+	}
+	maximum = _sse2HorizontalMax(vectorMaximum);
+	for (; i<endBin; i++) {
+		value = pSpectrum[i];
+		if ((value > maximum) && (!pMask || !binMaskIsMarked(pMask, i))) {
+			maximum = value;
+		}
+	}
+
+	*pIndex = 0;
+	if (maximum <= 0) {
+		return(0);
+	}
+
+	target = _mm_set1_epi16(maximum);
+	for (i=startBin; (i+8)<=endBin; i+=8) {
+		vector = _mm_loadu_si128((const __m128i *)&pSpectrum[i]);
+		if (pMask) {
+			vector = _mm_andnot_si128(_sse2MaskLanes(pMask, i), vector);
+		}
+		lanes = _mm_movemask_epi8(_mm_cmpeq_epi16(vector, target));
+		if (lanes) {
+			*pIndex = i + (__builtin_ctz(lanes) >> 1);
+			return(maximum);
+		}
+	}
+	for (; i<endBin; i++) {
+		if ((pSpectrum[i] == maximum) && (!pMask || !binMaskIsMarked(pMask, i))) {
+			*pIndex = i;
+			break;
+		}
+	}
+	return(maximum);
+}
+
+static int16_t _sse2MaskedArgmax(const int16_t *pSpectrum, const binMaskType *pMask, int startBin, int endBin, int *pIndex) {
+	return(_sse2Search(pSpectrum, pMask, startBin, endBin, pIndex));
+}
+
+static int16_t _sse2WindowMax(const int16_t *pSpectrum, int startBin, int endBin, int *pIndex) {
+	return(_sse2Search(pSpectrum, NULL, startBin, endBin, pIndex));
+}
+
+static void _sse2BlockMax(const int16_t *pSpectrum, int numberOfBlocks, int16_t *pMaximum, U16 *pMaximumIndex) {
+	int block;
+	U32 lanes;
+	__m128i low, high, target;
+	int16_t maximum;
+
+	for (block=0; block<numberOfBlocks; block++, pSpectrum+=SPECTRUM_BLOCK_SIZE) {
+		low		= _mm_loadu_si128((const __m128i *)&pSpectrum[0]);
+		high	= _mm_loadu_si128((const __m128i *)&pSpectrum[8]);
+		maximum	= _sse2HorizontalMax(_mm_max_epi16(_mm_max_epi16(low, high), _mm_setzero_si128()));
+
+		pMaximum[block]			= maximum;
+		pMaximumIndex[block]	= 0;
+		if (maximum > 0) {
+			target	= _mm_set1_epi16(maximum);
+			lanes	= (U32)_mm_movemask_epi8(_mm_cmpeq_epi16(low, target)) |
+					  ((U32)_mm_movemask_epi8(_mm_cmpeq_epi16(high, target)) << 16);
+			pMaximumIndex[block] = (block << SPECTRUM_BLOCK_SHIFT) + (__builtin_ctz(lanes) >> 1);
+		}
+	}
+}
+
+static const spectrumKernelType spectrumKernelsSse2 = {
+	"sse2",
+	_sse2MaskedArgmax,
+	_sse2WindowMax,
+	_sse2BlockMax,
+};
+#endif	// __SSE2__
+
+//=================================================================================================
+// AVX2 - sixteen bins per vector, same approach as SSE2
+//=================================================================================================
+#ifdef __AVX2__
+static inline __m256i _avx2MaskLanes(const binMaskType *pMask, int bin) {
+	const __m256i laneBits = _mm256_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128,
+		256, 512, 1024, 2048, 4096, 8192, 16384, (short)32768);
+	__m256i bits = _mm256_set1_epi16((short)(binMaskGetBits(pMask, bin) & 0xFFFF));
+
+	return(_mm256_cmpeq_epi16(_mm256_and_si256(bits, laneBits), laneBits));
+}
+
+static int16_t _avx2Search(const int16_t *pSpectrum, const binMaskType *pMask, int startBin, int endBin, int *pIndex) {
+	int i;
+	U32 lanes;
+	__m256i vectorMaximum, vector, target;
+	int16_t maximum, value;
+
+	vectorMaximum = _mm256_setzero_si256();
+	for (i=startBin; (i+16)<=endBin; i+=16) {
+		vector = _mm256_loadu_si256((const __m256i *)&pSpectrum[i]);
+		if (pMask) {
+			vector = _mm256_andnot_si256(_avx2MaskLanes(pMask, i), vector);
+		}
+		vectorMaximum = _mm256_max_epi16(vectorMaximum, vector);
+	}
+	maximum = _sse2HorizontalMax(_mm_max_epi16(_mm256_castsi256_si128(vectorMaximum),
+		_mm256_extracti128_si256(vectorMaximum, 1)));
+	for (; i<endBin; i++) {
+		value = pSpectrum[i];
+		if ((value > maximum) && (!pMask || !binMaskIsMarked(pMask, i))) {
+			maximum = value;
+		}
+	}
+
+	*pIndex = 0;
+	if (maximum <= 0) {
+		return(0);
+	}
+
+	target = _mm256_set1_epi16(maximum);
+	for (i=startBin; (i+16)<=endBin; i+=16) {
+		vector = _mm256_loadu_si256((const __m256i *)&pSpectrum[i]);
+		if (pMask) {
+			vector = _mm256_andnot_si256(_avx2MaskLanes(pMask, i), vector);
+		}
+		lanes = (U32)_mm256_movemask_epi8(_mm256_cmpeq_epi16(vector, target));
+		if (lanes) {
+			*pIndex = i + (__builtin_ctz(lanes) >> 1);
+			return(maximum);
+		}
+	}
+	for (; i<endBin; i++) {
+		if ((pSpectrum[i] == maximum) && (!pMask || !binMaskIsMarked(pMask, i))) {
+			*pIndex = i;
+			break;
+		}
+	}
+	return(maximum);
+}
+
+static int16_t _avx2MaskedArgmax(const int16_t *pSpectrum, const binMaskType *pMask, int startBin, int endBin, int *pIndex) {
+	return(_avx2Search(pSpectrum, pMask, startBin, endBin, pIndex));
+}
+
+static int16_t _avx2WindowMax(const int16_t *pSpectrum, int startBin, int endBin, int *pIndex) {
+	return(_avx2Search(pSpectrum, NULL, startBin, endBin, pIndex));
+}
+
+static void _avx2BlockMax(const int16_t *pSpectrum, int numberOfBlocks, int16_t *pMaximum, U16 *pMaximumIndex) {
+	int block;
+	U32 lanes;
+	__m256i vector;
+	int16_t maximum;
+
+	for (block=0; block<numberOfBlocks; block++, pSpectrum+=SPECTRUM_BLOCK_SIZE) {
+		vector	= _mm256_loadu_si256((const __m256i *)pSpectrum);
+		maximum	= _sse2HorizontalMax(_mm_max_epi16(_mm_max_epi16(_mm256_castsi256_si128(vector),
+			_mm256_extracti128_si256(vector, 1)), _mm_setzero_si128()));
+
+		pMaximum[block]			= maximum;
+		pMaximumIndex[block]	= 0;
+		if (maximum > 0) {
+			lanes = (U32)_mm256_movemask_epi8(_mm256_cmpeq_epi16(vector, _mm256_set1_epi16(maximum)));
+			pMaximumIndex[block] = (block << SPECTRUM_BLOCK_SHIFT) + (__builtin_ctz(lanes) >> 1);
+		}
+	}
+}
+
+static const spectrumKernelType spectrumKernelsAvx2 = {
+	"avx2",
+	_avx2MaskedArgmax,
+	_avx2WindowMax,
+	_avx2BlockMax,
+};
+#endif	// __AVX2__
+
+//=================================================================================================
+// Build-time selection
+//=================================================================================================
+const spectrumKernelType *spectrumKernelVersions[] = {
+	&spectrumKernelsScalar,
+#ifdef BUILD_DSP_SPECTRUM_KERNELS
+	&spectrumKernelsDsp,
+#endif
+#ifdef __SSE2__
+	&spectrumKernelsSse2,
+#endif
+#ifdef __AVX2__
+	&spectrumKernelsAvx2,
+#endif
+};
+const int numberOfSpectrumKernelVersions = sizeof(spectrumKernelVersions)/sizeof(spectrumKernelVersions[0]);
+
+#if defined(USE_SCALAR_SPECTRUM_KERNELS)
+	const spectrumKernelType spectrumKernels = spectrumKernelsScalar;
+#elif defined(__ARM_FEATURE_DSP)
+	const spectrumKernelType spectrumKernels = spectrumKernelsDsp;
+#elif defined(__AVX2__)
+	const spectrumKernelType spectrumKernels = spectrumKernelsAvx2;
+#elif defined(__SSE2__)
+	const spectrumKernelType spectrumKernels = spectrumKernelsSse2;
+#else
+	const spectrumKernelType spectrumKernels = spectrumKernelsScalar;
+#endif
+
+/*---- End Of File ----*/
@@ -0,0 +1,48 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Spectrum Search Kernels
+//
+// The two searches the tracker runs over the int16 spectrum every frame.  Each has a portable
+// scalar version plus packed versions for the Cortex-M4 DSP extension (two bins per word) and
+// SSE2/AVX2 on the host (eight or sixteen bins per vector).  All versions return exactly what the
+// scalar version returns.
+//
+// The fastest version the compiler targets is selected at build time.  Define
+// USE_SCALAR_SPECTRUM_KERNELS to force the scalar one.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef SPECTRUM_KERNELS_H
+#define SPECTRUM_KERNELS_H
+
+#define SPECTRUM_BLOCK_SHIFT		4
+#define SPECTRUM_BLOCK_SIZE			(1 << SPECTRUM_BLOCK_SHIFT)
+
+//-------------------------------------------------------------------------------------------------
+// BEGIN Definition of structure
+//-------------------------------------------------------------------------------------------------
+// maskedArgmax	Strongest bin from startBin up to endBin that is not marked in pMask.
+// windowMax	Strongest bin from startBin up to endBin.
+// blockMax		windowMax of each SPECTRUM_BLOCK_SIZE block of the first numberOfBlocks blocks,
+//				written to pMaximum[] and pMaximumIndex[].
+//
+// Only values above zero count.  Each returns the maximum and the lowest bin that holds it, or a
+// maximum of 0 with index 0 when no bin is above zero.
+//-------------------------------------------------------------------------------------------------
+typedef struct {
+	const char *name;
+	int16_t (*maskedArgmax)(const int16_t *, const binMaskType *, int, int, int *);
+	int16_t (*windowMax)(const int16_t *, int, int, int *);
+	void (*blockMax)(const int16_t *, int, int16_t *, U16 *);
+} spectrumKernelType;
+
+// The version the tracker uses
+extern const spectrumKernelType spectrumKernels;
+
+// Every version built into this binary, scalar first.  For checking one against another.
+extern const spectrumKernelType *spectrumKernelVersions[];
+extern const int numberOfSpectrumKernelVersions;
+
+#endif   /* #ifndef SPECTRUM_KERNELS_H */
+
+/*********************************** End of File ******************************************************/
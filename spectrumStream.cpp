@@ -0,0 +1,189 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Spectrum Stream
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+#if (TELEMETRY_MAXIMUM_PAYLOAD < (SPECTRUM_STREAM_HEADER_SIZE + (2 * FFT_OUTPUT_ARRAY_SIZE)))
+	#error TELEMETRY_MAXIMUM_PAYLOAD is too small for a spectrum stream message
+#endif
+
+spectrumStreamType spectrumStream;
+
+static void _sendMessage(int, int);
+static void _putRun(int);
+
+//-------------------------------------------------------------------------------------------------
+// 16 steps an octave of (value + 1): the octave in the top four bits and the next four bits of
+// the value below its leading one in the bottom four.
+//-------------------------------------------------------------------------------------------------
+U8 spectrumLogCode(uint16_t value) {
+	U32 x = (U32)value + 1;
+	int octave, code;
+
+	octave	= 31 - __builtin_clz(x);
+	code	= (octave << 4) | (((x << 4) >> octave) & 0x0F);
+	return((code > 255) ? 255 : code);
+}
+
+//-------------------------------------------------------------------------------------------------
+// The smallest value with the code.  Exact below 32.
+//-------------------------------------------------------------------------------------------------
+uint16_t spectrumLogValue(U8 code) {
+	return((((U32)(16 + (code & 0x0F)) << (code >> 4)) >> 4) - 1);
+}
+
+//-------------------------------------------------------------------------------------------------
+void spectrumStreamOpen(void) {
+	memset(&spectrumStream, 0, sizeof(spectrumStream));
+	spectrumStream.decimation	= 1;
+	spectrumStream.noiseFloor	= SPECTRUM_STREAM_NOISE_FLOOR;
+	spectrumStreamRestart();
+}
+
+//-------------------------------------------------------------------------------------------------
+// After the settings change.  Frames being held are dropped and the next message is a keyframe.
+//-------------------------------------------------------------------------------------------------
+void spectrumStreamRestart(void) {
+	spectrumStream.framesHeld		= 0;
+	spectrumStream.keyframeNeeded	= TRUE;
+	memset(spectrumStream.held, 0, sizeof(spectrumStream.held));
+}
+
+//-------------------------------------------------------------------------------------------------
+// Called for each frame taken from frameQueue while the protocol is SP_SPECTRUM_STREAM
+//-------------------------------------------------------------------------------------------------
+void spectrumStreamFrame(const spectrumFrameType *pFrame) {
+	int firstBin, numberOfBins, bin;
+	U8 code;
+
+	if (pFrame->numberOfBins != spectrumStream.analyzerBins) {
+		spectrumStream.analyzerBins = pFrame->numberOfBins;
+		spectrumStreamRestart();
+	}
+
+	firstBin		= (spectrumStream.firstBin < pFrame->numberOfBins) ? spectrumStream.firstBin : pFrame->numberOfBins;
+	numberOfBins	= pFrame->numberOfBins - firstBin;
+	if ((spectrumStream.numberOfBins > 0) && (spectrumStream.numberOfBins < numberOfBins)) {
+		numberOfBins = spectrumStream.numberOfBins;
+	}
+
+	for (bin=0; bin<numberOfBins; bin++) {
+		code = 0;
+		if (pFrame->output[firstBin + bin] > spectrumStream.noiseFloor) {
+			code = spectrumLogCode(pFrame->output[firstBin + bin]);
+		}
+		if (code > spectrumStream.held[bin]) {
+			spectrumStream.held[bin] = code;
+		}
+	}
+
+	if (++spectrumStream.framesHeld < spectrumStream.decimation) {
+		return;
+	}
+	_sendMessage(firstBin, numberOfBins);
+	spectrumStream.framesHeld = 0;
+	memset(spectrumStream.held, 0, numberOfBins);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Encode held[] against what the receiver has.  If anything was dropped since the last message
+// the receiver may be out of step, so this one is a keyframe.
+//-------------------------------------------------------------------------------------------------
+static void _sendMessage(int firstBin, int numberOfBins) {
+	int bin, run;
+	U8 delta;
+	boolean keyframe;
+
+	keyframe = spectrumStream.keyframeNeeded ||
+		(spectrumStream.telemetryDropped != serialData.tx.dropped) ||
+		(spectrumStream.messagesSinceKeyframe >= (SPECTRUM_STREAM_KEYFRAME_INTERVAL - 1));
+	if (keyframe) {
+		memset(spectrumStream.previous, 0, sizeof(spectrumStream.previous));
+	}
+
+	telemetryBegin(TELEMETRY_SPECTRUM_STREAM);
+	telemetryPutU8(keyframe ? SPECTRUM_STREAM_KEYFRAME : 0);
+	telemetryPutU16(spectrumStream.analyzerBins);
+	telemetryPutU16(firstBin);
+	telemetryPutU16(numberOfBins);
+	telemetryPutU8(spectrumStream.decimation);
+
+	run = 0;
+	for (bin=0; bin<numberOfBins; bin++) {
+		delta = spectrumStream.held[bin] - spectrumStream.previous[bin];
+		spectrumStream.previous[bin] = spectrumStream.held[bin];
+		if (delta == 0) {
+			if (++run == SPECTRUM_STREAM_MAXIMUM_RUN) {
+				_putRun(run);
+				run = 0;
+			}
+			continue;
+		}
+		_putRun(run);
+		run = 0;
+		telemetryPutU8(delta);
+		if (delta == SPECTRUM_STREAM_ESCAPE) {
+			telemetryPutU8(0);
+		}
+	}
+	_putRun(run);
+
+	if (telemetrySend()) {
+		spectrumStream.keyframeNeeded			= FALSE;
+		spectrumStream.messagesSinceKeyframe	= keyframe ? 0 : (spectrumStream.messagesSinceKeyframe + 1);
+	} else {
+		spectrumStream.keyframeNeeded			= TRUE;
+	}
+	spectrumStream.telemetryDropped = serialData.tx.dropped;
+}
+
+//-------------------------------------------------------------------------------------------------
+static void _putRun(int run) {
+	if (run >= SPECTRUM_STREAM_MINIMUM_RUN) {
+		telemetryPutU8(SPECTRUM_STREAM_ESCAPE);
+		telemetryPutU8(run);
+		return;
+	}
+	while (run-- > 0) {
+		telemetryPutU8(0);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Apply the deltas to the numberOfBins codes in pCodes, which hold the last message's codes, or
+// zeros for a keyframe.  Returns FALSE if the deltas don't cover exactly numberOfBins.
+//-------------------------------------------------------------------------------------------------
+boolean spectrumStreamDecode(const U8 *pDeltas, int length, U8 *pCodes, int numberOfBins) {
+	int i, bin;
+
+	bin = 0;
+	for (i=0; i<length; i++) {
+		if (pDeltas[i] != SPECTRUM_STREAM_ESCAPE) {
+			if (bin >= numberOfBins) {
+				return(FALSE);
+			}
+			pCodes[bin++] += pDeltas[i];
+			continue;
+		}
+		if (++i >= length) {
+			return(FALSE);
+		}
+		if (pDeltas[i] == 0) {
+			if (bin >= numberOfBins) {
+				return(FALSE);
+			}
+			pCodes[bin++] += SPECTRUM_STREAM_ESCAPE;
+		} else {
+			bin += pDeltas[i];
+			if (bin > numberOfBins) {
+				return(FALSE);
+			}
+		}
+	}
+	return(bin == numberOfBins);
+}
+
+/*---- End Of File ----*/
@@ -0,0 +1,65 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Spectrum Stream
+//
+// Sends the analyzer output, every frame, as TELEMETRY_SPECTRUM_STREAM messages small enough for
+// the serial link (SP_SPECTRUM_STREAM).  Each bin is sent as an 8-bit log code, as the change from
+// the code the receiver already holds:
+//
+//	- The code is 16 steps an octave of (magnitude + 1), about 4% a step, from spectrumLogCode().
+//	  Magnitudes at or below noiseFloor are code 0, so a quiet bin stops changing.
+//	- Each delta is one byte, the difference mod 256.  A run of unchanged bins is
+//	  SPECTRUM_STREAM_ESCAPE followed by the run length; the escape followed by 0 is a delta of
+//	  0x80 itself.
+//	- A keyframe is sent against all zeros, every SPECTRUM_STREAM_KEYFRAME_INTERVAL frames and
+//	  after any telemetry frame was dropped, so a receiver that lost one can pick up again.
+//	- Only firstBin to firstBin + numberOfBins is sent.  With decimation above 1 each message is
+//	  the maximum of each bin over that many frames.
+//
+// Payload after the telemetry header:
+//	U8 flags, U16 analyzer bins, U16 firstBin, U16 numberOfBins, U8 decimation, then the deltas
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef SPECTRUM_STREAM_H
+#define SPECTRUM_STREAM_H
+
+#define SPECTRUM_STREAM_KEYFRAME			0x01	// flags
+#define SPECTRUM_STREAM_HEADER_SIZE			8
+#define SPECTRUM_STREAM_ESCAPE				0x80
+#define SPECTRUM_STREAM_MINIMUM_RUN			3		// Shorter runs are sent as zero deltas
+#define SPECTRUM_STREAM_MAXIMUM_RUN			255
+#define SPECTRUM_STREAM_KEYFRAME_INTERVAL	64		// Messages
+#define SPECTRUM_STREAM_NOISE_FLOOR			16		// Default
+
+typedef struct {
+	// Settings, from the "stream" command
+	int firstBin;
+	int numberOfBins;					// 0 sends every bin from firstBin up
+	int decimation;						// Frames max-held into each message.  1 sends every frame.
+	U16 noiseFloor;						// Magnitudes at or below are sent as code 0
+
+	// Encoder
+	boolean keyframeNeeded;
+	int analyzerBins;					// Of the frames being held
+	int framesHeld;
+	int messagesSinceKeyframe;
+	U32 telemetryDropped;				// serialData.tx.dropped when the last message was sent
+	U8 held[FFT_OUTPUT_ARRAY_SIZE];		// Max-hold of the codes since the last message
+	U8 previous[FFT_OUTPUT_ARRAY_SIZE];	// The codes the receiver holds
+} spectrumStreamType;
+
+extern spectrumStreamType spectrumStream;
+
+extern void spectrumStreamOpen(void);
+extern void spectrumStreamRestart(void);
+extern void spectrumStreamFrame(const spectrumFrameType *);
+
+// Also used by host decoders
+extern U8 spectrumLogCode(uint16_t);
+extern uint16_t spectrumLogValue(U8);
+extern boolean spectrumStreamDecode(const U8 *, int, U8 *, int);
+
+#endif   /* #ifndef SPECTRUM_STREAM_H */
+
+/*********************************** End of File ******************************************************/
@@ -0,0 +1,323 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Telemetry
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+#if (TELEMETRY_MAXIMUM_FRAME > TX_RING_SIZE)
+	#error TX_RING_SIZE is too small for a spectrum frame
+#endif
+
+#define TX_RING_AT(count)	serialData.tx.buffer[(count) & (TX_RING_SIZE - 1)]
+
+// The message being built.  Room is always left for the CRC.
+static U8 _message[TELEMETRY_MAXIMUM_MESSAGE];
+static int _length;
+static boolean _overflow;
+static U8 _sequence;
+
+// Totals at the last poll for counts
+static struct {
+	U32 millis;
+	U32 counter;
+	U32 ffts;
+	U32 overruns;
+	U32 dropped;
+} _lastPoll;
+
+pollStateType pollState = {UNIT_ADDRESS};
+
+static void _putTracks(void);
+
+// CRC-16/CCITT-FALSE, a nibble at a time
+static const U16 _crcNibble[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+//-------------------------------------------------------------------------------------------------
+U16 telemetryCrc(const U8 *pData, int length) {
+	U16 crc = 0xFFFF;
+	int i;
+
+	for (i=0; i<length; i++) {
+		crc = (crc << 4) ^ _crcNibble[(crc >> 12) ^ (pData[i] >> 4)];
+		crc = (crc << 4) ^ _crcNibble[(crc >> 12) ^ (pData[i] & 0x0F)];
+	}
+	return(crc);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Decode one frame without its 0x00 delimiter.  Returns the decoded length, or -1 if the frame
+// isn't valid COBS.
+//-------------------------------------------------------------------------------------------------
+int cobsDecode(const U8 *pIn, int length, U8 *pOut) {
+	int in, out, i;
+	U8 code;
+
+	in	= 0;
+	out	= 0;
+	while (in < length) {
+		code = pIn[in++];
+		if (code == 0) {
+			return(-1);
+		}
+		for (i=1; i<code; i++) {
+			if ((in >= length) || (pIn[in] == 0)) {
+				return(-1);
+			}
+			pOut[out++] = pIn[in++];
+		}
+		if ((code != 0xFF) && (in < length)) {
+			pOut[out++] = 0;
+		}
+	}
+	return(out);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Building a message
+//-------------------------------------------------------------------------------------------------
+void telemetryBegin(telemetryMessageIdType type) {
+	_length		= 0;
+	_overflow	= FALSE;
+	telemetryPutU8(type);
+	telemetryPutU8(++_sequence);
+}
+
+//-------------------------------------------------------------------------------------------------
+void telemetryPutU8(U8 value) {
+	if (_length >= (TELEMETRY_MAXIMUM_MESSAGE - TELEMETRY_CRC_SIZE)) {
+		_overflow = TRUE;
+		return;
+	}
+	_message[_length++] = value;
+}
+
+//-------------------------------------------------------------------------------------------------
+void telemetryPutU16(U16 value) {
+	telemetryPutU8(value & 0xFF);
+	telemetryPutU8(value >> 8);
+}
+
+//-------------------------------------------------------------------------------------------------
+void telemetryPutU32(U32 value) {
+	telemetryPutU16(value & 0xFFFF);
+	telemetryPutU16(value >> 16);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Add the CRC and COBS encode the message straight into the tx ring.  Returns FALSE, and counts
+// the frame as dropped, if the ring doesn't have room for the whole frame.
+//-------------------------------------------------------------------------------------------------
+boolean telemetrySend(void) {
+	U16 crc, head, codeAt;
+	U8 code;
+	int i;
+
+	if (_overflow ||
+		((TX_RING_SIZE - (U16)(serialData.tx.head - serialData.tx.tail)) < (COBS_ENCODED_SIZE(_length + TELEMETRY_CRC_SIZE) + 1))) {
+		serialData.tx.dropped++;
+		return(FALSE);
+	}
+
+	crc = telemetryCrc(_message, _length);
+	_message[_length++] = crc & 0xFF;
+	_message[_length++] = crc >> 8;
+
+	// Each run of up to 254 non-zero bytes is preceded by its length plus one
+	head	= serialData.tx.head;
+	codeAt	= head++;
+	code	= 1;
+	for (i=0; i<_length; i++) {
+		if (_message[i] != 0) {
+			TX_RING_AT(head++) = _message[i];
+			code++;
+		}
+		if ((_message[i] == 0) || (code == 0xFF)) {
+			TX_RING_AT(codeAt) = code;
+			codeAt	= head++;
+			code	= 1;
+		}
+	}
+	TX_RING_AT(codeAt)	= code;
+	TX_RING_AT(head++)	= 0;
+
+	serialData.tx.head = head;
+	serialData.tx.frames++;
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Messages
+//-------------------------------------------------------------------------------------------------
+void telemetrySendCounts(void) {
+	telemetryBegin(TELEMETRY_COUNTS);
+	telemetryPutU32(millis());
+	telemetryPutU16(systemData.fftsPerSecond);
+	telemetryPutU32(systemData.statistics.counter);
+	telemetryPutU32(frameQueue.sequence);
+	telemetryPutU32(frameQueue.overruns);
+	telemetryPutU32(serialData.tx.dropped);
+	telemetrySend();
+}
+
+//-------------------------------------------------------------------------------------------------
+void telemetrySendTracks(void) {
+	telemetryBegin(TELEMETRY_TRACKS);
+	_putTracks();
+	telemetrySend();
+}
+
+//-------------------------------------------------------------------------------------------------
+static void _putTracks(void) {
+	int order, slot, countAt, count;
+
+	countAt	= _length;
+	count	= 0;
+	telemetryPutU8(0);
+	for (order=0; order<targetTracking.maximumTargets; order++) {
+		slot = systemData.trackOrder[order];
+		if (systemData.track.index[slot] == INVALID_VEHICLE_ENTRY) {
+			continue;
+		}
+		telemetryPutU16(systemData.track.id[slot]);
+		telemetryPutU16(systemData.track.index[slot]);
+		telemetryPutU16(_IQint(systemData.track.magnitude[slot]));
+		telemetryPutU8(systemData.track.confidence.magnitude[slot]);
+		telemetryPutU16(systemData.track.trackCounter[slot]);
+		count++;
+	}
+	_message[countAt] = count;
+}
+
+//-------------------------------------------------------------------------------------------------
+void telemetrySendSFR(void) {
+	int order, slot, countAt, count;
+
+	telemetryBegin(TELEMETRY_SFR);
+	countAt	= _length;
+	count	= 0;
+	telemetryPutU8(0);
+	for (order=0; order<targetTracking.maximumTargets; order++) {
+		slot = systemData.trackOrder[order];
+		if (sfrData[slot].state <= SFR_WAITING_FOR_VEHICLE) {
+			continue;
+		}
+		telemetryPutU16(sfrData[slot].trackId);
+		telemetryPutU8(sfrData[slot].state);
+		telemetryPutU16(sfrData[slot].index);
+		telemetryPutU8(sfrData[slot].confidence.index);
+		telemetryPutU8(sfrData[slot].confidence.magnitude);
+		count++;
+	}
+	_message[countAt] = count;
+	telemetrySend();
+}
+
+//-------------------------------------------------------------------------------------------------
+void telemetrySendSpectrum(void) {
+	int i;
+
+	telemetryBegin(TELEMETRY_SPECTRUM);
+	telemetryPutU16(fftData.numberOfBins);
+	for (i=0; i<fftData.numberOfBins; i++) {
+		telemetryPutU16(fftData.fftOutputArray[i]);
+	}
+	telemetrySend();
+}
+
+//-------------------------------------------------------------------------------------------------
+// The answer to a POLL_QUERY.  Only the track list walks anything, and that is MaxTargets slots.
+//-------------------------------------------------------------------------------------------------
+void telemetrySendPollReply(U8 mask) {
+	U32 now;
+
+	mask &= POLL_ALL;
+	telemetryBegin(TELEMETRY_POLL_REPLY);
+	telemetryPutU16(pollState.unitAddress);
+	telemetryPutU8(mask);
+	if (mask & POLL_COUNTS) {
+		now = millis();
+		telemetryPutU32(now);
+		telemetryPutU32(systemData.statistics.counter);
+		telemetryPutU32(now - _lastPoll.millis);
+		telemetryPutU16(systemData.statistics.counter - _lastPoll.counter);
+		telemetryPutU32(frameQueue.sequence - _lastPoll.ffts);
+		telemetryPutU32(frameQueue.overruns - _lastPoll.overruns);
+		telemetryPutU32(serialData.tx.dropped - _lastPoll.dropped);
+		_lastPoll.millis	= now;
+		_lastPoll.counter	= systemData.statistics.counter;
+		_lastPoll.ffts		= frameQueue.sequence;
+		_lastPoll.overruns	= frameQueue.overruns;
+		_lastPoll.dropped	= serialData.tx.dropped;
+	}
+	if (mask & POLL_TRACKS) {
+		_putTracks();
+	}
+	if (mask & POLL_NOISE_FLOOR) {
+		telemetryPutU16(_IQint(fftData.minimumMagnitude));
+		telemetryPutU16(fftData.newTrackThreshold);
+	}
+	if (mask & POLL_RATE) {
+		telemetryPutU16(systemData.fftsPerSecond);
+		telemetryPutU16(frameQueue.maximumDepth);
+	}
+	if (mask & POLL_HEALTH) {
+		telemetryPutU8(health.flags);
+		telemetryPutU8(health.latched);
+		telemetryPutU32(health.framesLost);
+		telemetryPutU16(health.audioBlocksMaximum);
+		telemetryPutU16(AUDIO_MEMORY_BLOCKS);
+		telemetryPutU16(health.processorMaximum);
+		telemetryPutU16(health.fftsPerSecondMinimum);
+	}
+	telemetrySend();
+}
+
+//-------------------------------------------------------------------------------------------------
+// One byte from the port.  Returns TRUE if it was taken as part of a query, which is answered
+// once it is whole, its CRC checks and it is for this unit.
+//-------------------------------------------------------------------------------------------------
+boolean telemetryPollByte(U8 value) {
+	U8 *pQuery = pollState.query;
+
+	if ((pollState.length == 0) && (value != POLL_QUERY)) {
+		return(FALSE);
+	}
+	pQuery[pollState.length++] = value;
+	if (pollState.length < POLL_QUERY_SIZE) {
+		return(TRUE);
+	}
+	pollState.length = 0;
+
+	if (telemetryCrc(pQuery, POLL_QUERY_SIZE - TELEMETRY_CRC_SIZE) != (pQuery[4] | (pQuery[5] << 8))) {
+		pollState.bad++;
+	} else if ((pQuery[1] | (pQuery[2] << 8)) != pollState.unitAddress) {
+		pollState.otherUnits++;
+	} else {
+		pollState.answered++;
+		telemetrySendPollReply(pQuery[3]);
+	}
+	return(TRUE);
+}
+
+//-------------------------------------------------------------------------------------------------
+// A query for the host to send.  Returns its length, POLL_QUERY_SIZE.
+//-------------------------------------------------------------------------------------------------
+int telemetryBuildPollQuery(U16 address, U8 mask, U8 *pQuery) {
+	U16 crc;
+
+	pQuery[0]	= POLL_QUERY;
+	pQuery[1]	= address & 0xFF;
+	pQuery[2]	= address >> 8;
+	pQuery[3]	= mask;
+	crc			= telemetryCrc(pQuery, POLL_QUERY_SIZE - TELEMETRY_CRC_SIZE);
+	pQuery[4]	= crc & 0xFF;
+	pQuery[5]	= crc >> 8;
+	return(POLL_QUERY_SIZE);
+}
+
+/*---- End Of File ----*/
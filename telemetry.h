@@ -0,0 +1,120 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Telemetry
+//
+// Binary messages for the SP_BINARY protocols.  A message is built with telemetryBegin() and the
+// telemetryPut...() calls, and telemetrySend() frames it into serialData.tx, which _drainTx()
+// empties a little at a time as the port has room.  Nothing here waits on the port: a frame
+// that doesn't fit in the ring is dropped and counted in serialData.tx.dropped.
+//
+// On the wire each frame is COBS encoded and ends with a 0x00, so a receiver can pick up at the
+// next zero after noise or a text reply.  Before encoding a frame is
+//
+//	type		U8		telemetryMessageIdType
+//	sequence	U8		One more than the last frame queued or dropped, so gaps show drops
+//	payload				Little-endian, laid out per type below
+//	crc			U16		CRC-16/CCITT-FALSE of type, sequence and payload
+//
+// Payloads:
+//	TELEMETRY_COUNTS	U32 millis, U16 fftsPerSecond, U32 vehicles counted, U32 FFTs,
+//						U32 frame queue overruns, U32 telemetry frames dropped
+//	TELEMETRY_TRACKS	U8 n, then n of: U16 id, U16 index, U16 magnitude, U8 magnitude
+//						confidence, U16 trackCounter.  Strongest first.
+//	TELEMETRY_SFR		U8 n, then n of: U16 trackId, U8 state, U16 index, U8 index confidence,
+//						U8 magnitude confidence
+//	TELEMETRY_SPECTRUM	U16 numberOfBins, then numberOfBins of U16
+//	TELEMETRY_SPECTRUM_STREAM	See spectrumStream.h
+//	TELEMETRY_POLL_REPLY	U16 unit address, U8 mask, then the sections asked for, in bit order:
+//		POLL_COUNTS			U32 millis, U32 vehicles counted, then since the last poll that asked
+//							for counts: U32 milliseconds, U16 vehicles counted, U32 FFTs,
+//							U32 frame queue overruns, U32 telemetry frames dropped
+//		POLL_TRACKS			The TELEMETRY_TRACKS payload
+//		POLL_NOISE_FLOOR	U16 minimum magnitude, U16 new track threshold
+//		POLL_RATE			U16 fftsPerSecond, U16 frames waiting at most, of FRAME_QUEUE_DEPTH
+//		POLL_HEALTH			U8 flags, U8 latched, U32 frames lost, U16 audio blocks at most,
+//							U16 AUDIO_MEMORY_BLOCKS, U16 audio CPU at most in tenths of a percent,
+//							U16 fewest fftsPerSecond.  All but flags since healthReset().
+//
+// Polling, for many units on one link: the host sends a query,
+//
+//	POLL_QUERY	U8		ENQ, never part of a text command and not a flow control character
+//	address		U16		The unit's pollState.unitAddress ("unit" command)
+//	mask		U8		The sections it wants
+//	crc			U16		CRC-16/CCITT-FALSE of the four bytes before it
+//
+// and the unit with that address sends one TELEMETRY_POLL_REPLY.  The other units, and a query
+// with a bad CRC, send nothing and leave the counts since the last poll alone.  Queries are only
+// looked for in the binary protocols, where the reply goes out framed like any other message;
+// SP_POLLED sends nothing else.  In the text protocols every byte goes to the command processor.
+// Everything in a reply is kept up to date as the frames are tracked, so a reply costs the same
+// however long since the last.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+typedef enum {
+	TELEMETRY_COUNTS = 1,
+	TELEMETRY_TRACKS,
+	TELEMETRY_SFR,
+	TELEMETRY_SPECTRUM,
+	TELEMETRY_SPECTRUM_STREAM,
+	TELEMETRY_POLL_REPLY,
+} telemetryMessageIdType;
+
+#define POLL_QUERY						0x05	// ENQ
+#define POLL_QUERY_SIZE					6
+#define POLL_COUNTS						0x01
+#define POLL_TRACKS						0x02
+#define POLL_NOISE_FLOOR				0x04
+#define POLL_RATE						0x08
+#define POLL_HEALTH						0x10
+#define POLL_ALL						(POLL_COUNTS | POLL_TRACKS | POLL_NOISE_FLOOR | POLL_RATE | POLL_HEALTH)
+
+#define TELEMETRY_HEADER_SIZE			2
+#define TELEMETRY_CRC_SIZE				2
+#define TELEMETRY_MAXIMUM_PAYLOAD		(8 + (2 * FFT_OUTPUT_ARRAY_SIZE))	// A full spectrum, either way
+#define TELEMETRY_MAXIMUM_MESSAGE		(TELEMETRY_HEADER_SIZE + TELEMETRY_MAXIMUM_PAYLOAD + TELEMETRY_CRC_SIZE)
+
+// COBS adds one byte per 254 and the frame ends with a zero
+#define COBS_ENCODED_SIZE(length)		((length) + ((length) / 254) + 1)
+#define TELEMETRY_MAXIMUM_FRAME			(COBS_ENCODED_SIZE(TELEMETRY_MAXIMUM_MESSAGE) + 1)
+
+extern void telemetryBegin(telemetryMessageIdType);
+extern void telemetryPutU8(U8);
+extern void telemetryPutU16(U16);
+extern void telemetryPutU32(U32);
+extern boolean telemetrySend(void);
+
+extern void telemetrySendCounts(void);
+extern void telemetrySendTracks(void);
+extern void telemetrySendSFR(void);
+extern void telemetrySendSpectrum(void);
+extern void telemetrySendPollReply(U8);
+
+#ifndef UNIT_ADDRESS
+	#define UNIT_ADDRESS				1		// Until the "unit" command sets another
+#endif
+
+typedef struct {
+	U16 unitAddress;
+	int length;							// Of the query coming in.  0 between queries.
+	U8 query[POLL_QUERY_SIZE];
+	U32 answered;
+	U32 otherUnits;						// Good queries for another address
+	U32 bad;							// Queries with a bad CRC
+} pollStateType;
+
+extern pollStateType pollState;
+
+extern boolean telemetryPollByte(U8);
+extern int telemetryBuildPollQuery(U16, U8, U8 *);
+
+// Also used by host decoders
+extern U16 telemetryCrc(const U8 *, int);
+extern int cobsDecode(const U8 *, int, U8 *);
+
+#endif   /* #ifndef TELEMETRY_H */
+
+/*********************************** End of File ******************************************************/
@@ -0,0 +1,417 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Track to Peak Association
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+#define ASSOCIATION_PEAKS_PER_GATE		(MAX_TRACK_GATE+1)	// Local maxima are at least two bins apart
+#define ASSOCIATION_MAX_PEAKS			(MAX_NUMBER_OF_TARGETS_TRACKED*ASSOCIATION_PEAKS_PER_GATE)
+#define ASSOCIATION_MAX_COLUMNS			(ASSOCIATION_OPTIMAL_LIMIT*(ASSOCIATION_PEAKS_PER_GATE+1))
+#define ASSOCIATION_INFINITE_COST		0x3FFFFFFF
+#define ASSOCIATION_REPAIR_PASSES		4
+#define NO_PEAK							-1
+
+// The tracks in one cluster and the peaks that fall inside their gates.  A track's candidates are
+// peak[firstPeak] up to, but not including, peak[lastPeak].
+typedef struct {
+	int numberOfTracks;
+	int numberOfPeaks;
+	int track[MAX_NUMBER_OF_TARGETS_TRACKED];				// The caller's slot
+	int predictedIndex[MAX_NUMBER_OF_TARGETS_TRACKED];
+	int firstPeak[MAX_NUMBER_OF_TARGETS_TRACKED];
+	int lastPeak[MAX_NUMBER_OF_TARGETS_TRACKED];
+	int32_t missCost[MAX_NUMBER_OF_TARGETS_TRACKED];
+	int assignedPeak[MAX_NUMBER_OF_TARGETS_TRACKED];		// NO_PEAK when the track misses
+	int peakIndex[ASSOCIATION_MAX_PEAKS];
+	int peakOwner[ASSOCIATION_MAX_PEAKS];					// Cluster track, or NO_PEAK when free
+} associationClusterType;
+
+typedef struct {
+	int32_t cost;
+	int track;
+	int peak;
+} associationEdgeType;
+
+static const int16_t *_pSpectrum;
+static int _numberOfBins;
+
+//-------------------------------------------------------------------------------------------------
+// Gates are clamped to the spectrum.  The end is one past the last bin.
+//-------------------------------------------------------------------------------------------------
+static int _gateStart(const associationGateType *pGate) {
+	int start = pGate->predictedIndex - pGate->gate;
+
+	return((start < SAMPLE_START_LOCATION) ? SAMPLE_START_LOCATION : start);
+}
+
+//-------------------------------------------------------------------------------------------------
+static int _gateEnd(const associationGateType *pGate) {
+	int end = pGate->predictedIndex + pGate->gate + 1;
+
+	return((end > _numberOfBins) ? _numberOfBins : end);
+}
+
+//-------------------------------------------------------------------------------------------------
+// A peak is strictly above the bin to its left and not below the bin to its right, so a flat top
+// is reported once, at its lowest bin.
+//-------------------------------------------------------------------------------------------------
+static boolean _isPeak(int bin, int16_t threshold) {
+	int16_t value = _pSpectrum[bin];
+
+	return((value >= threshold) &&
+		((bin == 0) || (value > _pSpectrum[bin-1])) &&
+		((bin == (_numberOfBins-1)) || (value >= _pSpectrum[bin+1])));
+}
+
+//-------------------------------------------------------------------------------------------------
+// Distance from the prediction dominates.  Magnitude only breaks ties between equal distances.
+//-------------------------------------------------------------------------------------------------
+static int32_t _cost(const associationClusterType *pCluster, int track, int peak) {
+	int32_t distance = pCluster->peakIndex[peak] - pCluster->predictedIndex[track];
+
+	return((distance * distance * ASSOCIATION_DISTANCE_COST) - (_pSpectrum[pCluster->peakIndex[peak]] >> ASSOCIATION_MAGNITUDE_SHIFT));
+}
+
+//-------------------------------------------------------------------------------------------------
+// Column j of the matrix is peak j, or the miss column of track j-numberOfPeaks.
+//-------------------------------------------------------------------------------------------------
+static int32_t _matrixCost(const associationClusterType *pCluster, int track, int column) {
+	if (column >= pCluster->numberOfPeaks) {
+		return(((column - pCluster->numberOfPeaks) == track) ? pCluster->missCost[track] : ASSOCIATION_INFINITE_COST);
+	}
+	if ((column >= pCluster->firstPeak[track]) && (column < pCluster->lastPeak[track])) {
+		return(_cost(pCluster, track, column));
+	}
+	return(ASSOCIATION_INFINITE_COST);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Hungarian algorithm (shortest augmenting path with potentials), rows are tracks.  Every track has
+// its own miss column so there is always a finite assignment.  Indexes are one based with row and
+// column 0 as the start of each augmenting path.
+//-------------------------------------------------------------------------------------------------
+static void _solveOptimal(associationClusterType *pCluster) {
+	int32_t
+		u[ASSOCIATION_OPTIMAL_LIMIT+1],
+		v[ASSOCIATION_MAX_COLUMNS+1],
+		minimum[ASSOCIATION_MAX_COLUMNS+1],
+		delta,
+		cost;
+	int
+		rowOfColumn[ASSOCIATION_MAX_COLUMNS+1],
+		previousColumn[ASSOCIATION_MAX_COLUMNS+1],
+		numberOfColumns,
+		row,
+		row0,
+		column,
+		column0,
+		column1;
+	boolean
+		used[ASSOCIATION_MAX_COLUMNS+1];
+
+	numberOfColumns = pCluster->numberOfPeaks + pCluster->numberOfTracks;
+	for (column=0; column<=numberOfColumns; column++) {
+		v[column]			= 0;
+		rowOfColumn[column]	= 0;
+	}
+	for (row=0; row<=pCluster->numberOfTracks; row++) {
+		u[row]				= 0;
+	}
+
+	for (row=1; row<=pCluster->numberOfTracks; row++) {
+		rowOfColumn[0]	= row;
+		column0			= 0;
+		for (column=0; column<=numberOfColumns; column++) {
+			minimum[column]	= ASSOCIATION_INFINITE_COST;
+			used[column]	= FALSE;
+		}
+
+		// Grow the tree of tight columns until it reaches a free one
+		do {
+			used[column0]	= TRUE;
+			row0			= rowOfColumn[column0];
+			delta			= ASSOCIATION_INFINITE_COST;
+			column1			= 0;
+			for (column=1; column<=numberOfColumns; column++) {
+				if (!used[column]) {
+					cost = _matrixCost(pCluster, row0-1, column-1) - u[row0] - v[column];
+					if (cost < minimum[column]) {
+						minimum[column]			= cost;
+						previousColumn[column]	= column0;
+					}
+					if (minimum[column] < delta) {
+						delta	= minimum[column];
+						column1	= column;
+					}
+				}
+			}
+			for (column=0; column<=numberOfColumns; column++) {
+				if (used[column]) {
+					u[rowOfColumn[column]]	+= delta;
+					v[column]				-= delta;
+				} else {
+					minimum[column]			-= delta;
+				}
+			}
+			column0 = column1;
+		} while (rowOfColumn[column0] != 0);
+
+		// Flip the path
+		do {
+			column1					= previousColumn[column0];
+			rowOfColumn[column0]	= rowOfColumn[column1];
+			column0					= column1;
+		} while (column0 != 0);
+	}
+
+	for (column=1; column<=pCluster->numberOfPeaks; column++) {
+		if (rowOfColumn[column] != 0) {
+			pCluster->assignedPeak[rowOfColumn[column]-1]	= column-1;
+			pCluster->peakOwner[column-1]					= rowOfColumn[column]-1;
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// A track alone in its cluster takes its cheapest peak.  Any peak in the gate beats a miss.
+//-------------------------------------------------------------------------------------------------
+static void _solveSingle(associationClusterType *pCluster) {
+	int peak;
+
+	for (peak=pCluster->firstPeak[0]; peak < pCluster->lastPeak[0]; peak++) {
+		if ((pCluster->assignedPeak[0] == NO_PEAK) || (_cost(pCluster, 0, peak) < _cost(pCluster, 0, pCluster->assignedPeak[0]))) {
+			pCluster->assignedPeak[0] = peak;
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Cheapest first.  Equal costs go to the lower track then the lower peak so results repeat.
+//-------------------------------------------------------------------------------------------------
+static int _compareEdges(const void *pA, const void *pB) {
+	const associationEdgeType *pEdgeA = (const associationEdgeType *)pA;
+	const associationEdgeType *pEdgeB = (const associationEdgeType *)pB;
+
+	if (pEdgeA->cost != pEdgeB->cost) {
+		return((pEdgeA->cost < pEdgeB->cost) ? -1 : 1);
+	}
+	if (pEdgeA->track != pEdgeB->track) {
+		return(pEdgeA->track - pEdgeB->track);
+	}
+	return(pEdgeA->peak - pEdgeB->peak);
+}
+
+//-------------------------------------------------------------------------------------------------
+// What a track costs with the given peak, or with a miss
+//-------------------------------------------------------------------------------------------------
+static int32_t _assignmentCost(const associationClusterType *pCluster, int track, int peak) {
+	return((peak == NO_PEAK) ? pCluster->missCost[track] : _cost(pCluster, track, peak));
+}
+
+//-------------------------------------------------------------------------------------------------
+static void _assign(associationClusterType *pCluster, int track, int peak) {
+	if (pCluster->assignedPeak[track] != NO_PEAK) {
+		pCluster->peakOwner[pCluster->assignedPeak[track]] = NO_PEAK;
+	}
+	pCluster->assignedPeak[track] = peak;
+	if (peak != NO_PEAK) {
+		pCluster->peakOwner[peak] = track;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Move a track to another peak in its gate when that lowers the total.  If the peak is taken, its
+// owner moves to the cheapest of a free peak, the track's old peak or a miss.
+//-------------------------------------------------------------------------------------------------
+static boolean _repairTrack(associationClusterType *pCluster, int track) {
+	int
+		present,
+		peak,
+		owner,
+		alternative,
+		bestAlternative;
+	int32_t
+		presentCost,
+		alternativeCost,
+		bestAlternativeCost;
+
+	present		= pCluster->assignedPeak[track];
+	presentCost	= _assignmentCost(pCluster, track, present);
+	for (peak=pCluster->firstPeak[track]; peak < pCluster->lastPeak[track]; peak++) {
+		if (peak == present) {
+			continue;
+		}
+		owner = pCluster->peakOwner[peak];
+		if (owner == NO_PEAK) {
+			if (_cost(pCluster, track, peak) < presentCost) {
+				_assign(pCluster, track, peak);
+				return(TRUE);
+			}
+			continue;
+		}
+
+		bestAlternative		= NO_PEAK;
+		bestAlternativeCost	= pCluster->missCost[owner];
+		for (alternative=pCluster->firstPeak[owner]; alternative < pCluster->lastPeak[owner]; alternative++) {
+			if ((alternative != peak) && ((pCluster->peakOwner[alternative] == NO_PEAK) || (alternative == present))) {
+				alternativeCost = _cost(pCluster, owner, alternative);
+				if (alternativeCost < bestAlternativeCost) {
+					bestAlternative		= alternative;
+					bestAlternativeCost	= alternativeCost;
+				}
+			}
+		}
+		if ((_cost(pCluster, track, peak) + bestAlternativeCost) < (presentCost + _cost(pCluster, owner, peak))) {
+			_assign(pCluster, owner, NO_PEAK);
+			_assign(pCluster, track, peak);
+			_assign(pCluster, owner, bestAlternative);
+			return(TRUE);
+		}
+	}
+	return(FALSE);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Greedy assignment, cheapest pair first, then repair passes until nothing improves or the pass
+// limit is reached.  Every repair lowers the total so the passes can't cycle.
+//-------------------------------------------------------------------------------------------------
+static void _solveGreedy(associationClusterType *pCluster) {
+	associationEdgeType
+		edge[ASSOCIATION_MAX_PEAKS];
+	int
+		numberOfEdges,
+		track,
+		peak,
+		pass,
+		i;
+	boolean
+		repaired;
+
+	numberOfEdges = 0;
+	for (track=0; track<pCluster->numberOfTracks; track++) {
+		for (peak=pCluster->firstPeak[track]; (peak < pCluster->lastPeak[track]) && (numberOfEdges < ASSOCIATION_MAX_PEAKS); peak++) {
+			edge[numberOfEdges].cost	= _cost(pCluster, track, peak);
+			edge[numberOfEdges].track	= track;
+			edge[numberOfEdges].peak	= peak;
+			numberOfEdges++;
+		}
+	}
+	qsort(edge, numberOfEdges, sizeof(associationEdgeType), _compareEdges);
+
+	for (i=0; i<numberOfEdges; i++) {
+		if ((pCluster->assignedPeak[edge[i].track] == NO_PEAK) && (pCluster->peakOwner[edge[i].peak] == NO_PEAK)) {
+			_assign(pCluster, edge[i].track, edge[i].peak);
+		}
+	}
+
+	repaired = TRUE;
+	for (pass=0; (pass < ASSOCIATION_REPAIR_PASSES) && repaired; pass++) {
+		repaired = FALSE;
+		for (track=0; track<pCluster->numberOfTracks; track++) {
+			while (_repairTrack(pCluster, track)) {
+				repaired = TRUE;
+			}
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// pTrack lists the cluster's slots in order of their gate start.  end is one past the highest bin
+// in any of their gates.
+//-------------------------------------------------------------------------------------------------
+static void _solveCluster(const associationGateType *pGates, const int *pTrack, int numberOfTracks, int end, int16_t threshold, int *pAssignedIndex) {
+	associationClusterType
+		cluster;
+	int
+		track,
+		peak,
+		bin,
+		gateEnd;
+
+	// Every peak under any of the gates, lowest bin first
+	cluster.numberOfTracks	= numberOfTracks;
+	cluster.numberOfPeaks	= 0;
+	for (bin=_gateStart(&pGates[pTrack[0]]); (bin < end) && (cluster.numberOfPeaks < ASSOCIATION_MAX_PEAKS); bin++) {
+		if (_isPeak(bin, threshold)) {
+			cluster.peakIndex[cluster.numberOfPeaks]	= bin;
+			cluster.peakOwner[cluster.numberOfPeaks]	= NO_PEAK;
+			cluster.numberOfPeaks++;
+		}
+	}
+
+	for (track=0; track<numberOfTracks; track++) {
+		cluster.track[track]			= pTrack[track];
+		cluster.predictedIndex[track]	= pGates[pTrack[track]].predictedIndex;
+		cluster.missCost[track]			= (pGates[pTrack[track]].gate + 1) * (pGates[pTrack[track]].gate + 1) * ASSOCIATION_DISTANCE_COST;
+		cluster.assignedPeak[track]		= NO_PEAK;
+
+		bin		= _gateStart(&pGates[pTrack[track]]);
+		gateEnd	= _gateEnd(&pGates[pTrack[track]]);
+		for (peak=0; (peak < cluster.numberOfPeaks) && (cluster.peakIndex[peak] < bin); peak++) {
+		}
+		cluster.firstPeak[track] = peak;
+		for (; (peak < cluster.numberOfPeaks) && (cluster.peakIndex[peak] < gateEnd); peak++) {
+		}
+		cluster.lastPeak[track] = peak;
+	}
+
+	if (numberOfTracks == 1) {
+		_solveSingle(&cluster);
+	} else if ((numberOfTracks <= ASSOCIATION_OPTIMAL_LIMIT) && ((cluster.numberOfPeaks + numberOfTracks) <= ASSOCIATION_MAX_COLUMNS)) {
+		_solveOptimal(&cluster);
+	} else {
+		_solveGreedy(&cluster);
+	}
+
+	for (track=0; track<numberOfTracks; track++) {
+		if (cluster.assignedPeak[track] != NO_PEAK) {
+			pAssignedIndex[cluster.track[track]] = cluster.peakIndex[cluster.assignedPeak[track]];
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// pSpectrum has numberOfBins bins.  pGates has one entry per tracking slot.  pAssignedIndex gets the bin of the peak each slot was
+// given, or ASSOCIATION_NOT_ASSIGNED.  Only peaks at or above threshold are considered.
+//-------------------------------------------------------------------------------------------------
+void trackAssociationSolve(const int16_t *pSpectrum, int numberOfBins, const associationGateType *pGates, int numberOfTracks, int16_t threshold, int *pAssignedIndex) {
+	int
+		order[MAX_NUMBER_OF_TARGETS_TRACKED],
+		numberOfActive,
+		track,
+		i,
+		clusterStart,
+		clusterEnd,
+		end;
+
+	_pSpectrum		= pSpectrum;
+	_numberOfBins	= numberOfBins;
+
+	// Active slots in order of the lowest bin in their gate
+	numberOfActive = 0;
+	for (track=0; track<numberOfTracks; track++) {
+		pAssignedIndex[track] = ASSOCIATION_NOT_ASSIGNED;
+		if (pGates[track].predictedIndex != ASSOCIATION_NO_TRACK) {
+			for (i=numberOfActive; (i > 0) && (_gateStart(&pGates[order[i-1]]) > _gateStart(&pGates[track])); i--) {
+				order[i] = order[i-1];
+			}
+			order[i] = track;
+			numberOfActive++;
+		}
+	}
+
+	// Overlapping gates form a cluster
+	for (clusterStart=0; clusterStart<numberOfActive; clusterStart=clusterEnd) {
+		end = _gateEnd(&pGates[order[clusterStart]]);
+		for (clusterEnd=clusterStart+1; (clusterEnd < numberOfActive) && (_gateStart(&pGates[order[clusterEnd]]) < end); clusterEnd++) {
+			if (_gateEnd(&pGates[order[clusterEnd]]) > end) {
+				end = _gateEnd(&pGates[order[clusterEnd]]);
+			}
+		}
+		_solveCluster(pGates, &order[clusterStart], clusterEnd-clusterStart, end, threshold, pAssignedIndex);
+	}
+}
+
+/*---- End Of File ----*/
@@ -0,0 +1,30 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Track to Peak Association
+//
+// Global nearest neighbour association of existing tracks with the peaks in their search gates.
+// Tracks whose gates overlap form a cluster and each cluster is solved on its own.  A cost is
+// only kept for a peak inside a track's gate, so the cost matrix is sparse.  Small clusters are
+// solved exactly with the Hungarian algorithm.  Larger ones are assigned greedily, cheapest pair
+// first, and then repaired by moving a track to another free peak where that lets a missed track
+// in.  Every track may also miss, at a cost above any peak in its gate.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef TRACK_ASSOCIATION_H
+#define TRACK_ASSOCIATION_H
+
+#define ASSOCIATION_NO_TRACK			-1		// predictedIndex of an empty slot
+#define ASSOCIATION_NOT_ASSIGNED		-1		// Result for a track that found no peak
+#define ASSOCIATION_OPTIMAL_LIMIT		8		// Largest cluster solved with the Hungarian algorithm
+#define ASSOCIATION_DISTANCE_COST		1024	// Cost of one bin squared from the predicted bin
+#define ASSOCIATION_MAGNITUDE_SHIFT		5		// Stronger peaks cost less.  Never more than one bin.
+
+typedef struct {
+	int predictedIndex;				// Centre of the gate, or ASSOCIATION_NO_TRACK
+	int gate;						// Half width of the gate in bins
+} associationGateType;
+
+extern void trackAssociationSolve(const int16_t *, int, const associationGateType *, int, int16_t, int *);
+
+#endif   /* #ifndef TRACK_ASSOCIATION_H */
@@ -0,0 +1,55 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Tracker Pipeline
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+// A stage's id is also its profile point
+static_assert((int)PIPELINE_INGEST == (int)PROFILE_INGEST, "profilePointType is out of step with the pipeline stages");
+static_assert((int)PIPELINE_DETECT == (int)PROFILE_FIND_NEW_TRACKS, "profilePointType is out of step with the pipeline stages");
+static_assert((int)PIPELINE_ASSOCIATE == (int)PROFILE_ASSOCIATE, "profilePointType is out of step with the pipeline stages");
+static_assert((int)PIPELINE_UPDATE == (int)PROFILE_UPDATE, "profilePointType is out of step with the pipeline stages");
+static_assert((int)PIPELINE_CLASSIFY == (int)PROFILE_CLASSIFY, "profilePointType is out of step with the pipeline stages");
+static_assert((int)PIPELINE_PUBLISH == (int)PROFILE_UPDATE_MINIMUM_MAGNITUDE, "profilePointType is out of step with the pipeline stages");
+static_assert((int)NUMBER_OF_PIPELINE_STAGES == (int)PROFILE_SORT, "profilePointType is out of step with the pipeline stages");
+
+trackerPipelineType trackerPipeline;
+
+//-------------------------------------------------------------------------------------------------
+// Run one frame through pStage[], which has NUMBER_OF_PIPELINE_STAGES entries in stage order.
+//-------------------------------------------------------------------------------------------------
+void trackerPipelineRun(const pipelineStageType *pStage) {
+	pipelineStageTimingType *pTiming;
+	int stage;
+	U32 start;
+
+	trackerPipeline.frames++;
+	trackerPipeline.dirty = PIPELINE_FRAME;
+
+	for (stage=0; stage<NUMBER_OF_PIPELINE_STAGES; stage++) {
+		pTiming = &trackerPipeline.timing[pStage[stage].id];
+
+		if ((pStage[stage].inputs != 0) && ((trackerPipeline.dirty & pStage[stage].inputs) == 0)) {
+			pTiming->skips++;
+			pTiming->lastTime = 0;
+			continue;
+		}
+
+		start					= profileCycles();
+		trackerPipeline.dirty	|= pStage[stage].run();
+		pTiming->lastTime		= profileCycles() - start;
+		PROFILE_ADD((profilePointType)pStage[stage].id, start, pTiming->lastTime);
+		pTiming->totalTime		+= pTiming->lastTime;
+		pTiming->runs++;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+void trackerPipelineResetTiming(void) {
+	trackerPipeline.frames = 0;
+	memset(trackerPipeline.timing, 0, sizeof(trackerPipeline.timing));
+}
+
+/*---- End Of File ----*/
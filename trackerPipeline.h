@@ -0,0 +1,71 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Tracker Pipeline
+//
+// The per-frame tracker work as a fixed list of stages, run in order once per FFT:
+//
+//	ingest		pick up the analyzer's output and build the block-max index
+//	detect		find peaks that aren't near an existing track and start tracks on them
+//	associate	give each existing track the best peak in its search gate
+//	update		move, coast or drop each track and mark its gate in binIsUnderInvestigation
+//	classify	order the tracks by magnitude and run the side-firing algorithm
+//	publish		adjust the minimum magnitude for the next frame
+//
+// Each stage names the dirty flags it reads.  A stage runs when one of them was set earlier in
+// the same frame, or every frame if it reads none, and returns the flags it set.  So classify only
+// sorts when a track actually changed, and a frame with no tracks stops after detect.
+//
+// binIsUnderInvestigation is written by update and read by the next frame's detect, which adds
+// the peaks it takes and then clears it.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef TRACKER_PIPELINE_H
+#define TRACKER_PIPELINE_H
+
+typedef enum {
+	PIPELINE_INGEST,
+	PIPELINE_DETECT,
+	PIPELINE_ASSOCIATE,
+	PIPELINE_UPDATE,
+	PIPELINE_CLASSIFY,
+	PIPELINE_PUBLISH,
+	NUMBER_OF_PIPELINE_STAGES
+} pipelineStageIdType;
+
+// Dirty flags
+#define PIPELINE_FRAME			0x01	// A new FFT has completed
+#define PIPELINE_SPECTRUM		0x02	// fftData.fftOutputArray and blockIndex hold the new frame
+#define PIPELINE_ASSIGNMENTS	0x04	// At least one track was given a gate to search
+#define PIPELINE_TRACKS			0x08	// A track was started, moved, coasted or dropped
+
+typedef struct {
+	pipelineStageIdType id;			// Used to keep us honest
+	const char *name;
+	U16 inputs;						// Runs if any of these are dirty.  0 runs every frame.
+	U16 (*run)(void);				// Returns the flags it set
+} pipelineStageType;
+
+// Times are in profileCycles() ticks, profileTicksPerMillisecond of them a millisecond.  The same
+// reads give the profiler its stage times.
+typedef struct {
+	U32 runs;
+	U32 skips;
+	uint64_t totalTime;
+	U32 lastTime;
+} pipelineStageTimingType;
+
+typedef struct {
+	U32 frames;
+	U16 dirty;						// Flags set so far this frame
+	pipelineStageTimingType timing[NUMBER_OF_PIPELINE_STAGES];
+} trackerPipelineType;
+
+extern trackerPipelineType trackerPipeline;
+
+extern void trackerPipelineRun(const pipelineStageType *);
+extern void trackerPipelineResetTiming(void);
+
+#endif   /* #ifndef TRACKER_PIPELINE_H */
+
+/*********************************** End of File ******************************************************/
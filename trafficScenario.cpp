@@ -0,0 +1,136 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Traffic Scenario
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#include "environ.h"
+
+#define METRES_PER_SECOND_TO_MPH	2.23694
+#define LN2							0.693147
+
+static U32 _random(trafficScenarioType *);
+static float _uniform(trafficScenarioType *, float, float);
+static void _newVehicle(trafficScenarioType *, scenarioVehicleType *, float);
+static void _addLine(float *, int, float, float);
+
+//-------------------------------------------------------------------------------------------------
+// xorshift32, so a seed draws the same numbers on every platform.  The frames made from them can
+// still differ from one toolchain to another (see trafficScenario.h).
+//-------------------------------------------------------------------------------------------------
+static U32 _random(trafficScenarioType *pScenario) {
+	U32 x = pScenario->random;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	pScenario->random = x;
+	return(x);
+}
+
+static float _uniform(trafficScenarioType *pScenario, float minimum, float maximum) {
+	return(minimum + ((maximum - minimum) * (_random(pScenario) >> 8) * (1.0f / 16777216.0f)));
+}
+
+//-------------------------------------------------------------------------------------------------
+static void _newVehicle(trafficScenarioType *pScenario, scenarioVehicleType *pVehicle, float x) {
+	const scenarioSettingsType *pSettings = &pScenario->settings;
+
+	pVehicle->x				= x;
+	pVehicle->speed			= _uniform(pScenario, pSettings->minimumSpeed, pSettings->maximumSpeed) / METRES_PER_SECOND_TO_MPH;
+	pVehicle->rcs			= _uniform(pScenario, pSettings->minimumRcs, pSettings->maximumRcs);
+	pVehicle->laneOffset	= pSettings->laneOffset[_random(pScenario) % pSettings->numberOfLanes];
+}
+
+//-------------------------------------------------------------------------------------------------
+// Adds a tone at bin (fractional) spread over SCENARIO_SPREAD_BINS either side
+//-------------------------------------------------------------------------------------------------
+static void _addLine(float *pSpectrum, int numberOfBins, float bin, float magnitude) {
+	int centre, i;
+	float offset;
+
+	centre = (int)(bin + 0.5f);
+	for (i=centre-SCENARIO_SPREAD_BINS; i<=centre+SCENARIO_SPREAD_BINS; i++) {
+		if ((i >= 0) && (i < numberOfBins)) {
+			offset = i - bin;
+			pSpectrum[i] += magnitude * expf(-0.5f * offset * offset);
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Frames come at the analyzer's rate, with its bin width
+//-------------------------------------------------------------------------------------------------
+void scenarioOpen(trafficScenarioType *pScenario, const scenarioSettingsType *pSettings, const fftAnalyzerType *pAnalyzer) {
+	int i;
+
+	memset(pScenario, 0, sizeof(trafficScenarioType));
+	pScenario->settings = *pSettings;
+	if (pScenario->settings.numberOfVehicles > SCENARIO_MAXIMUM_VEHICLES) {
+		pScenario->settings.numberOfVehicles = SCENARIO_MAXIMUM_VEHICLES;
+	}
+	if ((pScenario->settings.numberOfLanes < 1) || (pScenario->settings.numberOfLanes > SCENARIO_MAXIMUM_LANES)) {
+		pScenario->settings.numberOfLanes = 1;
+	}
+	if (pScenario->settings.numberOfClutterLines > SCENARIO_MAXIMUM_CLUTTER_LINES) {
+		pScenario->settings.numberOfClutterLines = SCENARIO_MAXIMUM_CLUTTER_LINES;
+	}
+	pScenario->random		= pSettings->seed ? pSettings->seed : 1;
+	pScenario->framePeriod	= 1.0f / pAnalyzer->fftsPerSecond;
+	pScenario->hzPerBin		= SCENARIO_SAMPLE_RATE / pAnalyzer->fftSize;
+	pScenario->beamAxis		= -pSettings->mountAngle * (PI / 180.0);
+
+	for (i=0; i<pScenario->settings.numberOfVehicles; i++) {
+		_newVehicle(pScenario, &pScenario->vehicle[i],
+			_uniform(pScenario, -pSettings->roadLength / 2, pSettings->roadLength / 2));
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// The next frame, numberOfBins magnitudes into pOutput
+//-------------------------------------------------------------------------------------------------
+void scenarioFrame(trafficScenarioType *pScenario, uint16_t *pOutput, int numberOfBins) {
+	const scenarioSettingsType *pSettings = &pScenario->settings;
+	scenarioVehicleType *pVehicle;
+	float spectrum[FFT_OUTPUT_ARRAY_SIZE];
+	float range, radialSpeed, angle, pattern, beamwidth, x;
+	int i, bin;
+
+	if (numberOfBins > FFT_OUTPUT_ARRAY_SIZE) {
+		numberOfBins = FFT_OUTPUT_ARRAY_SIZE;
+	}
+	for (bin=0; bin<numberOfBins; bin++) {
+		spectrum[bin] = pSettings->noiseFloor * _uniform(pScenario, 0.5f, 1.5f);
+	}
+	for (i=0; i<pSettings->numberOfClutterLines; i++) {
+		_addLine(spectrum, numberOfBins, pSettings->clutterHz[i] / pScenario->hzPerBin, pSettings->clutterAmplitude[i]);
+	}
+
+	beamwidth = pSettings->beamwidth * (PI / 180.0);
+	for (i=0, pVehicle=pScenario->vehicle; i<pSettings->numberOfVehicles; i++, pVehicle++) {
+		range		= sqrtf((pVehicle->x * pVehicle->x) + (pVehicle->laneOffset * pVehicle->laneOffset));
+		radialSpeed	= pVehicle->speed * fabsf(pVehicle->x) / range;
+		angle		= atan2f(pVehicle->x, pVehicle->laneOffset) - pScenario->beamAxis;
+		pattern		= expf(-4.0f * LN2 * (angle * angle) / (beamwidth * beamwidth));
+		_addLine(spectrum, numberOfBins,
+			pSettings->hzPerMph * radialSpeed * METRES_PER_SECOND_TO_MPH / pScenario->hzPerBin,
+			pSettings->amplitude * sqrtf(pVehicle->rcs) * pattern / (range * range));
+
+		// On to the next frame
+		x = pVehicle->x + (pVehicle->speed * pScenario->framePeriod);
+		if ((pVehicle->x < 0) && (x >= 0)) {
+			pScenario->vehiclesPassed++;
+		}
+		pVehicle->x = x;
+		if (x > (pSettings->roadLength / 2)) {
+			_newVehicle(pScenario, pVehicle, x - pSettings->roadLength);
+		}
+	}
+
+	for (bin=0; bin<numberOfBins; bin++) {
+		pOutput[bin] = (spectrum[bin] >= 65535.0f) ? 65535 : (uint16_t)spectrum[bin];
+	}
+	pScenario->frames++;
+}
+
+/*---- End Of File ----*/
@@ -0,0 +1,110 @@
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+// Traffic Scenario
+//
+// Synthesizes whole analyzer frames of side-firing radar traffic, for load and scaling tests of
+// the tracker without audio.  A frame costs microseconds, so hours of traffic run in seconds on
+// the host.
+//
+// The same settings and seed give the same frames from the same build.  The random draws come
+// from xorshift32, so every platform draws the same numbers for the vehicles' speeds, cross
+// sections and lanes.  The frames don't have to match, though: the magnitudes go through
+// expf(), sqrtf() and atan2f(), which aren't correctly rounded in every libm, and a compiler may
+// fuse a multiply and add, so another toolchain can put a bin a count either side.  Across
+// platforms a seed gives the same traffic, not the same frames, and a tracker right on a
+// threshold can count it differently.
+//
+// The radar is at the roadside, its beam turned mountAngle degrees from square to the road towards
+// the approaching traffic.  The road runs from -roadLength/2 to +roadLength/2 metres past the
+// radar.  numberOfVehicles vehicles are on it at all times: they start spread along it, and each
+// one that leaves the far end comes back in at the near end as a new vehicle, with a new speed,
+// radar cross section and lane from the settings' ranges.
+//
+// Each frame, for each vehicle at x metres along a lane laneOffset metres out:
+//	- Range R = sqrt(x^2 + laneOffset^2), and the Doppler is hzPerMph times the speed towards or
+//	  away from the radar, speed * |x| / R.  It lands between bins, spread over a few.
+//	- Magnitude = amplitude * sqrt(rcs) / R^2, times the two-way beam pattern: a Gaussian whose
+//	  one-way -3 dB width is beamwidth degrees.
+// Under the vehicles is noise, uniform from half to one and a half noiseFloor, and the clutter
+// lines: fixed tones like mains hum or a fan, at clutterHz with clutterAmplitude.
+//
+// vehiclesPassed is the ground truth: vehicles that have gone by in front of the radar.
+//-------------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------------
+
+#ifndef TRAFFIC_SCENARIO_H
+#define TRAFFIC_SCENARIO_H
+
+#define SCENARIO_MAXIMUM_VEHICLES		512
+#define SCENARIO_MAXIMUM_LANES			4
+#define SCENARIO_MAXIMUM_CLUTTER_LINES	4
+#define SCENARIO_SPREAD_BINS			3		// Bins either side of a vehicle's Doppler
+#define SCENARIO_SAMPLE_RATE			44100.0
+
+typedef struct {
+	U32 seed;
+
+	// Radar
+	float mountAngle;							// Degrees from square to the road
+	float beamwidth;							// Degrees, one-way -3 dB
+	float hzPerMph;								// Doppler.  72.083 for K band.
+
+	// Traffic
+	int numberOfVehicles;						// On the road at all times
+	float roadLength;							// Metres
+	float minimumSpeed, maximumSpeed;			// mph
+	float minimumRcs, maximumRcs;				// Square metres
+	int numberOfLanes;
+	float laneOffset[SCENARIO_MAXIMUM_LANES];	// Metres from the radar
+
+	// Spectrum
+	float amplitude;							// Magnitude of 1 m^2 at 1 m on the beam axis
+	float noiseFloor;
+	int numberOfClutterLines;
+	float clutterHz[SCENARIO_MAXIMUM_CLUTTER_LINES];
+	float clutterAmplitude[SCENARIO_MAXIMUM_CLUTTER_LINES];
+} scenarioSettingsType;
+
+#define SCENARIO_SETTINGS_DEFAULTS										\
+{																		\
+	1,							/* seed */								\
+	30.0,						/* mountAngle */						\
+	24.0,						/* beamwidth */							\
+	72.083,						/* hzPerMph */							\
+	4,							/* numberOfVehicles */					\
+	300.0,						/* roadLength */						\
+	25.0, 75.0,					/* minimumSpeed, maximumSpeed */		\
+	2.0, 20.0,					/* minimumRcs, maximumRcs */			\
+	2,							/* numberOfLanes */						\
+	{6.0, 9.5, 0.0, 0.0},		/* laneOffset */						\
+	50000.0,					/* amplitude */							\
+	20.0,						/* noiseFloor */						\
+	1,							/* numberOfClutterLines */				\
+	{120.0, 0.0, 0.0, 0.0},		/* clutterHz */							\
+	{200.0, 0.0, 0.0, 0.0},		/* clutterAmplitude */					\
+}
+
+typedef struct {
+	float x;									// Metres past the radar, negative approaching
+	float speed;								// Metres per second
+	float rcs;
+	float laneOffset;
+} scenarioVehicleType;
+
+typedef struct {
+	scenarioSettingsType settings;
+	U32 random;
+	float framePeriod;							// Seconds
+	float hzPerBin;
+	float beamAxis;								// Radians, negative towards the approaching traffic
+	U32 frames;
+	U32 vehiclesPassed;
+	scenarioVehicleType vehicle[SCENARIO_MAXIMUM_VEHICLES];
+} trafficScenarioType;
+
+extern void scenarioOpen(trafficScenarioType *, const scenarioSettingsType *, const fftAnalyzerType *);
+extern void scenarioFrame(trafficScenarioType *, uint16_t *, int);
+
+#endif   /* #ifndef TRAFFIC_SCENARIO_H */
+
+/*********************************** End of File ******************************************************/